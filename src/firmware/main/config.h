@@ -69,6 +69,161 @@
 #define CHANGE_THRESHOLD       8.0f      // 8% diferença mínima para mudança
 #define ALERT_THRESHOLD        15.0f     // 15% diferença para alerta crítico
 
+// =====================================================
+// PLANO DE LUMINÂNCIA REDUZIDO (DECODIFICAÇÃO ÚNICA)
+// =====================================================
+#define COMPARE_SCALE_SHIFT    1         // JPEG decodificado em 1/2 escala (240x160)
+#define COMPARE_BLOCK_SIZE     16        // Blocos 16x16 no plano reduzido (= 32x32 em HVGA)
+#define COMPARE_MAX_BATCH      8         // Máximo de referências comparadas em um lote
+#define COMPARE_LEGACY_METRIC  true      // calculate_image_difference(): blocos 32x32 amostrados a cada 6 px na resolução cheia (false = plano reduzido)
+#define COMPARE_DEFAULT_ENGINE 0         // Engine inicial: 0=SAD, 1=SSIM, 2=GRADIENTE (chave NVS compare/engine sobrescreve no boot)
+#define ENABLE_COMPARE_BENCHMARK false   // Benchmark de custo do lote na primeira comparação
+#define GAIN_AWARE_THRESHOLDS  true      // Escalar piso de ruído/limiares pelo ganho do sensor (noise_gain_table.h)
+
+// =====================================================
+// MÁSCARA APRENDIDA DE REGIÕES RUIDOSAS
+// =====================================================
+#define NUISANCE_MASK_ENABLED    true    // Ignorar blocos que mudam em quase toda captura (árvores, água)
+#define NUISANCE_WINDOW_SHIFT    8       // Janela da média móvel: 2^8 = 256 capturas (~1 h a 15 s)
+#define NUISANCE_RATE_CEILING    60      // % de capturas com mudança para mascarar o bloco
+#define NUISANCE_RATE_RELEASE    25      // % abaixo do qual o bloco volta a ser analisado (histerese)
+#define NUISANCE_MAX_MASKED_PCT  40      // Máximo da grade que pode ficar mascarado
+#define NUISANCE_SAVE_INTERVAL   240     // Capturas entre gravações na NVS (~1 h)
+#define NUISANCE_PUBLISH_INTERVAL 240    // Capturas entre publicações da máscara via MQTT
+
+// =====================================================
+// OBSTRUÇÃO DA LENTE (GOTAS DE CHUVA / EMBAÇAMENTO)
+// =====================================================
+#define LENS_CHECK_ENABLED       true    // Nitidez por bloco (variância do Laplaciano) contra linha de base
+#define LENS_SOFT_PERCENT        40      // Nitidez abaixo de 40% da linha de base = bloco obstruído
+#define LENS_OBSTRUCTED_PERCENT  20      // % de blocos obstruídos para status "lens_obstructed"
+#define LENS_BASELINE_SHIFT      5       // Linha de base: média móvel de ~2^5 = 32 capturas
+#define LENS_WARMUP_CAPTURES     20      // Capturas antes de classificar blocos
+#define LENS_REBASELINE_CAPTURES 240     // Perda de nitidez contínua por ~1 h vira nova linha de base
+
+// =====================================================
+// NÍVEL DA ÁGUA NA COLUNA DE MEDIÇÃO (OPCIONAL)
+// =====================================================
+#define WATER_LEVEL_ENABLED      false   // Estimar a linha d'água e publicar telemetria de nível
+#define WATER_LEVEL_ONLY_MODE    false   // Enviar imagens apenas em grandes variações de nível (e alertas)
+#define WATER_COLUMN_X           240     // Centro da coluna de medição (pixels HVGA)
+#define WATER_COLUMN_WIDTH       48      // Largura da coluna (pixels HVGA)
+#define WATER_COLUMN_TOP         40      // Topo da coluna = nível 100% (pixels HVGA)
+#define WATER_COLUMN_BOTTOM      300     // Base da coluna = nível 0% (pixels HVGA)
+#define WATER_LEVEL_MIN_CONFIDENCE 0.35f // Confiança mínima para atualizar o nível
+#define WATER_LEVEL_SMOOTHING    0.3f    // Peso de cada medição na suavização (x confiança)
+#define WATER_LEVEL_IMAGE_DELTA  5.0f    // Variação de nível (% da coluna) que exige imagem
+
+// =====================================================
+// HASH PERCEPTUAL (DEDUPLICAÇÃO)
+// =====================================================
+#define PHASH_ENABLED            true    // pHash DCT de 64 bits por captura (enviado nos payloads)
+#define PHASH_SKIP_DUPLICATES    true    // Não reenviar frames iguais a um enviado recentemente
+#define PHASH_DUPLICATE_DISTANCE 4       // Distância de Hamming máxima para considerar duplicata
+#define PHASH_RECENT_COUNT       8       // Hashes de imagens enviadas mantidos para comparação
+
+// =====================================================
+// SÉRIE TEMPORAL DAS DIFERENÇAS (JANELA LONGA)
+// =====================================================
+#define TIME_SERIES_ENABLED      true    // Média/variância/tendência incrementais das diferenças
+#define TIME_SERIES_WINDOW       1440    // Amostras na janela deslizante (6 h a 15 s, 4 bytes cada)
+
+// =====================================================
+// RELÓGIO (SNTP) E ILUMINAÇÃO MEDIDA
+// =====================================================
+#define TIME_SYNC_ENABLED        true    // Timestamps em época Unix após a sincronização
+#define TIME_SYNC_SERVER         "pool.ntp.org"
+#define TIME_SYNC_TIMEZONE       "<-03>3" // Horário de Brasília (POSIX TZ)
+#define LIGHT_LEVEL_ENABLED      true    // Dia/crepúsculo/noite pela luz medida (não pelo relógio)
+#define LIGHT_EV_OFFSET          10.0f   // Desloca o índice para valores positivos (dia ~9, noite ~1)
+#define LIGHT_NOMINAL_EXPOSURE_EV 7.6f   // log2(exposição x ganho) assumido sem leitura do sensor
+#define LIGHT_DAY_EV             7.0f    // Índice mínimo para "dia"
+#define LIGHT_NIGHT_EV           3.5f    // Índice abaixo do qual é "noite"
+#define LIGHT_HYSTERESIS_EV      0.5f    // Folga para sair do período atual
+#define LIGHT_CONFIRM_CAPTURES   3       // Capturas consecutivas para confirmar a troca
+
+// =====================================================
+// ESTIMATIVA DE TEMPO (LIMPO, ENCOBERTO, CHUVA/NEBLINA, NOITE)
+// =====================================================
+#define WEATHER_ENABLED          true    // Contraste, canal escuro, saturação e nitidez do decode atual
+#define WEATHER_SAMPLE_STEP      2       // Amostrar 1 a cada 2 pixels em cada direção
+#define WEATHER_NIGHT_LUMA       40.0f   // Luminância média de noite quando o período medido é desconhecido
+#define WEATHER_FOG_HAZE         0.75f   // Canal escuro / luminância a partir do qual há véu (neblina)
+#define WEATHER_FOG_CONTRAST     20.0f   // Contraste (desvio padrão) abaixo do qual o véu indica neblina
+#define WEATHER_SHARP_EDGE       20      // Densidade de bordas (0-255) de um bloco nítido
+#define WEATHER_FOG_SHARP        0.10f   // Fração mínima de blocos nítidos fora de chuva/neblina
+#define WEATHER_OVERCAST_SATURATION 0.12f // Saturação média abaixo da qual o céu está encoberto
+#define WEATHER_OVERCAST_CONTRAST 28.0f  // Contraste abaixo do qual a luz é difusa (encoberto)
+#define WEATHER_CONFIRM_CAPTURES 3       // Capturas consecutivas para confirmar a troca
+#define WEATHER_RAIN_FOG_SCALE   1.5f    // Limiares de mudança/alerta x1.5 com chuva ou neblina
+#define WEATHER_NIGHT_SCALE      1.25f   // Limiares x1.25 à noite (ruído de ganho alto)
+
+// =====================================================
+// CLIPE PRÉ-ALERTA (ÚLTIMAS CAPTURAS ANTES DO ALERTA)
+// =====================================================
+#define EVENT_CLIP_ENABLED       true    // Enviar as capturas que antecederam cada alerta
+#define EVENT_CLIP_FRAMES        6       // Entradas do histórico no clipe (1,5 min a 15 s; completas ou miniaturas)
+#define EVENT_CLIP_PACE_MS       500     // Intervalo entre frames publicados do clipe
+#define EVENT_CLIP_TASK_PRIORITY 3       // Abaixo dos estágios do pipeline (4-5)
+
+// =====================================================
+// PIPELINE CAPTURA -> ANÁLISE -> PUBLICAÇÃO
+// =====================================================
+#define PIPELINE_ANALYZE_QUEUE   2       // Capturas aguardando análise (cheia: descarta a mais antiga)
+#define PIPELINE_PUBLISH_QUEUE   3       // Resultados aguardando envio (cheia: descarta o novo; alertas descartam o não alerta mais antigo)
+#define PIPELINE_URGENT_WAIT_MS  10000   // Fila de envio só com alertas: espera do novo alerta antes de descartar o mais antigo
+#define PIPELINE_CAPTURE_PRIORITY 5      // Captura no ritmo de CAPTURE_INTERVAL_MS, independente dos demais
+#define PIPELINE_ANALYZE_PRIORITY 4
+#define PIPELINE_PUBLISH_PRIORITY 4
+#define PIPELINE_CAPTURE_STACK   4096
+#define PIPELINE_ANALYZE_STACK   8192    // Mesma pilha da antiga tarefa de monitoramento
+#define PIPELINE_PUBLISH_STACK   6144
+#define PIPELINE_POOL_FRAMES     (PIPELINE_ANALYZE_QUEUE + PIPELINE_PUBLISH_QUEUE + 1) // Frames em fila + envio em andamento
+
+// =====================================================
+// QUANTIS DAS DIFERENÇAS (DETECÇÃO DE ANOMALIA ROBUSTA)
+// =====================================================
+#define ROBUST_STATS_ENABLED     true    // Mediana/p95/p99/MAD por estimadores P² (memória fixa)
+#define ROBUST_STATS_WARMUP      240     // Capturas antes de decidir anomalias (1 h a 15 s)
+#define ROBUST_ANOMALY_Z         5.0f    // Desvios robustos acima da mediana (além do p99)
+#define ROBUST_MAD_FLOOR         0.5f    // Escala mínima (%) para cenas quase paradas
+
+// =====================================================
+// ASSINATURAS COMPACTAS POR FRAME (HISTÓRICO DE 24 H)
+// =====================================================
+#define FRAME_SIGNATURE_ENABLED  true    // Média de luminância por bloco de cada captura (150 bytes)
+#define FRAME_SIGNATURE_CAPACITY 5760    // Assinaturas no anel da PSRAM (24 h a 15 s)
+#define FRAME_SIGNATURE_CHROMA   false   // +150 bytes/captura: Cb/Cr médios por bloco (4 bits cada)
+#define FRAME_SIGNATURE_MATCH_S  600     // Tolerância ao buscar "mesmo horário" no passado (segundos)
+#define FRAME_SIGNATURE_DELTA    12      // Diferença de luminância média por bloco considerada mudança
+
+// =====================================================
+// BANCO DE REFERÊNCIAS POR SIMILARIDADE
+// =====================================================
+#define REFERENCE_BANK_ENABLED   true    // Escolher a referência pela assinatura mais parecida (não pelo relógio)
+#define REFERENCE_MATCH_DISTANCE 10.0f   // Distância de assinatura até a qual a cena é a mesma da entrada
+#define REFERENCE_SWITCH_MARGIN  2.0f    // Vantagem mínima para trocar a referência ativa (evita oscilação)
+#define REFERENCE_SHORTLIST      3       // Clusters de assinatura próxima desempatados em um lote pixel a pixel
+#define REFERENCE_SHORTLIST_MARGIN 6.0f  // Distância de assinatura além da mais próxima para entrar no lote
+#define REFERENCE_SCORE_MARGIN   2.0f    // Mudança (%) a menos que o candidato do lote precisa para trocar a ativa
+#define REFERENCE_WEATHER_PENALTY 4.0f   // Distância somada a clusters de outra condição de tempo
+#define REFERENCE_BANK_SIZE      6       // Cenas (clusters) desejadas: seco/molhado, refletor, neblina...
+#define REFERENCE_BANK_MAX_KB    768     // Teto de memória do banco (slot JPEG + plano reduzido por cena)
+#define REFERENCE_CLUSTER_MAX_WEIGHT 32  // Centroide aprende ao menos 1/32 de cada captura da cena
+#define REFERENCE_CLUSTER_DECAY_AT 2880  // Uso recente é dividido por 2 ao atingir este valor (12 h a 15 s)
+#define REFERENCE_BANK_REPORT_INTERVAL 40 // Capturas entre publicações dos clusters via MQTT (10 min a 15 s)
+#define REFERENCE_ENTRY_BYTES    (MAX_IMAGE_SIZE + (IMAGE_WIDTH >> COMPARE_SCALE_SHIFT) * (IMAGE_HEIGHT >> COMPARE_SCALE_SHIFT))
+#define REFERENCE_BANK_ENTRIES   ((REFERENCE_BANK_SIZE * REFERENCE_ENTRY_BYTES <= REFERENCE_BANK_MAX_KB * 1024) ? \
+                                  REFERENCE_BANK_SIZE : (REFERENCE_BANK_MAX_KB * 1024 / REFERENCE_ENTRY_BYTES))
+
+// =====================================================
+// PERSISTÊNCIA DO ESTADO NA FLASH (PARTIÇÃO "storage")
+// =====================================================
+#define STATE_STORE_ENABLED      true    // Restaurar referência e estado do detector após reinicialização
+#define STATE_STORE_BASE_PATH    "/storage" // Ponto de montagem do SPIFFS
+#define STATE_SAVE_INTERVAL_S    900     // Intervalo mínimo entre gravações de contadores/linha de base
+#define STATE_REFERENCE_MIN_S    1800    // Intervalo mínimo entre gravações do JPEG de referência
+
 // =====================================================
 // DETECÇÃO INTELIGENTE AVANÇADA (VERSÃO PRINCIPAL)
 // =====================================================
@@ -91,8 +246,14 @@
 // ANÁLISE AVANÇADA COM PSRAM
 // =====================================================
 #define ENABLE_HISTORY_BUFFER  true      // Buffer de histórico para análise temporal
-#define HISTORY_BUFFER_SIZE    3         // Número de imagens no histórico (otimizado)
+#define HISTORY_BUFFER_SIZE    3         // Entradas mais recentes com frame em resolução total (mínimo 3)
+#define HISTORY_THUMBNAILS_ENABLED true  // Entradas mais antigas mantidas só como miniatura JPEG
+#define HISTORY_THUMB_SCALE_SHIFT 3      // Miniatura em 1/8 da resolução (60x40); 2 = 1/4 (120x80)
+#define HISTORY_THUMB_QUALITY  50        // Qualidade JPEG da miniatura (tons de cinza)
+#define HISTORY_THUMB_SLOT_SIZE 1536     // Bytes reservados por miniatura (1/4 de escala: ~4096)
+#define HISTORY_EVENT_FRAMES   2         // Entradas de alerta que mantêm resolução total fora da janela recente
 #define ENABLE_ADVANCED_ANALYSIS false   // Análise avançada desabilitada (não necessária)
+#define THREE_FRAME_BLOCK_THRESHOLD 20  // Diferença média por bloco entre frames consecutivos
 
 // =====================================================
 // CONFIGURAÇÕES DE MQTT E TÓPICOS
@@ -102,6 +263,14 @@
 #define MQTT_TOPIC_ALERT       "alert"    // Tópico para alertas
 #define MQTT_TOPIC_STATUS      "status"   // Tópico para status
 #define MQTT_TOPIC_IMAGE       "image"    // Tópico para imagens
+#define MQTT_TOPIC_NUISANCE    "nuisance" // Tópico para a máscara de regiões ruidosas
+#define MQTT_TOPIC_LENS        "lens"     // Tópico para o status de obstrução da lente
+#define MQTT_TOPIC_LEVEL       "level"    // Tópico para a telemetria de nível da água
+#define MQTT_TOPIC_MEMORY      "memory"   // Tópico para a contabilidade de memória por subsistema
+#define MQTT_TOPIC_CLIP        "clip"     // Tópico para os frames do clipe pré-alerta
+#define MQTT_TOPIC_SCENES      "scenes"   // Tópico para os clusters de cena do banco de referências
+#define MQTT_TOPIC_ROLLUP      "rollup"   // Tópico base dos agregados (rollup/1m, rollup/1h, rollup/1d)
+#define MQTT_TOPIC_PIPELINE    "pipeline" // Tópico para profundidade e descartes das filas do pipeline
 
 // =====================================================
 // MONITORAMENTO DE REDE (WIFI SNIFFER)
@@ -115,5 +284,20 @@
 // =====================================================
 #define MAX_IMAGE_SIZE        71680      // 70KB máximo por imagem HVGA
 #define HISTORY_BUFFER_TOTAL  (MAX_IMAGE_SIZE * HISTORY_BUFFER_SIZE)  // ~210KB para histórico
+#define HISTORY_THUMB_BUDGET_KB 192      // PSRAM das miniaturas do histórico
+#define HISTORY_DEPTH         (HISTORY_THUMBNAILS_ENABLED ? (HISTORY_THUMB_BUDGET_KB * 1024 / HISTORY_THUMB_SLOT_SIZE) : HISTORY_BUFFER_SIZE) // 128 entradas com 1/8
+#define HISTORY_FULL_FRAMES   (HISTORY_BUFFER_SIZE + (HISTORY_THUMBNAILS_ENABLED ? HISTORY_EVENT_FRAMES : 0)) // Frames completos retidos pelo histórico
+#define FRAME_POOL_FRAMES     HISTORY_FULL_FRAMES // Recentes + eventos retidos (o clipe reutiliza os do histórico)
+#define FRAME_POOL_SLOTS      (FRAME_POOL_FRAMES + REFERENCE_BANK_ENTRIES + 3 + PIPELINE_POOL_FRAMES) // Histórico/clipe + banco + referência + captura atual + clipe em envio + pipeline
+#define MEM_REPORT_INTERVAL   40         // Capturas entre relatórios de memória via MQTT (10 min a 15 s)
+#define PLANE_CACHE_BUDGET_KB 512        // Planos reduzidos decodificados em cache (LRU, ~37 KB cada)
+#define PLANE_CACHE_MAX_ENTRIES 16       // Limite de entradas independente do orçamento
+
+// =====================================================
+// AGREGADOS DE TELEMETRIA (1 MIN / 1 H / 1 DIA)
+// =====================================================
+#define TELEMETRY_ROLLUP_ENABLED  true   // Mín/máx/média/contagem por janela, publicados ao fechar cada janela
+#define TELEMETRY_ROLLUP_MINUTE   true   // Publicar também as janelas de 1 minuto
+#define TELEMETRY_ROLLUP_ONLY     false  // Só agregados: sem monitoring/data e status a cada captura
 
 #endif // CONFIG_H 
\ No newline at end of file
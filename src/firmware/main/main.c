@@ -34,6 +34,7 @@
 #include "model/init_hw.h"
 #include "model/wifi_sniffer.h"
 #include "model/chip_info.h"
+#include "model/time_sync.h"
 #include "config.h"
 
 static const char *TAG = "IMG_MONITOR_SIMPLE";
@@ -279,6 +280,11 @@ void app_main(void)
     esp_netif_create_default_wifi_sta();
     wifi_init_sta();
     
+    // Relógio de parede para timestamps e para o perfil diurno/noturno
+    if (TIME_SYNC_ENABLED && time_sync_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️  SNTP desabilitado - timestamps em uptime");
+    }
+    
     ESP_LOGI(TAG, "📡 Conectando MQTT...");
     mqtt_init();
     ESP_ERROR_CHECK(esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL));
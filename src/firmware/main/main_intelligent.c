@@ -8,6 +8,7 @@
  * - Sistema de referência estática para estabilidade
  * - Economia de dados ~90% vs versão simples
  * - WiFi sniffer para monitoramento de tráfego
+ * - Estágios de captura, análise e publicação ligados por filas limitadas
  * 
  * @version 2.0 - Versão inteligente principal
  * @author Gabriel Passos - UNESP 2025
@@ -15,8 +16,10 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include <time.h>
 #include <inttypes.h>
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
@@ -37,6 +40,23 @@
 #include "model/wifi_sniffer.h"
 #include "model/chip_info.h"
 #include "model/compare.h"
+#include "model/advanced_analysis.h"
+#include "model/lens_check.h"
+#include "model/water_level.h"
+#include "model/phash.h"
+#include "model/frame_handle.h"
+#include "model/time_series.h"
+#include "model/frame_signature.h"
+#include "model/state_store.h"
+#include "model/robust_stats.h"
+#include "model/mem_account.h"
+#include "model/event_clip.h"
+#include "model/time_sync.h"
+#include "model/light_level.h"
+#include "model/weather.h"
+#include "model/telemetry_rollup.h"
+#include "model/plane_cache.h"
+#include "model/pipeline.h"
 #include "config.h"
 
 static const char *TAG = "IMG_MONITOR_INTELLIGENT";
@@ -74,16 +94,61 @@ static camera_config_t camera_config = {
 static uint32_t total_bytes_sent = 0;
 static uint32_t total_photos_sent = 0;
 static uint32_t total_photos_captured = 0;
+static atomic_uint captures_dropped = 0;     // Capturas sem vaga no pool (buffer devolvido ao driver)
 static uint32_t capture_count = 0;
-static camera_fb_t *reference_frame = NULL;
+static frame_handle_t *reference_frame = NULL; // Frame compartilhado com o histórico
+static luma_plane_t reference_plane = {0};   // Referência decodificada em cache
+static luma_plane_t current_plane = {0};     // Frame atual (buffer reutilizado)
 static uint32_t reference_count = 0;
 static float last_difference = 0.0f;
+static bool history_enabled = false;         // Análise avançada inicializada
+static compare_result_t compare_result;      // Mapa por bloco da última comparação
+static lens_status_t lens_status;            // Obstrução da lente no frame atual
+static bool lens_reported_obstructed = false;
+static float last_image_level = -1.0f;       // Nível da água na última imagem enviada
+static frame_signature_t current_signature;  // Assinatura compacta da captura atual
+static signature_match_t day_match;          // Comparação com o mesmo horário do dia anterior
+static int bank_reference_index = -1;        // Entrada do banco usada como referência ativa
+static uint32_t reference_generation = 0;    // Muda a cada troca da referência ativa (persistência)
+static bool state_store_ready = false;       // Partição de estado montada
+static uint32_t boot_count = 0;              // Reinicializações com estado restaurado
+static uint32_t alert_count = 0;             // Identificador sequencial dos alertas (clipes)
+static atomic_int wanted_light = LIGHT_UNKNOWN; // Perfil pedido pela análise (aplicado pela captura)
 
 // Configurações de detecção
 #define CHANGE_THRESHOLD 8.0f        // 8% mudança mínima
 #define ALERT_THRESHOLD 15.0f        // 15% alerta crítico
 #define REFERENCE_UPDATE_INTERVAL 20 // Atualizar referência a cada 20 capturas
 
+// Captura entregue à análise (o buffer do driver volta à câmera após a cópia)
+typedef struct {
+    frame_handle_t *frame;          // Cópia da captura no pool
+    camera_exposure_t exposure;     // Ganho/exposição lidos logo após a captura
+} capture_job_t;
+
+// Decisão da análise entregue à publicação
+typedef struct {
+    frame_handle_t *frame;          // Imagem a enviar (NULL = só telemetria)
+    const char *reason;
+    float difference;
+    uint32_t alert_id;              // 0 = sem alerta
+    uint32_t image_size;
+    uint16_t width;
+    uint16_t height;
+    uint8_t format;
+    mqtt_frame_info_t info;
+    mqtt_status_info_t status;      // Quantis no momento da análise
+    water_level_t level;            // Nível da água medido (valid = false sem medição)
+    bool rollup_only;               // Só janelas de agregação fechadas (sem dados da captura)
+    int rollup_count;
+    rollup_bucket_t rollups[ROLLUP_SCALE_COUNT];
+} publish_job_t;
+
+static pipeline_queue_t analyze_queue;       // Captura -> análise
+static pipeline_queue_t publish_queue;       // Análise -> publicação
+static pipeline_queue_t *const pipeline_queues[] = { &analyze_queue, &publish_queue };
+#define PIPELINE_QUEUE_COUNT (sizeof(pipeline_queues) / sizeof(pipeline_queues[0]))
+
 // Handler de eventos MQTT
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, 
                               int32_t event_id, void *event_data)
@@ -113,37 +178,152 @@ static esp_err_t init_camera(void)
     return err;
 }
 
-// Atualizar frame de referência
-static void update_reference_frame(camera_fb_t *fb)
+// Devolver os recursos de um job descartado pela fila ou já concluído
+static void release_capture_job(void *item)
 {
-    if (reference_frame) {
-        esp_camera_fb_return(reference_frame);
-        reference_frame = NULL;
+    capture_job_t *job = (capture_job_t *)item;
+    frame_handle_release(job->frame);
+    job->frame = NULL;
+}
+
+static void release_publish_job(void *item)
+{
+    publish_job_t *job = (publish_job_t *)item;
+    frame_handle_release(job->frame);
+    job->frame = NULL;
+}
+
+// Alertas e agregados fechados não cedem a vaga a outro envio urgente na fila de publicação
+static bool publish_job_is_urgent(const void *item)
+{
+    const publish_job_t *job = (const publish_job_t *)item;
+    return job->alert_id != 0 || job->rollup_count > 0;
+}
+
+// Atualizar frame de referência (retém o handle compartilhado, sem nova cópia)
+static bool update_reference_frame(frame_handle_t *frame)
+{
+    if (!frame) {
+        ESP_LOGE(TAG, "❌ Frame indisponível no pool - referência mantida");
+        return false;
     }
     
-    // Alocar e copiar novo frame de referência
-    reference_frame = (camera_fb_t*)heap_caps_malloc(sizeof(camera_fb_t), MALLOC_CAP_SPIRAM);
-    if (reference_frame) {
-        memcpy(reference_frame, fb, sizeof(camera_fb_t));
-        
-        // Alocar e copiar buffer de imagem
-        reference_frame->buf = (uint8_t*)heap_caps_malloc(fb->len, MALLOC_CAP_SPIRAM);
-        if (reference_frame->buf) {
-            memcpy(reference_frame->buf, fb->buf, fb->len);
-            reference_count++;
-            ESP_LOGI(TAG, "📸 Referência atualizada #%" PRIu32 " (%zu bytes)", (uint32_t)reference_count, fb->len);
-        } else {
-            free(reference_frame);
-            reference_frame = NULL;
-            ESP_LOGE(TAG, "❌ Falha ao alocar buffer de referência");
+    frame_handle_release(reference_frame);
+    reference_frame = frame_handle_retain(frame);
+    reference_count++;
+    reference_generation++;
+    ESP_LOGI(TAG, "📸 Referência atualizada #%" PRIu32 " (%zu bytes)",
+             (uint32_t)reference_count, frame_handle_fb(frame)->len);
+    return true;
+}
+
+// Trocar a referência ativa pela entrada do banco mais parecida com a captura
+static void select_bank_reference(void)
+{
+    float distance;
+    int index = select_similar_reference(&current_signature, current_plane.pixels ? &current_plane : NULL, &distance);
+    reference_entry_t *entry = get_reference_entry(index);
+    if (!entry || index == bank_reference_index) {
+        return;
+    }
+    
+    frame_handle_release(reference_frame);
+    reference_frame = frame_handle_retain(entry->frame);
+    luma_plane_t *plane = plane_cache_get(entry->frame);
+    if (!plane || compare_copy_luma(plane, &reference_plane) != ESP_OK) {
+        compare_free_luma(&reference_plane);
+    }
+    bank_reference_index = index;
+    reference_generation++;
+    ESP_LOGI(TAG, "🧠 Referência #%d do banco ativa (distância de assinatura %.1f)", index, distance);
+}
+
+// Gravar a nova referência no banco (renova a cena parecida ou cria outra)
+static void store_bank_reference(frame_handle_t *frame, bool plane_ok)
+{
+    int index = update_multi_references(frame, plane_ok ? &current_plane : NULL, &current_signature);
+    if (index >= 0) {
+        bank_reference_index = index;
+    }
+}
+
+// Sincronizar plano em cache com a referência recém-atualizada
+static void sync_reference_plane(bool plane_ok)
+{
+    if (!plane_ok || compare_copy_luma(&current_plane, &reference_plane) != ESP_OK) {
+        // Sem plano válido: comparação volta a decodificar a referência
+        compare_free_luma(&reference_plane);
+    }
+}
+
+// Contadores atuais no formato persistido
+static detector_counters_t collect_counters(void)
+{
+    detector_counters_t counters = {
+        .capture_count = capture_count,
+        .reference_count = reference_count,
+        .photos_captured = total_photos_captured,
+        .photos_sent = total_photos_sent,
+        .bytes_sent = total_bytes_sent,
+        .boot_count = boot_count,
+    };
+    return counters;
+}
+
+// Restaurar contadores e referência salvos antes da reinicialização
+static void restore_detector_state(void)
+{
+    detector_counters_t counters;
+    frame_handle_t *saved_reference = NULL;
+    if (state_store_load(&counters, &saved_reference) != ESP_OK) {
+        return;
+    }
+    
+    capture_count = counters.capture_count;
+    reference_count = counters.reference_count;
+    total_photos_captured = counters.photos_captured;
+    total_photos_sent = counters.photos_sent;
+    total_bytes_sent = counters.bytes_sent;
+    boot_count = counters.boot_count;
+    
+    if (saved_reference) {
+        // Handle já vem com a referência do chamador: vira a referência ativa
+        reference_frame = saved_reference;
+        if (compare_decode_luma_only(frame_handle_fb(reference_frame), &reference_plane) != ESP_OK) {
+            compare_free_luma(&reference_plane);
         }
-    } else {
-        ESP_LOGE(TAG, "❌ Falha ao alocar frame de referência");
+        ESP_LOGI(TAG, "♻️ Detecção retomada com a referência salva (%zu bytes)",
+                 frame_handle_fb(reference_frame)->len);
+    }
+}
+
+// Semear o banco com a referência restaurada (assinatura recalculada do plano)
+static void seed_bank_with_restored_reference(void)
+{
+    static frame_signature_t signature;
+    if (!reference_frame || !reference_plane.pixels ||
+        frame_signature_compute(&reference_plane, &signature) != ESP_OK) {
+        return;
+    }
+    int index = update_multi_references(reference_frame, &reference_plane, &signature);
+    if (index >= 0) {
+        bank_reference_index = index;
     }
 }
 
+// Publicar a máscara de regiões ruidosas para revisão dos operadores
+static void publish_nuisance_mask(void)
+{
+    static uint8_t rates[COMPARE_MAX_BLOCKS];
+    static uint8_t masked[COMPARE_MAX_BLOCKS];
+    
+    compare_nuisance_get(rates, masked, COMPARE_MAX_BLOCKS);
+    mqtt_send_nuisance_mask(rates, masked, COMPARE_BLOCKS_X, COMPARE_BLOCKS_Y);
+}
+
 // Enviar imagem via MQTT
-static void send_image_via_mqtt(camera_fb_t *fb, const char* reason, float difference)
+static void send_image_via_mqtt(camera_fb_t *fb, const char* reason, float difference,
+                                const mqtt_frame_info_t* info)
 {
     if (!fb) {
         ESP_LOGW(TAG, "Frame inválido, não é possível enviar imagem");
@@ -156,7 +336,7 @@ static void send_image_via_mqtt(camera_fb_t *fb, const char* reason, float diffe
     
     char topic[128];
     snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_IMAGE);
-    esp_err_t err = mqtt_send_image_with_info(fb, topic, reason, difference);
+    esp_err_t err = mqtt_send_image_with_info_ext(fb, topic, reason, difference, info);
     
     if (err == ESP_OK) {
         total_bytes_sent += fb->len;
@@ -171,116 +351,549 @@ static void send_image_via_mqtt(camera_fb_t *fb, const char* reason, float diffe
     }
 }
 
-// Capturar e analisar foto (versão inteligente)
-static void capture_and_analyze_photo(void)
+// Quantis das diferenças no momento da análise (lidos só pelo estágio de análise)
+static mqtt_status_info_t collect_status_info(void)
 {
-    ESP_LOGI(TAG, "📸 Capturando foto...");
-    
-    // Aplicar configurações adaptativas por horário periodicamente
-    if (capture_count % 10 == 0) {
-        apply_time_based_settings();
+    mqtt_status_info_t status_info = {0};
+    robust_stats_t quantiles;
+    if (ROBUST_STATS_ENABLED && robust_stats_get(&quantiles) == ESP_OK) {
+        status_info.has_quantiles = true;
+        status_info.samples = quantiles.count;
+        status_info.median = quantiles.median;
+        status_info.p95 = quantiles.p95;
+        status_info.p99 = quantiles.p99;
+        status_info.mad = quantiles.mad;
     }
+    return status_info;
+}
+
+// Enviar status do sistema (heap, PSRAM, uptime e quantis das diferenças)
+static void send_system_status(const mqtt_status_info_t *status_info)
+{
+    mqtt_send_monitoring_ext(esp_get_free_heap_size(), 
+                             heap_caps_get_free_size(MALLOC_CAP_SPIRAM), 
+                             esp_timer_get_time() / 1000000, status_info);
+}
+
+// Agregar a captura analisada; janelas fechadas seguem para a publicação em um job próprio
+static void aggregate_capture(float difference, uint32_t image_size, bool sent, int64_t captured_us)
+{
+    rollup_sample_t sample = {
+        .difference = difference,
+        .image_size = image_size,
+        .sent = sent,
+        .free_heap = esp_get_free_heap_size(),
+    };
+    sample.has_rssi = (wifi_get_rssi(&sample.rssi) == ESP_OK);
     
-    // Warm-up periódico para evitar tint verde
-    if (capture_count == 0 || (capture_count % 10 == 0)) {
-        ESP_LOGI(TAG, "🔥 Realizando warm-up periódico...");
-        camera_warmup_capture();
-    }
+    static rollup_bucket_t closed[ROLLUP_SCALE_COUNT];
+    static publish_job_t job;
+    int count = telemetry_rollup_add(&sample, time_sync_timestamp_at(captured_us), closed);
     
-    // Usar captura inteligente com correção automática
-    camera_fb_t *fb;
-    if (smart_capture_with_correction(&fb) != ESP_OK) {
-        ESP_LOGE(TAG, "❌ Falha na captura inteligente da câmera");
+    memset(&job, 0, sizeof(job));
+    for (int i = 0; i < count; i++) {
+        if (closed[i].scale == ROLLUP_MINUTE && !TELEMETRY_ROLLUP_MINUTE) {
+            continue;
+        }
+        job.rollups[job.rollup_count++] = closed[i];
+    }
+    if (job.rollup_count == 0) {
         return;
     }
     
+    // Agregados não podem ser perdidos: mesma fila e proteção dos alertas
+    job.rollup_only = true;
+    job.status = collect_status_info();
+    pipeline_queue_push_urgent(&publish_queue, &job, pdMS_TO_TICKS(PIPELINE_URGENT_WAIT_MS));
+}
+
+// Publicar as janelas de agregação fechadas
+static void publish_rollups(const publish_job_t *job)
+{
+    for (int i = 0; i < job->rollup_count; i++) {
+        const rollup_bucket_t *bucket = &job->rollups[i];
+        mqtt_send_rollup(bucket);
+        ESP_LOGI(TAG, "📦 Agregado %s: %" PRIu32 " capturas, diferença média %.1f%%",
+                 telemetry_rollup_scale_name(bucket->scale),
+                 bucket->metrics[ROLLUP_DIFFERENCE].count,
+                 telemetry_rollup_mean(&bucket->metrics[ROLLUP_DIFFERENCE]));
+        
+        // Só agregados: status (heap, quantis) acompanha a janela de 1 hora
+        if (TELEMETRY_ROLLUP_ONLY && bucket->scale == ROLLUP_HOUR) {
+            send_system_status(&job->status);
+        }
+    }
+}
+
+// Analisar uma captura e entregar a decisão ao estágio de publicação
+static void analyze_capture(capture_job_t *job)
+{
+    frame_handle_t *shared = job->frame;   // Cópia da captura no pool (referência + histórico); a referência do job passa a ser local
+    camera_fb_t *fb = frame_handle_fb(shared);
+    job->frame = NULL;
+    
     capture_count++;
-    total_photos_captured++;
-    ESP_LOGI(TAG, "📷 Foto capturada: %zu bytes (%zux%zu)", 
-             fb->len, fb->width, fb->height);
 
     bool should_send = false;
     float difference = 0.0f;
     const char* reason = "unknown";
     
+    // Ganho/exposição do sensor registrados junto ao frame
+    camera_exposure_t exposure = job->exposure;
+    mqtt_frame_info_t frame_info = {
+        .gain_x16 = exposure.gain_x16,
+        .exposure = exposure.exposure,
+        .captured_us = frame_handle_captured_us(shared),
+    };
+    ESP_LOGI(TAG, "🎚️ Ganho %.2fx, exposição %u linhas%s", exposure.gain_x16 / 16.0f,
+             exposure.exposure, exposure.from_registers ? "" : " (estimado)");
+    
+    // Decodificação única do frame atual (reutilizada pela referência)
+    bool plane_ok = (compare_decode_luma(fb, &current_plane) == ESP_OK);
+    current_plane.gain_x16 = exposure.gain_x16;
+    
+    // Assinatura compacta logo após a decodificação (crominância reaproveita o buffer RGB565)
+    bool signature_ok = FRAME_SIGNATURE_ENABLED && plane_ok &&
+                        frame_signature_compute(&current_plane, &current_signature) == ESP_OK;
+    bool bank_ready = REFERENCE_BANK_ENABLED && history_enabled && signature_ok;
+    if (signature_ok) {
+        if (frame_signature_compare_ago(&current_signature, 24 * 3600, &day_match) == ESP_OK && day_match.found) {
+            ESP_LOGD(TAG, "📅 Ontem no mesmo horário: %.1f%% dos blocos mudaram (brilho %+d, %" PRIu32 " us)",
+                     day_match.changed_percent, day_match.brightness_delta, day_match.query_us);
+        }
+        frame_signature_push(&current_signature);
+    }
+    
+    // Iluminação medida (luminância, exposição e ganho), independente do relógio
+    light_status_t light = {0};
+    bool light_ok = LIGHT_LEVEL_ENABLED && plane_ok &&
+                    light_level_update(&current_plane, exposure.gain_x16, exposure.exposure, &light) == ESP_OK;
+    if (light_ok) {
+        frame_info.light = light_level_name(light.period);
+        frame_info.light_ev = light.ev;
+        // O sensor só é acessado pelo estágio de captura (troca de banco SCCB do OV2640)
+        atomic_store(&wanted_light, light.period);
+    }
+    
+    // Condição do tempo pelo mesmo decode (canal escuro, saturação, contraste, nitidez)
+    weather_status_t weather = {0};
+    bool weather_ok = WEATHER_ENABLED && plane_ok &&
+                      weather_update(&current_plane, light_ok ? light.period : LIGHT_UNKNOWN, &weather) == ESP_OK;
+    float threshold_scale = 1.0f;
+    if (weather_ok) {
+        frame_info.weather = weather_condition_name(weather.condition);
+        frame_info.haze = weather.haze;
+        current_signature.weather = (uint8_t)weather.condition;
+        threshold_scale = weather_threshold_scale(weather.condition);
+        ESP_LOGD(TAG, "🌦️ %s: contraste %.1f, véu %.2f, saturação %.2f, nítidos %.0f%% (%" PRIu32 " us)",
+                 frame_info.weather, weather.contrast, weather.haze, weather.saturation,
+                 weather.sharp_fraction * 100.0f, weather.compute_us);
+    }
+    const float change_threshold = CHANGE_THRESHOLD * threshold_scale;
+    const float alert_threshold = ALERT_THRESHOLD * threshold_scale;
+    
+    // Hash perceptual sobre o mesmo plano (deduplicação no servidor e no envio)
+    if (PHASH_ENABLED && plane_ok && phash_compute(&current_plane, &frame_info.phash) == ESP_OK) {
+        frame_info.has_phash = true;
+        ESP_LOGI(TAG, "🔑 pHash: %016llx", (unsigned long long)frame_info.phash);
+    }
+    
+    // Obstrução da lente (gotas/embaçamento) sobre o mesmo plano decodificado
+    bool lens_obstructed = false;
+    if (LENS_CHECK_ENABLED && plane_ok && lens_check_update(&current_plane, &lens_status) == ESP_OK) {
+        compare_set_exclusion_mask(lens_status.occluded_blocks > 0 ? lens_status.occluded : NULL);
+        lens_obstructed = lens_status.obstructed;
+        
+        if (lens_status.occluded_blocks > 0) {
+            ESP_LOGI(TAG, "💧 %d/%d blocos sem nitidez excluídos da comparação (%.1f%%)",
+                     lens_status.occluded_blocks, lens_status.evaluated_blocks, lens_status.occluded_percent);
+        }
+        if (lens_obstructed != lens_reported_obstructed) {
+            mqtt_send_lens_status(lens_obstructed, lens_status.occluded_blocks, lens_status.evaluated_blocks,
+                                  lens_status.occluded_percent, lens_status.occluded,
+                                  COMPARE_BLOCKS_X, COMPARE_BLOCKS_Y);
+            lens_reported_obstructed = lens_obstructed;
+        }
+    } else {
+        compare_set_exclusion_mask(NULL);
+    }
+    
     // Primeira captura sempre é enviada e vira referência
     if (!reference_frame) {
         should_send = true;
         reason = "reference_established";
         difference = 0.0f;
-        update_reference_frame(fb);
+        if (update_reference_frame(shared)) {
+            sync_reference_plane(plane_ok);
+            if (bank_ready) {
+                store_bank_reference(reference_frame, plane_ok);
+            }
+        }
         ESP_LOGI(TAG, "🎯 Primeira captura - estabelecendo referência");
     } else {
-        // Comparar com frame de referência
-        difference = calculate_image_difference(reference_frame, fb);
+        if (ENABLE_COMPARE_BENCHMARK && capture_count == 2) {
+            compare_benchmark_batch(fb);
+        }
+        
+        // Referência da cena mais parecida (amanhecer, anoitecer, chuva) em vez do relógio
+        if (bank_ready) {
+            select_bank_reference();
+        }
+        
+        // Comparar com a referência em cache (sem redecodificar a referência)
+        if (plane_ok && reference_plane.pixels &&
+            compare_luma_planes_ex(&reference_plane, &current_plane, &compare_result) == ESP_OK) {
+            difference = compare_result.difference;
+            
+            // Aprender regiões que mudam em quase toda captura (árvores, água)
+            if (NUISANCE_MASK_ENABLED) {
+                bool mask_changed = compare_nuisance_update(&compare_result);
+                if (mask_changed || capture_count % NUISANCE_PUBLISH_INTERVAL == 0) {
+                    publish_nuisance_mask();
+                }
+                if (compare_result.masked_blocks > 0) {
+                    ESP_LOGI(TAG, "🌳 %d blocos ruidosos ignorados", compare_result.masked_blocks);
+                }
+            }
+        } else {
+            difference = calculate_image_difference(frame_handle_fb(reference_frame), fb);
+        }
         last_difference = difference;
         
         ESP_LOGI(TAG, "🔍 Diferença calculada: %.1f%%", difference);
         
         // Determinar se deve enviar baseado na diferença
-        if (difference >= ALERT_THRESHOLD) {
+        if (difference >= alert_threshold) {
             should_send = true;
             reason = "anomaly_detected";
-            ESP_LOGI(TAG, "🚨 ANOMALIA DETECTADA: %.1f%% (>= %.1f%%)", difference, ALERT_THRESHOLD);
-        } else if (difference >= CHANGE_THRESHOLD) {
+            ESP_LOGI(TAG, "🚨 ANOMALIA DETECTADA: %.1f%% (>= %.1f%%)", difference, alert_threshold);
+        } else if (difference >= change_threshold) {
             should_send = true;
             reason = "significant_change";
-            ESP_LOGI(TAG, "📊 Mudança significativa: %.1f%% (>= %.1f%%)", difference, CHANGE_THRESHOLD);
+            ESP_LOGI(TAG, "📊 Mudança significativa: %.1f%% (>= %.1f%%)", difference, change_threshold);
         } else {
             should_send = false;
             reason = "no_change";
-            ESP_LOGI(TAG, "✅ Sem mudanças significativas: %.1f%% (< %.1f%%)", difference, CHANGE_THRESHOLD);
+            ESP_LOGI(TAG, "✅ Sem mudanças significativas: %.1f%% (< %.1f%%)", difference, change_threshold);
         }
         
-        // Atualizar referência periodicamente ou em grandes mudanças
-        if ((capture_count % REFERENCE_UPDATE_INTERVAL == 0) || (difference >= ALERT_THRESHOLD)) {
-            update_reference_frame(fb);
+        // Abaixo dos limiares fixos, mas atípico para esta câmera (quantis P²)
+        if (ROBUST_STATS_ENABLED && !should_send) {
+            robust_assessment_t assessment;
+            robust_stats_assess(difference, &assessment);
+            if (assessment.anomalous) {
+                should_send = true;
+                reason = "statistical_anomaly";
+                ESP_LOGI(TAG, "📈 Diferença atípica: %.1f%% acima do p99 (%.1f desvios robustos)",
+                         difference, assessment.robust_z);
+            }
+        }
+        
+        // Troca de iluminação: a referência do período anterior geraria envios falsos
+        if (light_ok && light.changed) {
+            should_send = false;
+            reason = "light_transition";
+            ESP_LOGI(TAG, "💡 Envio suprimido: transição para %s, referência renovada", light_level_name(light.period));
+        }
+        
+        // Lente obstruída: poucos blocos restantes inflam o percentual - enviar só anomalias
+        if (lens_obstructed && should_send && difference < alert_threshold) {
+            should_send = false;
+            reason = "lens_obstructed";
+            ESP_LOGI(TAG, "💧 Envio suprimido: lente obstruída (%.1f%% dos blocos)", lens_status.occluded_percent);
+        }
+        
+        // Atualizar referência periodicamente, em grandes mudanças ou na troca de iluminação/tempo.
+        // Só renovações de cena entram no banco: um objeto de passagem (alerta) troca a referência
+        // ativa sem criar cluster; se a mudança persistir, a renovação periódica a registra
+        bool scene_renewal = (capture_count % REFERENCE_UPDATE_INTERVAL == 0) ||
+                             (light_ok && light.changed) || (weather_ok && weather.changed);
+        if (scene_renewal || difference >= alert_threshold) {
+            if (update_reference_frame(shared)) {
+                sync_reference_plane(plane_ok);
+                if (bank_ready && scene_renewal) {
+                    store_bank_reference(reference_frame, plane_ok);
+                }
+            }
             ESP_LOGI(TAG, "🔄 Referência atualizada (ciclo: %" PRIu32 ", diferença: %.1f%%)", 
                      (uint32_t)capture_count, difference);
         }
     }
     
-    // Enviar imagem apenas se necessário
-    if (should_send) {
-        send_image_via_mqtt(fb, reason, difference);
+    // Série temporal longa das diferenças (estatísticas incrementais)
+    if (TIME_SERIES_ENABLED && strcmp(reason, "reference_established") != 0) {
+        time_series_add(difference);
+    }
+    if (ROBUST_STATS_ENABLED && strcmp(reason, "reference_established") != 0 &&
+        strcmp(reason, "light_transition") != 0) {
+        robust_stats_add(difference);
+    }
+    
+    // Nível da água na coluna de medição: telemetria escalar a cada captura (enviada pela publicação)
+    water_level_t level = {0};
+    if (WATER_LEVEL_ENABLED && plane_ok) {
+        if (water_level_update(&current_plane, &level) == ESP_OK && level.valid) {
+            ESP_LOGI(TAG, "🌊 Nível: %.1f%% (bruto %.1f%%, confiança %.2f, %+.2f%%/h)",
+                     level.level_percent, level.raw_percent, level.confidence, level.rate_per_hour);
+            
+            // Modo nível: imagens apenas na primeira captura, em alertas ou em grandes variações
+            if (WATER_LEVEL_ONLY_MODE) {
+                bool level_changed = last_image_level < 0.0f ||
+                                     fabsf(level.level_percent - last_image_level) >= WATER_LEVEL_IMAGE_DELTA;
+                if (level_changed && !lens_obstructed && !should_send) {
+                    should_send = true;
+                    reason = "water_level_change";
+                } else if (!level_changed && should_send && difference < alert_threshold &&
+                           strcmp(reason, "reference_established") != 0) {
+                    should_send = false;
+                    reason = "level_telemetry_only";
+                }
+            }
+        }
+    }
+    
+    // Não reenviar frame praticamente idêntico a um enviado há pouco (exceto alertas, referência,
+    // variação de nível e anomalia estatística: nesses casos a imagem é o registro do evento)
+    if (PHASH_SKIP_DUPLICATES && should_send && frame_info.has_phash &&
+        difference < alert_threshold && strcmp(reason, "reference_established") != 0 &&
+        strcmp(reason, "water_level_change") != 0 && strcmp(reason, "statistical_anomaly") != 0) {
+        int distance = -1;
+        if (phash_recently_sent(frame_info.phash, PHASH_DUPLICATE_DISTANCE, &distance)) {
+            should_send = false;
+            reason = "duplicate_frame";
+            ESP_LOGI(TAG, "♻️ Envio suprimido: frame duplicado (distância pHash %d)", distance);
+        }
+    }
+    
+    // Alerta: capturas anteriores entregues à tarefa do clipe antes de o gatilho entrar no
+    // histórico (o gatilho já segue com o alerta); offsets relativos ao instante da captura
+    uint32_t alert_id = 0;
+    if (should_send && difference >= alert_threshold) {
+        alert_id = ++alert_count;
+        if (EVENT_CLIP_ENABLED && history_enabled &&
+            event_clip_flush(alert_id, difference, frame_handle_captured_us(shared)) == ESP_OK) {
+            ESP_LOGI(TAG, "🎬 Clipe pré-alerta #%" PRIu32 " enfileirado", alert_id);
+        }
+    }
+    
+    // Histórico com plano em cache: diferenciação de três frames sem nova decodificação
+    if (history_enabled) {
+        add_handle_to_history(shared, difference, plane_ok ? &current_plane : NULL);
         
-        // Enviar alerta se for anomalia
-        if (difference >= ALERT_THRESHOLD) {
-            mqtt_send_alert(difference, fb);
+        // Frame do alerta retido no histórico além da janela recente
+        if (alert_id) {
+            mark_history_event();
         }
+        
+        three_frame_result_t motion;
+        if (detect_three_frame_change(&motion) == ESP_OK) {
+            ESP_LOGI(TAG, "🎞️ Três frames: transitório %.1f%% | persistente %.1f%% | início %.1f%%",
+                     motion.transient_percent, motion.persistent_percent, motion.onset_percent);
+        }
+    }
+    
+    // Decisão entregue à publicação: um envio lento não atrasa a próxima análise
+    publish_job_t result = {
+        .reason = reason,
+        .difference = difference,
+        .image_size = fb->len,
+        .width = fb->width,
+        .height = fb->height,
+        .format = fb->format,
+        .info = frame_info,
+        .status = collect_status_info(),
+        .level = level,
+        .alert_id = alert_id,
+    };
+    if (should_send) {
+        // A imagem segue com o job (a referência local passa para a publicação)
+        result.frame = shared;
+        shared = NULL;
     } else {
         ESP_LOGI(TAG, "⏭️  Imagem não enviada (sem mudanças significativas)");
     }
     
-    // Sempre enviar dados de monitoramento (para estatísticas)
-    mqtt_send_monitoring_data(difference, fb->len, fb->width, fb->height, fb->format, DEVICE_ID);
+    // Alertas não podem ser perdidos: com a fila cheia, descartam o envio não urgente mais antigo
+    esp_err_t queued = result.alert_id ?
+        pipeline_queue_push_urgent(&publish_queue, &result, pdMS_TO_TICKS(PIPELINE_URGENT_WAIT_MS)) :
+        pipeline_queue_push(&publish_queue, &result);
+    
+    // Hash e nível da última imagem só contam se a imagem seguiu para o envio
+    bool image_queued = should_send && queued == ESP_OK;
+    if (image_queued) {
+        if (frame_info.has_phash) {
+            phash_remember_sent(frame_info.phash);
+        }
+        if (WATER_LEVEL_ONLY_MODE && level.valid) {
+            last_image_level = level.level_percent;
+        }
+    }
+    
+    // Agregados por minuto/hora/dia com toda captura analisada, mesmo as recusadas pela fila de envio
+    if (TELEMETRY_ROLLUP_ENABLED) {
+        aggregate_capture(difference, result.image_size, image_queued, frame_info.captured_us);
+    }
     
-    // Enviar status do sistema
-    mqtt_send_monitoring(esp_get_free_heap_size(), 
-                        heap_caps_get_free_size(MALLOC_CAP_SPIRAM), 
-                        esp_timer_get_time() / 1000000);
+    // Liberar a referência local da cópia (NULL se a imagem seguiu com o job)
+    frame_handle_release(shared);
+}
+
+// Publicar imagem, alerta e telemetria de uma captura já analisada
+static void publish_result(publish_job_t *job)
+{
+    if (job->rollup_only) {
+        publish_rollups(job);
+        return;
+    }
+    
+    camera_fb_t *fb = job->frame ? frame_handle_fb(job->frame) : NULL;
+    if (job->level.valid) {
+        mqtt_send_water_level(job->level.level_percent, job->level.confidence, job->level.rate_per_hour,
+                              job->info.captured_us);
+    }
+    if (fb) {
+        send_image_via_mqtt(fb, job->reason, job->difference, &job->info);
+        if (job->alert_id) {
+            // Imagem já publicada acima: o alerta vai sem nova cópia
+            mqtt_send_alert_ext(job->difference, NULL, job->alert_id, job->info.captured_us);
+        }
+    }
+    
+    // Dados de monitoramento e status por captura (omitidos no modo só agregados)
+    if (!TELEMETRY_ROLLUP_ONLY) {
+        mqtt_send_monitoring_data_ext(job->difference, job->image_size, job->width, job->height,
+                                      job->format, DEVICE_ID, &job->info);
+        send_system_status(&job->status);
+    }
     
-    // Liberar frame
-    esp_camera_fb_return(fb);
+    release_publish_job(job);
+}
+
+// Profundidade e descartes de cada fila, na ordem do pipeline
+static void collect_pipeline_stats(pipeline_queue_stats_t stats[PIPELINE_QUEUE_COUNT])
+{
+    for (size_t i = 0; i < PIPELINE_QUEUE_COUNT; i++) {
+        pipeline_queue_get_stats(pipeline_queues[i], &stats[i]);
+    }
 }
 
 // Declaração da função de estatísticas
 static void print_statistics(void);
 
-// Task de monitoramento inteligente
-static void monitoring_task(void *pvParameter)
+// Estágio de captura: ritmo de CAPTURE_INTERVAL_MS, independente da análise e do envio
+static void capture_task(void *pvParameter)
 {
-    ESP_LOGI(TAG, "🚀 Task de monitoramento inteligente iniciada");
+    ESP_LOGI(TAG, "🚀 Estágio de captura iniciado");
+    uint32_t captures = 0;
+    light_period_t applied_light = LIGHT_UNKNOWN;   // Perfil do sensor aplicado
     
     while (1) {
-        capture_and_analyze_photo();
+        ESP_LOGI(TAG, "📸 Capturando foto...");
+        
+        // Perfil de iluminação pedido pela análise, aplicado antes da próxima captura
+        light_period_t wanted = (light_period_t)atomic_load(&wanted_light);
+        if (wanted != LIGHT_UNKNOWN && wanted != applied_light) {
+            apply_light_settings(wanted);
+            applied_light = wanted;
+        }
+        
+        // Warm-up periódico para evitar tint verde
+        if (captures % 10 == 0) {
+            ESP_LOGI(TAG, "🔥 Realizando warm-up periódico...");
+            camera_warmup_capture();
+        }
+        
+        // Usar captura inteligente com correção automática
+        camera_fb_t *fb;
+        if (smart_capture_with_correction(&fb) == ESP_OK) {
+            captures++;
+            total_photos_captured++;
+            ESP_LOGI(TAG, "📷 Foto capturada: %zu bytes (%zux%zu)", 
+                     fb->len, fb->width, fb->height);
+            
+            // Cópia no pool devolve o buffer à câmera já. Sem vaga, a captura é
+            // descartada: reter buffers do driver (fb_count = 2) travaria o próximo esp_camera_fb_get()
+            capture_job_t job = {
+                .frame = frame_handle_create(fb),
+                .exposure = camera_get_last_exposure(),
+            };
+            esp_camera_fb_return(fb);
+            
+            if (job.frame) {
+                // Análise atrasada: a captura mais antiga na fila é descartada
+                pipeline_queue_push(&analyze_queue, &job);
+            } else {
+                uint32_t dropped = (uint32_t)atomic_fetch_add(&captures_dropped, 1) + 1;
+                ESP_LOGW(TAG, "⚠️ Pool de frames sem vaga: captura descartada (%" PRIu32 " no total)", dropped);
+            }
+        } else {
+            ESP_LOGE(TAG, "❌ Falha na captura inteligente da câmera");
+        }
+        
+        vTaskDelay(pdMS_TO_TICKS(CAPTURE_INTERVAL_MS));
+    }
+}
+
+// Estágio de publicação: imagens, alertas e telemetria por captura
+static void publish_task(void *pvParameter)
+{
+    ESP_LOGI(TAG, "🚀 Estágio de publicação iniciado");
+    publish_job_t job;
+    
+    while (1) {
+        if (pipeline_queue_pop(&publish_queue, &job, portMAX_DELAY)) {
+            publish_result(&job);
+        }
+    }
+}
+
+// Estágio de análise: decodificação, comparação, referência, histórico e relatórios
+static void analysis_task(void *pvParameter)
+{
+    ESP_LOGI(TAG, "🚀 Estágio de análise inteligente iniciado");
+    capture_job_t job;
+    
+    while (1) {
+        if (!pipeline_queue_pop(&analyze_queue, &job, portMAX_DELAY)) {
+            continue;
+        }
+        analyze_capture(&job);
+        
+        // Persistência limitada por intervalo (a função decide se grava)
+        if (state_store_ready) {
+            detector_counters_t counters = collect_counters();
+            state_store_save(&counters, reference_frame, reference_generation, false);
+        }
         
         // Imprimir estatísticas a cada 10 capturas
         if (capture_count % 10 == 0) {
             print_statistics();
         }
         
-        vTaskDelay(pdMS_TO_TICKS(CAPTURE_INTERVAL_MS));
+        // Memória real por subsistema (regressões entre versões de firmware)
+        if (capture_count % MEM_REPORT_INTERVAL == 0) {
+            static mem_account_report_t mem_report;
+            mem_account_snapshot(&mem_report);
+            mem_account_log();
+            plane_cache_stats_t plane_stats;
+            plane_cache_get_stats(&plane_stats);
+            ESP_LOGI(TAG, "🗂️ Cache de planos: %d/%d, %" PRIu32 " acertos, %" PRIu32 " faltas, %" PRIu32 " despejos",
+                     plane_stats.entries, plane_stats.capacity, plane_stats.hits,
+                     plane_stats.misses, plane_stats.evictions);
+            mqtt_send_memory_status(&mem_report, history_enabled ? &plane_stats : NULL);
+            
+            pipeline_queue_stats_t queues[PIPELINE_QUEUE_COUNT];
+            collect_pipeline_stats(queues);
+            mqtt_send_pipeline_status(queues, PIPELINE_QUEUE_COUNT);
+        }
+        
+        // Regimes de cena vistos pela câmera (membros por cluster do banco)
+        if (REFERENCE_BANK_ENABLED && history_enabled && capture_count % REFERENCE_BANK_REPORT_INTERVAL == 0) {
+            static reference_bank_stats_t bank_stats;
+            if (get_reference_bank_stats(&bank_stats) == ESP_OK) {
+                mqtt_send_reference_bank(&bank_stats);
+            }
+        }
     }
 }
 
@@ -294,9 +907,42 @@ static void print_statistics(void)
     ESP_LOGI(TAG, "📷 Fotos: %" PRIu32 " enviadas / %" PRIu32 " capturadas (%.1f%% taxa de envio)",
              (uint32_t)total_photos_sent, (uint32_t)total_photos_captured, send_ratio);
     ESP_LOGI(TAG, "📡 Dados: %.2f KB transmitidos", total_bytes_sent / 1024.0f);
+    uint32_t dropped = atomic_load(&captures_dropped);
+    if (dropped > 0) {
+        ESP_LOGW(TAG, "⚠️ Capturas descartadas sem vaga no pool: %" PRIu32, dropped);
+    }
     ESP_LOGI(TAG, "📊 Média: %" PRIu32 " bytes/foto", 
              (uint32_t)(total_photos_sent > 0 ? total_bytes_sent / total_photos_sent : 0));
     ESP_LOGI(TAG, "🔍 Última diferença: %.1f%%", last_difference);
+    if (FRAME_SIGNATURE_ENABLED && day_match.found) {
+        ESP_LOGI(TAG, "📅 vs ontem: %.1f%% blocos alterados | Δ médio %.1f | brilho %+d | consulta %" PRIu32 " us (%d assinaturas)",
+                 day_match.changed_percent, day_match.mean_abs_delta, day_match.brightness_delta,
+                 day_match.query_us, frame_signature_count());
+    }
+    time_series_stats_t series;
+    if (TIME_SERIES_ENABLED && time_series_get_stats(&series) == ESP_OK) {
+        ESP_LOGI(TAG, "📉 Janela %.1fh (%d amostras): média %.2f%% ± %.2f | tendência %+.3f%%/h | estabilidade %.2f",
+                 series.window_hours, series.count, series.mean, series.stddev,
+                 series.slope_per_hour, series.stability_index);
+    }
+    robust_stats_t quantiles;
+    if (ROBUST_STATS_ENABLED && robust_stats_get(&quantiles) == ESP_OK) {
+        ESP_LOGI(TAG, "📐 Quantis (%" PRIu32 " capturas): mediana %.2f%% | p95 %.2f%% | p99 %.2f%% | MAD %.2f",
+                 quantiles.count, quantiles.median, quantiles.p95, quantiles.p99, quantiles.mad);
+    }
+    event_clip_stats_t clips;
+    if (EVENT_CLIP_ENABLED && alert_count > 0) {
+        event_clip_get_stats(&clips);
+        ESP_LOGI(TAG, "🎬 Clipes: %" PRIu32 " enviados (%" PRIu32 " frames, %" PRIu32 " miniaturas, %" PRIu32 " falhas) | %" PRIu32 " descartados",
+                 clips.clips_sent, clips.frames_sent, clips.thumbnails_sent, clips.frames_failed, clips.clips_dropped);
+    }
+    pipeline_queue_stats_t queues[PIPELINE_QUEUE_COUNT];
+    collect_pipeline_stats(queues);
+    for (size_t i = 0; i < PIPELINE_QUEUE_COUNT; i++) {
+        ESP_LOGI(TAG, "🚰 Fila %s: %d/%d (pico %d) | %" PRIu32 " entradas | %" PRIu32 " descartes",
+                 queues[i].name, queues[i].depth, queues[i].capacity, queues[i].peak_depth,
+                 queues[i].pushed, queues[i].dropped);
+    }
     ESP_LOGI(TAG, "🎯 Referências: %" PRIu32 " atualizações", (uint32_t)reference_count);
     ESP_LOGI(TAG, "💾 Heap: %" PRIu32 " KB livre", (uint32_t)(esp_get_free_heap_size() / 1024));
     ESP_LOGI(TAG, "💾 PSRAM: %" PRIu32 " KB livre", (uint32_t)(heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024));
@@ -323,6 +969,14 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
+    // Engine de comparação escolhido em campo (NVS), senão COMPARE_DEFAULT_ENGINE
+    compare_engine_init();
+    
+    // Máscara de regiões ruidosas aprendida em execuções anteriores
+    if (NUISANCE_MASK_ENABLED) {
+        compare_nuisance_init();
+    }
+
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
     
@@ -333,7 +987,13 @@ void app_main(void)
     esp_netif_create_default_wifi_sta();
     wifi_init_sta();
     
+    // Relógio de parede para timestamps (o callback registra o deslocamento do esp_timer)
+    if (TIME_SYNC_ENABLED && time_sync_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️  SNTP desabilitado - timestamps em uptime");
+    }
+    
     ESP_LOGI(TAG, "📡 Conectando MQTT...");
+    mqtt_send_track_json_memory();
     mqtt_init();
     ESP_ERROR_CHECK(esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL));
   
@@ -362,6 +1022,45 @@ void app_main(void)
     ESP_LOGI(TAG, "   - Intervalo: %d segundos", CAPTURE_INTERVAL_MS / 1000);
     ESP_LOGI(TAG, "   - Economia esperada: ~90%% vs versão simples");
 
+    // Pool de frames compartilhados (referência, histórico e multi-referências)
+    ESP_ERROR_CHECK(frame_pool_init());
+    
+    // Estado salvo na flash: contadores, linha de base da lente e referência
+    if (STATE_STORE_ENABLED) {
+        state_store_ready = (state_store_init() == ESP_OK);
+        if (state_store_ready) {
+            restore_detector_state();
+        } else {
+            ESP_LOGW(TAG, "⚠️  Persistência de estado desabilitada");
+        }
+    }
+    
+    // Assinaturas por captura para consultas de 24 h sem decodificar JPEG
+    if (FRAME_SIGNATURE_ENABLED && frame_signature_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️  Assinaturas desabilitadas (PSRAM insuficiente)");
+    }
+    
+    // Série temporal das diferenças (janela de horas, 4 bytes por captura)
+    if (TIME_SERIES_ENABLED && time_series_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️  Série temporal desabilitada (PSRAM insuficiente)");
+    }
+    
+    // Inicializar análise avançada (histórico em PSRAM)
+    if (ENABLE_HISTORY_BUFFER) {
+        history_enabled = (advanced_analysis_init() == ESP_OK);
+        if (!history_enabled) {
+            ESP_LOGW(TAG, "⚠️  Histórico desabilitado (PSRAM insuficiente)");
+        }
+    }
+    if (REFERENCE_BANK_ENABLED && FRAME_SIGNATURE_ENABLED && history_enabled) {
+        seed_bank_with_restored_reference();
+    }
+    
+    // Clipe pré-alerta (tarefa de envio com prioridade menor que a captura)
+    if (EVENT_CLIP_ENABLED && event_clip_init() != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️  Clipe pré-alerta desabilitado");
+    }
+
     // Inicializar WiFi sniffer
     if (SNIFFER_ENABLED) {
         ESP_LOGI(TAG, "📡 Inicializando WiFi Sniffer...");
@@ -372,7 +1071,16 @@ void app_main(void)
         }
     }
 
-    // Iniciar monitoramento inteligente
-    xTaskCreate(monitoring_task, "monitoring_task_intelligent", 8192, NULL, 5, NULL);
+    // Pipeline captura -> análise -> publicação, ligado por filas limitadas
+    if (pipeline_queue_init(&analyze_queue, "analyze", PIPELINE_ANALYZE_QUEUE, sizeof(capture_job_t),
+                            PIPELINE_DROP_OLDEST, release_capture_job, NULL) != ESP_OK ||
+        pipeline_queue_init(&publish_queue, "publish", PIPELINE_PUBLISH_QUEUE, sizeof(publish_job_t),
+                            PIPELINE_DROP_NEWEST, release_publish_job, publish_job_is_urgent) != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao criar filas do pipeline. Reiniciando...");
+        esp_restart();
+    }
+    xTaskCreate(publish_task, "publish_stage", PIPELINE_PUBLISH_STACK, NULL, PIPELINE_PUBLISH_PRIORITY, NULL);
+    xTaskCreate(analysis_task, "analysis_stage", PIPELINE_ANALYZE_STACK, NULL, PIPELINE_ANALYZE_PRIORITY, NULL);
+    xTaskCreate(capture_task, "capture_stage", PIPELINE_CAPTURE_STACK, NULL, PIPELINE_CAPTURE_PRIORITY, NULL);
     ESP_LOGI(TAG, "✅ Sistema INTELIGENTE iniciado!");
 } 
\ No newline at end of file
@@ -6,125 +6,300 @@
  */
 
 #include "advanced_analysis.h"
+#include "robust_stats.h"
+#include "mem_account.h"
+#include "plane_cache.h"
+#include "thumbnail.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "esp_timer.h"
 #include <string.h>
 #include <math.h>
 #include <inttypes.h>
+#include <stdlib.h>
 
 static const char *TAG = "ADV_ANALYSIS";
 
 // Variáveis globais
 static image_history_t history_buffer = {0};
+static uint8_t* thumb_arena = NULL;         // HISTORY_DEPTH slots de HISTORY_THUMB_SLOT_SIZE bytes
 static multi_reference_t multi_ref = {0};
 static bool system_initialized = false;
 
-/**
- * Cria uma cópia de um frame na PSRAM
- */
-static camera_fb_t* clone_frame_to_psram(camera_fb_t* original) {
-    if (!original) return NULL;
+esp_err_t advanced_analysis_init(void) {
+    if (system_initialized) {
+        ESP_LOGW(TAG, "Sistema já inicializado");
+        return ESP_OK;
+    }
     
-    camera_fb_t* clone = (camera_fb_t*)heap_caps_malloc(sizeof(camera_fb_t), MALLOC_CAP_SPIRAM);
-    if (!clone) {
-        ESP_LOGE(TAG, "Falha ao alocar estrutura do frame");
-        return NULL;
+    ESP_LOGI(TAG, "🧠 Inicializando análise avançada HVGA com %" PRIu32 " KB de PSRAM",
+             (uint32_t)(heap_caps_get_total_size(MALLOC_CAP_SPIRAM) / 1024));
+    
+    // Inicializar buffer de histórico
+    memset(&history_buffer, 0, sizeof(image_history_t));
+    memset(&multi_ref, 0, sizeof(multi_reference_t));
+    multi_ref.active_index = -1;
+    
+    // Frames do histórico e das referências vivem no pool compartilhado
+    if (!frame_pool_ready()) {
+        ESP_LOGW(TAG, "⚠️  Pool de frames não inicializado");
+        return ESP_ERR_INVALID_STATE;
     }
     
-    clone->buf = (uint8_t*)heap_caps_malloc(original->len, MALLOC_CAP_SPIRAM);
-    if (!clone->buf) {
-        ESP_LOGE(TAG, "Falha ao alocar buffer do frame");
-        free(clone);
-        return NULL;
+    // Planos reduzidos compartilhados por histórico e banco (uma decodificação por frame)
+    esp_err_t cache_err = plane_cache_init();
+    if (cache_err != ESP_OK) {
+        return cache_err;
+    }
+    
+    // Miniaturas: área fixa, sem alocação por captura
+    if (HISTORY_THUMBNAILS_ENABLED && !thumb_arena) {
+        thumb_arena = (uint8_t*)mem_alloc(MEM_TAG_FRAME_POOL, (size_t)HISTORY_DEPTH * HISTORY_THUMB_SLOT_SIZE,
+                                          MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (thumb_arena) {
+            ESP_LOGI(TAG, "🖼️ Histórico: %d entradas (%d completas + %d eventos), miniaturas 1/%d em %d KB",
+                     HISTORY_DEPTH, HISTORY_BUFFER_SIZE, HISTORY_EVENT_FRAMES, 1 << HISTORY_THUMB_SCALE_SHIFT,
+                     HISTORY_DEPTH * HISTORY_THUMB_SLOT_SIZE / 1024);
+        } else {
+            ESP_LOGW(TAG, "⚠️  Sem PSRAM para miniaturas - entradas antigas mantêm apenas a diferença");
+        }
     }
     
-    memcpy(clone->buf, original->buf, original->len);
-    clone->len = original->len;
-    clone->width = original->width;
-    clone->height = original->height;
-    clone->format = original->format;
-    clone->timestamp = original->timestamp;
+    size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    ESP_LOGI(TAG, "💾 PSRAM livre: %" PRIu32 " KB", (uint32_t)(free_psram / 1024));
+    mem_tag_stats_t pool_mem;
+    mem_account_get_tag(MEM_TAG_FRAME_POOL, &pool_mem);
+    ESP_LOGI(TAG, "💾 Frames compartilhados: %d slots, %" PRIu32 " KB alocados (sem cópias por consumidor)",
+             FRAME_POOL_SLOTS, (uint32_t)(pool_mem.live_bytes / 1024));
+    
+    system_initialized = true;
+    ESP_LOGI(TAG, "✅ Análise avançada pronta | maior bloco livre PSRAM: %" PRIu32 " KB",
+             (uint32_t)(heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) / 1024));
     
-    return clone;
+    return ESP_OK;
+}
+
+static inline int history_slot(int age) {
+    return (history_buffer.current_index - age + HISTORY_DEPTH) % HISTORY_DEPTH;
 }
 
 /**
- * Libera um frame clonado
+ * Miniatura da entrada a partir do plano (sem plano, decodifica o frame pelo cache)
  */
-static void free_cloned_frame(camera_fb_t* frame) {
-    if (frame) {
-        if (frame->buf) {
-            free(frame->buf);
-        }
-        free(frame);
+static void history_encode_thumbnail(int slot, frame_handle_t* handle, const luma_plane_t* plane) {
+    if (!thumb_arena) return;
+    
+    const luma_plane_t* source = plane ? plane : plane_cache_get(handle);
+    if (!source) {
+        history_buffer.thumbs_failed++;
+        return;
     }
+    
+    size_t len = 0;
+    esp_err_t err = thumbnail_encode(source, HISTORY_THUMB_SCALE_SHIFT, HISTORY_THUMB_QUALITY,
+                                     thumb_arena + (size_t)slot * HISTORY_THUMB_SLOT_SIZE,
+                                     HISTORY_THUMB_SLOT_SIZE, &len);
+    if (err != ESP_OK) {
+        history_buffer.thumbs_failed++;
+        ESP_LOGD(TAG, "Miniatura do histórico descartada: %s", esp_err_to_name(err));
+        return;
+    }
+    history_buffer.thumb_len[slot] = (uint16_t)len;
+    history_buffer.thumb_width = source->width >> (HISTORY_THUMB_SCALE_SHIFT - COMPARE_SCALE_SHIFT);
+    history_buffer.thumb_height = source->height >> (HISTORY_THUMB_SCALE_SHIFT - COMPARE_SCALE_SHIFT);
+    history_buffer.thumbs_encoded++;
 }
 
-esp_err_t advanced_analysis_init(void) {
-    if (system_initialized) {
-        ESP_LOGW(TAG, "Sistema já inicializado");
-        return ESP_OK;
+/**
+ * Insere no buffer circular; o plano fornecido vai para o cache (sem ele,
+ * o frame é decodificado só quando alguém consultar o plano)
+ */
+static esp_err_t history_push(frame_handle_t* handle, float difference, const luma_plane_t* plane) {
+    // Slot mais antigo é sobrescrito no lugar (buffer circular)
+    if (history_buffer.count < HISTORY_DEPTH) {
+        history_buffer.count++;
+    }
+    history_buffer.current_index = (history_buffer.current_index + 1) % HISTORY_DEPTH;
+    int slot = history_buffer.current_index;
+    
+    // Trocar o dono do slot: a referência antiga volta ao pool se for a última
+    frame_handle_release(history_buffer.frames[slot]);
+    history_buffer.frames[slot] = frame_handle_retain(handle);
+    history_buffer.differences[slot] = difference;
+    history_buffer.timestamps[slot] = handle ? frame_handle_captured_us(handle) : esp_timer_get_time();
+    history_buffer.events[slot] = false;
+    history_buffer.thumb_len[slot] = 0;
+    
+    // Entrada que saiu da janela recente fica só com a miniatura (eventos mantêm o frame)
+    if (history_buffer.count > HISTORY_BUFFER_SIZE) {
+        int aged = history_slot(HISTORY_BUFFER_SIZE);
+        if (!history_buffer.events[aged] && history_buffer.frames[aged]) {
+            frame_handle_release(history_buffer.frames[aged]);
+            history_buffer.frames[aged] = NULL;
+        }
+    }
+    
+    // Plano compartilhado com referência e banco (uma cópia por frame)
+    if (handle && plane) {
+        esp_err_t plane_err = plane_cache_put(handle, plane);
+        if (plane_err != ESP_OK) {
+            ESP_LOGW(TAG, "Plano do histórico fora do cache: %s", esp_err_to_name(plane_err));
+        }
     }
     
-    ESP_LOGI(TAG, "🧠 Inicializando análise avançada HVGA com ~4MB PSRAM utilizáveis");
+    if (handle || plane) {
+        history_encode_thumbnail(slot, handle, plane);
+    }
     
-    // Inicializar buffer de histórico
-    memset(&history_buffer, 0, sizeof(image_history_t));
-    memset(&multi_ref, 0, sizeof(multi_reference_t));
+    if (!handle) {
+        ESP_LOGW(TAG, "⚠️ Frame não copiado para o pool - histórico mantém diferença e miniatura");
+        return ESP_ERR_INVALID_SIZE;
+    }
     
-    // Verificar memória PSRAM disponível
-    size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-    size_t required_memory = HISTORY_BUFFER_TOTAL + (MAX_IMAGE_SIZE * 4); // 4 referências
+    ESP_LOGD(TAG, "📚 Frame adicionado ao histórico [%d/%d] - Diff: %.2f%%, miniatura %u bytes", 
+             history_buffer.count, HISTORY_DEPTH, difference, history_buffer.thumb_len[slot]);
     
-    ESP_LOGI(TAG, "💾 PSRAM livre: %" PRIu32 " KB", (uint32_t)(free_psram / 1024));
-    ESP_LOGI(TAG, "💾 Memória necessária: %" PRIu32 " KB (HVGA otimizada)", (uint32_t)(required_memory / 1024));
-    ESP_LOGI(TAG, "💾 Eficiência: %.1f%% da PSRAM utilizável",
-             ((float)required_memory / (4 * 1024 * 1024 * 0.9)) * 100.0f);
-    ESP_LOGI(TAG, "💾 Economia vs VGA: ~210KB (30%% menos memória)");
+    return ESP_OK;
+}
+
+esp_err_t add_handle_to_history(frame_handle_t* handle, float difference, const luma_plane_t* plane) {
+    if (!system_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return history_push(handle, difference, plane);
+}
+
+esp_err_t mark_history_event(void) {
+    if (!system_initialized || history_buffer.count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!thumb_arena || HISTORY_EVENT_FRAMES == 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
     
-    if (free_psram < required_memory) {
-        ESP_LOGW(TAG, "⚠️  PSRAM insuficiente para todos os recursos");
-        return ESP_ERR_NO_MEM;
+    int slot = history_buffer.current_index;
+    if (history_buffer.events[slot]) {
+        return ESP_OK;
     }
     
-    // Pré-alocar estruturas críticas para evitar fragmentação
-    ESP_LOGI(TAG, "🔧 Pré-alocando estruturas para evitar fragmentação...");
+    // Cota de eventos: o mais antigo volta a ser só miniatura
+    int marked = 0, oldest_age = -1;
+    for (int age = 1; age < history_buffer.count; age++) {
+        if (history_buffer.events[history_slot(age)]) {
+            marked++;
+            oldest_age = age;
+        }
+    }
+    if (marked >= HISTORY_EVENT_FRAMES) {
+        int oldest = history_slot(oldest_age);
+        history_buffer.events[oldest] = false;
+        if (oldest_age >= HISTORY_BUFFER_SIZE) {
+            frame_handle_release(history_buffer.frames[oldest]);
+            history_buffer.frames[oldest] = NULL;
+        }
+    }
     
-    system_initialized = true;
-    ESP_LOGI(TAG, "✅ Sistema de análise avançada inicializado (~490KB alocados)");
+    history_buffer.events[slot] = true;
+    return ESP_OK;
+}
+
+esp_err_t get_history_entry(int age, history_entry_view_t* entry) {
+    if (!system_initialized || !entry) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (age < 0 || age >= history_buffer.count) {
+        return ESP_ERR_NOT_FOUND;
+    }
     
+    int slot = history_slot(age);
+    entry->thumbnail_len = history_buffer.thumb_len[slot];
+    entry->thumbnail = entry->thumbnail_len > 0 ? thumb_arena + (size_t)slot * HISTORY_THUMB_SLOT_SIZE : NULL;
+    entry->thumbnail_width = history_buffer.thumb_width;
+    entry->thumbnail_height = history_buffer.thumb_height;
+    entry->frame = history_buffer.frames[slot];
+    entry->difference = history_buffer.differences[slot];
+    entry->timestamp = history_buffer.timestamps[slot];
+    entry->event = history_buffer.events[slot];
     return ESP_OK;
 }
 
 esp_err_t add_to_history(camera_fb_t* frame, float difference) {
+    return add_to_history_with_plane(frame, difference, NULL);
+}
+
+esp_err_t add_to_history_with_plane(camera_fb_t* frame, float difference, const luma_plane_t* plane) {
     if (!system_initialized || !frame) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Liberar frame antigo se buffer estiver cheio
-    if (history_buffer.count >= HISTORY_BUFFER_SIZE) {
-        int oldest_index = (history_buffer.current_index + 1) % HISTORY_BUFFER_SIZE;
-        if (history_buffer.frames[oldest_index]) {
-            free_cloned_frame(history_buffer.frames[oldest_index]);
-        }
-    } else {
-        history_buffer.count++;
+    // Cópia única no pool; o histórico guarda sua própria referência
+    frame_handle_t* handle = frame_handle_create(frame);
+    esp_err_t err = history_push(handle, difference, plane);
+    frame_handle_release(handle);
+    return err;
+}
+
+esp_err_t detect_three_frame_change(three_frame_result_t* result) {
+    if (!system_initialized || !result || history_buffer.count < 3) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    memset(result, 0, sizeof(three_frame_result_t));
+    
+    int idx_t = history_slot(0);
+    int idx_t1 = history_slot(1);
+    int idx_t2 = history_slot(2);
+    // Planos do cache (decodificados só se foram despejados); cabem os três juntos
+    const luma_plane_t* f0 = plane_cache_get(history_buffer.frames[idx_t]);
+    const luma_plane_t* f1 = plane_cache_get(history_buffer.frames[idx_t1]);
+    const luma_plane_t* f2 = plane_cache_get(history_buffer.frames[idx_t2]);
+    
+    if (!f0 || !f1 || !f2 ||
+        f0->width != f1->width || f1->width != f2->width ||
+        f0->height != f1->height || f1->height != f2->height) {
+        return ESP_ERR_INVALID_STATE;
     }
     
-    // Adicionar novo frame
-    history_buffer.current_index = (history_buffer.current_index + 1) % HISTORY_BUFFER_SIZE;
-    history_buffer.frames[history_buffer.current_index] = clone_frame_to_psram(frame);
-    history_buffer.differences[history_buffer.current_index] = difference;
-    history_buffer.timestamps[history_buffer.current_index] = esp_timer_get_time();
+    const int width = f0->width;
+    const int blocks_x = f0->width / COMPARE_BLOCK_SIZE;
+    const int blocks_y = f0->height / COMPARE_BLOCK_SIZE;
+    const int pixels_per_block = COMPARE_BLOCK_SIZE * COMPARE_BLOCK_SIZE;
+    
+    // Cada bloco: médias de |f(t) - f(t-1)| e |f(t-1) - f(t-2)| em uma passada
+    for (int by = 0; by < blocks_y; by++) {
+        for (int bx = 0; bx < blocks_x; bx++) {
+            uint32_t d1 = 0, d2 = 0;
+            for (int y = 0; y < COMPARE_BLOCK_SIZE; y++) {
+                size_t row = (size_t)(by * COMPARE_BLOCK_SIZE + y) * width + bx * COMPARE_BLOCK_SIZE;
+                for (int x = 0; x < COMPARE_BLOCK_SIZE; x++) {
+                    int p1 = f1->pixels[row + x];
+                    d1 += abs(f0->pixels[row + x] - p1);
+                    d2 += abs(p1 - f2->pixels[row + x]);
+                }
+            }
+            
+            bool changed_recent = (d1 / pixels_per_block) > THREE_FRAME_BLOCK_THRESHOLD;
+            bool changed_before = (d2 / pixels_per_block) > THREE_FRAME_BLOCK_THRESHOLD;
+            
+            if (changed_recent && changed_before) {
+                result->transient_blocks++;
+            } else if (changed_before) {
+                result->persistent_blocks++;
+            } else if (changed_recent) {
+                result->onset_blocks++;
+            }
+        }
+    }
     
-    if (!history_buffer.frames[history_buffer.current_index]) {
-        ESP_LOGE(TAG, "Falha ao clonar frame para histórico");
-        return ESP_ERR_NO_MEM;
+    result->total_blocks = blocks_x * blocks_y;
+    if (result->total_blocks > 0) {
+        result->transient_percent = (float)result->transient_blocks / result->total_blocks * 100.0f;
+        result->persistent_percent = (float)result->persistent_blocks / result->total_blocks * 100.0f;
+        result->onset_percent = (float)result->onset_blocks / result->total_blocks * 100.0f;
     }
     
-    ESP_LOGD(TAG, "📚 Frame adicionado ao histórico [%d/%d] - Diff: %.2f%%", 
-             history_buffer.count, HISTORY_BUFFER_SIZE, difference);
+    ESP_LOGD(TAG, "🎞️ Três frames: transitório=%.1f%% persistente=%.1f%% início=%.1f%%",
+             result->transient_percent, result->persistent_percent, result->onset_percent);
     
     return ESP_OK;
 }
@@ -141,7 +316,7 @@ esp_err_t perform_temporal_analysis(temporal_analysis_t* analysis) {
     analysis->max_change = 0.0f;
     
     for (int i = 0; i < history_buffer.count; i++) {
-        float diff = history_buffer.differences[i];
+        float diff = history_buffer.differences[history_slot(i)];
         sum += diff;
         sum_squares += diff * diff;
         if (diff > analysis->max_change) {
@@ -151,15 +326,17 @@ esp_err_t perform_temporal_analysis(temporal_analysis_t* analysis) {
     
     analysis->average_change = sum / history_buffer.count;
     
-    // Calcular tendência usando regressão linear simples
-    float sum_x = 0.0f, sum_xy = 0.0f;
+    // Calcular tendência usando regressão linear simples (x = posição cronológica)
+    float sum_x = 0.0f, sum_x2 = 0.0f, sum_xy = 0.0f;
     for (int i = 0; i < history_buffer.count; i++) {
+        int age = history_buffer.count - 1 - i;
         sum_x += i;
-        sum_xy += i * history_buffer.differences[i];
+        sum_x2 += (float)i * i;
+        sum_xy += i * history_buffer.differences[history_slot(age)];
     }
     
     float n = history_buffer.count;
-    analysis->trend_slope = (n * sum_xy - sum_x * sum) / (n * (n * (n - 1) / 2) - sum_x * sum_x);
+    analysis->trend_slope = (n * sum_xy - sum_x * sum) / (n * sum_x2 - sum_x * sum_x);
     
     // Determinar direção da tendência
     analysis->increasing_trend = analysis->trend_slope > 0.5f;
@@ -176,85 +353,278 @@ esp_err_t perform_temporal_analysis(temporal_analysis_t* analysis) {
     return ESP_OK;
 }
 
-esp_err_t update_multi_references(camera_fb_t* current_frame, int time_of_day, int weather_condition) {
-    if (!system_initialized || !current_frame) {
-        return ESP_ERR_INVALID_STATE;
+/**
+ * Grava o frame numa entrada do banco; o plano fornecido vai para o cache
+ */
+static void replace_reference(reference_entry_t* entry, frame_handle_t* frame, const luma_plane_t* plane,
+                              const frame_signature_t* signature) {
+    frame_handle_release(entry->frame);
+    entry->frame = frame_handle_retain(frame);
+    entry->signature = *signature;
+    entry->last_used = esp_timer_get_time();
+    entry->valid = true;
+
+    // Sem plano, a comparação em lote decodifica o frame na primeira consulta
+    if (plane) {
+        plane_cache_put(frame, plane);
+    }
+}
+
+/**
+ * Distância da assinatura ao centroide (mesma escala de frame_signature_distance),
+ * mais REFERENCE_WEATHER_PENALTY se o representante é de outra condição de tempo
+ */
+static float centroid_distance(const frame_signature_t* signature, const reference_entry_t* entry) {
+    uint32_t sum = 0;
+    for (int i = 0; i < COMPARE_MAX_BLOCKS; i++) {
+        sum += abs(((int)signature->luma[i] << 8) - (int)entry->centroid[i]);
+    }
+    float distance = (float)sum / (COMPARE_MAX_BLOCKS * 256.0f);
+    if (signature->weather != 0 && entry->signature.weather != 0 &&
+        signature->weather != entry->signature.weather) {
+        distance += REFERENCE_WEATHER_PENALTY;
+    }
+    return distance;
+}
+
+/**
+ * Conta a captura como membro e aproxima o centroide dela: média exata nas
+ * primeiras capturas, depois média móvel com peso 1/REFERENCE_CLUSTER_MAX_WEIGHT
+ */
+static void absorb_member(reference_entry_t* entry, const frame_signature_t* signature) {
+    entry->members++;
+    entry->recent++;
+    int weight = entry->members < REFERENCE_CLUSTER_MAX_WEIGHT ? (int)entry->members : REFERENCE_CLUSTER_MAX_WEIGHT;
+    for (int i = 0; i < COMPARE_MAX_BLOCKS; i++) {
+        int c = entry->centroid[i];
+        entry->centroid[i] = (uint16_t)(c + (((int)signature->luma[i] << 8) - c) / weight);
     }
     
-    uint64_t current_time = esp_timer_get_time();
-    bool should_update = (current_time - multi_ref.last_update_time) > (3600 * 1000000ULL); // 1 hora
+    // Decaimento conjunto: cenas que deixaram de aparecer perdem prioridade
+    if (entry->recent >= REFERENCE_CLUSTER_DECAY_AT) {
+        for (int i = 0; i < MULTI_REFERENCE_COUNT; i++) {
+            multi_ref.entries[i].recent /= 2;
+        }
+    }
+}
+
+/**
+ * Cluster válido de centroide mais próximo da assinatura (-1 com o banco vazio)
+ */
+static int nearest_reference(const frame_signature_t* signature, float* distance) {
+    int best = -1;
+    float best_distance = 0.0f;
+    for (int i = 0; i < MULTI_REFERENCE_COUNT; i++) {
+        if (!multi_ref.entries[i].valid) continue;
+        float d = centroid_distance(signature, &multi_ref.entries[i]);
+        if (best < 0 || d < best_distance) {
+            best = i;
+            best_distance = d;
+        }
+    }
+    if (distance) {
+        *distance = best_distance;
+    }
+    return best;
+}
+
+int update_multi_references(frame_handle_t* current_frame, const luma_plane_t* plane,
+                            const frame_signature_t* signature) {
+    if (!system_initialized || !current_frame || !signature) {
+        return -1;
+    }
     
-    if (!should_update) return ESP_OK;
+    float distance;
+    int index = nearest_reference(signature, &distance);
+    bool new_cluster = index < 0 || distance > REFERENCE_MATCH_DISTANCE;
     
-    // Atualizar referência baseada na hora do dia
-    if (time_of_day >= 6 && time_of_day <= 18) {
-        // Referência diurna
-        if (multi_ref.day_reference) {
-            free_cloned_frame(multi_ref.day_reference);
-        }
-        multi_ref.day_reference = clone_frame_to_psram(current_frame);
-        ESP_LOGI(TAG, "🌅 Referência diurna atualizada");
+    if (!new_cluster) {
+        // Mesma cena: renovar o representante do cluster
+        ESP_LOGD(TAG, "🔄 Representante do cluster #%d renovado (distância %.1f)", index, distance);
     } else {
-        // Referência noturna
-        if (multi_ref.night_reference) {
-            free_cloned_frame(multi_ref.night_reference);
+        // Cena nova: entrada livre ou o cluster menos usado recentemente
+        index = -1;
+        for (int i = 0; i < MULTI_REFERENCE_COUNT; i++) {
+            reference_entry_t* entry = &multi_ref.entries[i];
+            if (!entry->valid) {
+                index = i;
+                break;
+            }
+            reference_entry_t* chosen = index >= 0 ? &multi_ref.entries[index] : NULL;
+            if (!chosen || entry->recent < chosen->recent ||
+                (entry->recent == chosen->recent && entry->last_used < chosen->last_used)) {
+                index = i;
+            }
+        }
+        reference_entry_t* entry = &multi_ref.entries[index];
+        if (entry->valid) {
+            ESP_LOGI(TAG, "🧠 Nova cena (distância %.1f): substituindo cluster #%d (%" PRIu32 " membros)",
+                     distance, index, entry->members);
+            multi_ref.replaced++;
+        } else {
+            ESP_LOGI(TAG, "🧠 Nova cena: cluster #%d adicionado ao banco", index);
+            multi_ref.created++;
         }
-        multi_ref.night_reference = clone_frame_to_psram(current_frame);
-        ESP_LOGI(TAG, "🌙 Referência noturna atualizada");
+        entry->members = 0;
+        entry->recent = 0;
+        entry->created = esp_timer_get_time();
     }
     
-    // Atualizar referência baseada no clima (estimativa simples)
-    if (weather_condition == 0) { // Tempo claro
-        if (multi_ref.clear_reference) {
-            free_cloned_frame(multi_ref.clear_reference);
+    reference_entry_t* entry = &multi_ref.entries[index];
+    replace_reference(entry, current_frame, plane, signature);
+    if (new_cluster) {
+        // Primeiro membro define o centroide
+        absorb_member(entry, signature);
+    }
+    multi_ref.active_index = index;
+    return index;
+}
+
+/**
+ * Desempata pelos pixels os clusters de assinatura próxima: o plano atual é
+ * comparado em um único lote contra os planos em cache da lista curta.
+ * A referência ativa é mantida salvo vantagem de REFERENCE_SCORE_MARGIN.
+ * Retorna o índice escolhido, ou -1 se não houve lote (menos de 2 candidatos)
+ */
+static int rank_shortlist(luma_plane_t* plane, const float distances[MULTI_REFERENCE_COUNT], float best_distance) {
+    int candidates[MULTI_REFERENCE_COUNT];
+    luma_plane_t* planes[MULTI_REFERENCE_COUNT];
+    int count = 0;
+    
+    // Lista curta: as REFERENCE_SHORTLIST entradas mais próximas dentro da margem
+    while (count < REFERENCE_SHORTLIST) {
+        int next = -1;
+        for (int i = 0; i < MULTI_REFERENCE_COUNT; i++) {
+            bool listed = false;
+            for (int c = 0; c < count; c++) {
+                listed |= (candidates[c] == i);
+            }
+            if (listed || distances[i] < 0.0f || distances[i] > best_distance + REFERENCE_SHORTLIST_MARGIN) {
+                continue;
+            }
+            if (next < 0 || distances[i] < distances[next]) {
+                next = i;
+            }
         }
-        multi_ref.clear_reference = clone_frame_to_psram(current_frame);
-        ESP_LOGI(TAG, "☀️ Referência tempo claro atualizada");
-    } else { // Tempo ruim
-        if (multi_ref.weather_reference) {
-            free_cloned_frame(multi_ref.weather_reference);
+        if (next < 0) {
+            break;
         }
-        multi_ref.weather_reference = clone_frame_to_psram(current_frame);
-        ESP_LOGI(TAG, "🌧️ Referência tempo ruim atualizada");
+        candidates[count++] = next;
+    }
+    if (count < 2) {
+        return -1;
     }
     
-    multi_ref.last_update_time = current_time;
-    return ESP_OK;
+    for (int c = 0; c < count; c++) {
+        planes[c] = plane_cache_get(multi_ref.entries[candidates[c]].frame);
+    }
+    float scores[MULTI_REFERENCE_COUNT];
+    int best = -1;
+    if (compare_luma_batch(plane, planes, count, scores, &best) != ESP_OK || best < 0) {
+        return -1;
+    }
+    
+    int chosen = best;
+    for (int c = 0; c < count; c++) {
+        if (candidates[c] == multi_ref.active_index && scores[c] >= 0.0f &&
+            scores[c] <= scores[best] + REFERENCE_SCORE_MARGIN) {
+            chosen = c;
+        }
+    }
+    ESP_LOGD(TAG, "🧠 Lote de %d clusters -> #%d (%.1f%%, melhor #%d %.1f%%)", count,
+             candidates[chosen], scores[chosen], candidates[best], scores[best]);
+    return candidates[chosen];
 }
 
-camera_fb_t* get_best_reference(int time_of_day, int weather_condition) {
-    if (!system_initialized) return NULL;
-    
-    // Priorizar referência por hora do dia
-    if (time_of_day >= 6 && time_of_day <= 18) {
-        if (multi_ref.day_reference) {
-            ESP_LOGD(TAG, "🌅 Usando referência diurna");
-            return multi_ref.day_reference;
-        }
-    } else {
-        if (multi_ref.night_reference) {
-            ESP_LOGD(TAG, "🌙 Usando referência noturna");
-            return multi_ref.night_reference;
+int select_similar_reference(const frame_signature_t* signature, luma_plane_t* plane, float* distance) {
+    if (!system_initialized || !signature) {
+        return -1;
+    }
+    
+    float best_distance;
+    int best = nearest_reference(signature, &best_distance);
+    if (best < 0) {
+        return -1;
+    }
+    
+    float distances[MULTI_REFERENCE_COUNT];
+    for (int i = 0; i < MULTI_REFERENCE_COUNT; i++) {
+        distances[i] = multi_ref.entries[i].valid ? centroid_distance(signature, &multi_ref.entries[i]) : -1.0f;
+    }
+    
+    int active = multi_ref.active_index;
+    int ranked = plane ? rank_shortlist(plane, distances, best_distance) : -1;
+    if (ranked >= 0) {
+        best = ranked;
+        best_distance = distances[ranked];
+    } else if (active >= 0 && active != best && multi_ref.entries[active].valid) {
+        // Histerese: manter a referência ativa salvo vantagem clara do candidato
+        if (distances[active] <= best_distance + REFERENCE_SWITCH_MARGIN) {
+            best = active;
+            best_distance = distances[active];
         }
     }
     
-    // Fallback para referência climática
-    if (weather_condition == 0 && multi_ref.clear_reference) {
-        ESP_LOGD(TAG, "☀️ Usando referência tempo claro");
-        return multi_ref.clear_reference;
-    } else if (weather_condition != 0 && multi_ref.weather_reference) {
-        ESP_LOGD(TAG, "🌧️ Usando referência tempo ruim");
-        return multi_ref.weather_reference;
+    if (best != active) {
+        ESP_LOGI(TAG, "🧠 Cluster #%d selecionado por similaridade (distância %.1f, %" PRIu32 " membros)",
+                 best, best_distance, multi_ref.entries[best].members);
     }
     
-    // Última opção: qualquer referência disponível
-    if (multi_ref.day_reference) return multi_ref.day_reference;
-    if (multi_ref.night_reference) return multi_ref.night_reference;
-    if (multi_ref.clear_reference) return multi_ref.clear_reference;
-    if (multi_ref.weather_reference) return multi_ref.weather_reference;
+    // Só capturas dentro do raio da cena contam como membros (objetos de passagem não)
+    reference_entry_t* entry = &multi_ref.entries[best];
+    entry->last_used = esp_timer_get_time();
+    if (best_distance <= REFERENCE_MATCH_DISTANCE) {
+        absorb_member(entry, signature);
+    }
+    multi_ref.active_index = best;
     
-    ESP_LOGW(TAG, "⚠️ Nenhuma referência disponível");
-    return NULL;
+    if (distance) {
+        *distance = best_distance;
+    }
+    return best;
+}
+
+esp_err_t get_reference_bank_stats(reference_bank_stats_t* stats) {
+    if (!system_initialized || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(stats, 0, sizeof(reference_bank_stats_t));
+    stats->capacity = MULTI_REFERENCE_COUNT;
+    stats->active_index = multi_ref.active_index;
+    stats->created = multi_ref.created;
+    stats->replaced = multi_ref.replaced;
+    
+    uint64_t now = esp_timer_get_time();
+    for (int i = 0; i < MULTI_REFERENCE_COUNT; i++) {
+        const reference_entry_t* entry = &multi_ref.entries[i];
+        reference_cluster_info_t* info = &stats->clusters[i];
+        if (!entry->valid) continue;
+        
+        uint32_t luma_q8 = 0;
+        for (int b = 0; b < COMPARE_MAX_BLOCKS; b++) {
+            luma_q8 += entry->centroid[b];
+        }
+        info->valid = true;
+        info->members = entry->members;
+        info->recent = entry->recent;
+        info->mean_luma = (uint8_t)(luma_q8 / COMPARE_MAX_BLOCKS >> 8);
+        info->age_s = (uint32_t)((now - entry->created) / 1000000ULL);
+        info->idle_s = (uint32_t)((now - entry->last_used) / 1000000ULL);
+        
+        stats->count++;
+        stats->memory_bytes += (entry->frame ? MAX_IMAGE_SIZE : 0) +
+                               (plane_cache_contains(entry->frame) ?
+                                (size_t)COMPARE_PLANE_WIDTH * COMPARE_PLANE_HEIGHT : 0);
+    }
+    return ESP_OK;
+}
+
+reference_entry_t* get_reference_entry(int index) {
+    if (!system_initialized || index < 0 || index >= MULTI_REFERENCE_COUNT || !multi_ref.entries[index].valid) {
+        return NULL;
+    }
+    return &multi_ref.entries[index];
 }
 
 float calculate_stability_index(void) {
@@ -271,31 +641,21 @@ float calculate_stability_index(void) {
 }
 
 bool detect_anomaly_pattern(void) {
-    if (!system_initialized || history_buffer.count < 2) {
+    if (!system_initialized || history_buffer.count < 1) {
         return false;
     }
     
-    // Detectar picos súbitos
-    int spike_count = 0;
-    for (int i = 1; i < history_buffer.count - 1; i++) {
-        float current = history_buffer.differences[i];
-        float prev = history_buffer.differences[i - 1];
-        float next = history_buffer.differences[i + 1];
-        
-        // Pico se a diferença for 3x maior que as adjacentes
-        if (current > prev * 3.0f && current > next * 3.0f && current > 10.0f) {
-            spike_count++;
-        }
-    }
+    // Diferença mais recente contra a distribuição desta câmera (quantis P²)
+    float latest = history_buffer.differences[history_buffer.current_index];
+    robust_assessment_t assessment;
+    robust_stats_assess(latest, &assessment);
     
-    // Anomalia se houver 2 ou mais picos
-    bool anomaly_detected = spike_count >= 2;
-    
-    if (anomaly_detected) {
-        ESP_LOGW(TAG, "🚨 Padrão anômalo detectado: %d picos", spike_count);
+    if (assessment.anomalous) {
+        ESP_LOGW(TAG, "🚨 Padrão anômalo: %.1f%% acima do p99 (%.1f desvios robustos)",
+                 latest, assessment.robust_z);
     }
     
-    return anomaly_detected;
+    return assessment.anomalous;
 }
 
 esp_err_t get_history_stats(size_t* used_memory, float* buffer_utilization) {
@@ -303,20 +663,26 @@ esp_err_t get_history_stats(size_t* used_memory, float* buffer_utilization) {
         return ESP_ERR_INVALID_ARG;
     }
     
+    // Frames retidos pelo histórico: bytes JPEG reais, não o slot inteiro do pool
     *used_memory = 0;
-    for (int i = 0; i < history_buffer.count; i++) {
-        if (history_buffer.frames[i]) {
-            *used_memory += sizeof(camera_fb_t) + history_buffer.frames[i]->len;
+    for (int i = 0; i < HISTORY_DEPTH; i++) {
+        camera_fb_t *fb = frame_handle_fb(history_buffer.frames[i]);
+        if (fb) {
+            *used_memory += fb->len;
         }
     }
     
-    // Adicionar memória das referências múltiplas
-    if (multi_ref.day_reference) *used_memory += sizeof(camera_fb_t) + multi_ref.day_reference->len;
-    if (multi_ref.night_reference) *used_memory += sizeof(camera_fb_t) + multi_ref.night_reference->len;
-    if (multi_ref.clear_reference) *used_memory += sizeof(camera_fb_t) + multi_ref.clear_reference->len;
-    if (multi_ref.weather_reference) *used_memory += sizeof(camera_fb_t) + multi_ref.weather_reference->len;
+    // Planos de luminância em cache (uma cópia por frame, compartilhada)
+    plane_cache_stats_t cache;
+    plane_cache_get_stats(&cache);
+    *used_memory += cache.bytes;
     
-    *buffer_utilization = (float)history_buffer.count / HISTORY_BUFFER_SIZE;
+    // Miniaturas: a área inteira é reservada na inicialização
+    if (thumb_arena) {
+        *used_memory += (size_t)HISTORY_DEPTH * HISTORY_THUMB_SLOT_SIZE;
+    }
+    
+    *buffer_utilization = (float)history_buffer.count / HISTORY_DEPTH;
     
     return ESP_OK;
 }
@@ -335,23 +701,46 @@ esp_err_t get_memory_efficiency_stats(memory_efficiency_t* stats) {
     
     // Estatísticas de PSRAM
     size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
-    size_t total_psram = 4 * 1024 * 1024; // 4MB utilizáveis
+    size_t total_psram = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
     
     stats->total_psram_kb = total_psram / 1024;
     stats->free_psram_kb = free_psram / 1024;
     stats->used_by_analysis_kb = used_memory / 1024;
-    stats->psram_utilization = ((float)(total_psram - free_psram) / total_psram) * 100.0f;
-    stats->analysis_efficiency = ((float)used_memory / (490 * 1024)) * 100.0f; // vs 490KB estimado HVGA
+    stats->psram_utilization = total_psram > 0 ? ((float)(total_psram - free_psram) / total_psram) * 100.0f : 0.0f;
+    
+    // Bytes realmente alocados pelos subsistemas (cabeçalhos de mem_alloc)
+    mem_account_report_t report;
+    mem_account_snapshot(&report);
+    stats->tracked_kb = report.tracked_live / 1024;
+    stats->tracked_peak_kb = report.tracked_peak / 1024;
     
     // Contadores de recursos
     stats->active_references = 0;
-    if (multi_ref.day_reference) stats->active_references++;
-    if (multi_ref.night_reference) stats->active_references++;
-    if (multi_ref.clear_reference) stats->active_references++;
-    if (multi_ref.weather_reference) stats->active_references++;
+    for (int i = 0; i < MULTI_REFERENCE_COUNT; i++) {
+        if (multi_ref.entries[i].valid) stats->active_references++;
+    }
     
     stats->history_frames = history_buffer.count;
+    size_t thumb_bytes = 0;
+    for (int i = 0; i < HISTORY_DEPTH; i++) {
+        if (history_buffer.frames[i]) stats->history_full_frames++;
+        thumb_bytes += history_buffer.thumb_len[i];
+    }
+    stats->history_thumb_kb = thumb_bytes / 1024;
     stats->buffer_utilization = buffer_utilization * 100.0f;
+    stats->largest_free_block_kb = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) / 1024;
+    
+    plane_cache_stats_t cache;
+    plane_cache_get_stats(&cache);
+    uint32_t lookups = cache.hits + cache.misses;
+    stats->plane_cache_kb = cache.bytes / 1024;
+    stats->plane_cache_hit_rate = lookups > 0 ? (float)cache.hits / lookups * 100.0f : 0.0f;
+    
+    frame_pool_stats_t pool;
+    frame_pool_get_stats(&pool);
+    stats->oversize_frames = pool.oversize;
+    stats->pool_in_use = pool.in_use;
+    stats->pool_peak = pool.peak_in_use;
     
     return ESP_OK;
 }
@@ -366,21 +755,29 @@ void print_memory_efficiency_report(void) {
     }
     
     ESP_LOGI(TAG, "📊 === RELATÓRIO DE EFICIÊNCIA DE MEMÓRIA ===");
-    ESP_LOGI(TAG, "💾 PSRAM Total: %" PRIu32 " KB (4MB utilizáveis dos 8MB físicos)", (uint32_t)stats.total_psram_kb);
+    ESP_LOGI(TAG, "💾 PSRAM Total: %" PRIu32 " KB", (uint32_t)stats.total_psram_kb);
     ESP_LOGI(TAG, "💾 PSRAM Livre: %" PRIu32 " KB", (uint32_t)stats.free_psram_kb);
     ESP_LOGI(TAG, "💾 Usado pela Análise: %" PRIu32 " KB", (uint32_t)stats.used_by_analysis_kb);
     ESP_LOGI(TAG, "📊 Utilização PSRAM: %.1f%%", stats.psram_utilization);
-    ESP_LOGI(TAG, "📊 Eficiência Análise: %.1f%% (vs 490KB estimado HVGA)", stats.analysis_efficiency);
-    ESP_LOGI(TAG, "🧠 Referências Ativas: %d/4", stats.active_references);
-    ESP_LOGI(TAG, "📚 Buffer Histórico: %d/%d (%.1f%%)", stats.history_frames, HISTORY_BUFFER_SIZE, stats.buffer_utilization);
+    ESP_LOGI(TAG, "📊 Contabilizado: %" PRIu32 " KB (pico %" PRIu32 " KB)",
+             (uint32_t)stats.tracked_kb, (uint32_t)stats.tracked_peak_kb);
+    ESP_LOGI(TAG, "🧠 Referências Ativas: %d/%d", stats.active_references, MULTI_REFERENCE_COUNT);
+    ESP_LOGI(TAG, "📚 Buffer Histórico: %d/%d (%.1f%%) | %d completos | miniaturas %" PRIu32 " KB (%" PRIu32 " descartadas)",
+             stats.history_frames, HISTORY_DEPTH, stats.buffer_utilization, stats.history_full_frames,
+             (uint32_t)stats.history_thumb_kb, history_buffer.thumbs_failed);
+    ESP_LOGI(TAG, "🧩 Pool de frames: %d/%d em uso (pico %d) | frames grandes demais: %" PRIu32,
+             stats.pool_in_use, FRAME_POOL_SLOTS, stats.pool_peak, stats.oversize_frames);
+    ESP_LOGI(TAG, "🧩 Maior bloco livre PSRAM: %" PRIu32 " KB", (uint32_t)stats.largest_free_block_kb);
+    ESP_LOGI(TAG, "🗂️ Cache de planos: %" PRIu32 " KB, acertos %.1f%%",
+             (uint32_t)stats.plane_cache_kb, stats.plane_cache_hit_rate);
     ESP_LOGI(TAG, "===============================================");
     
     // Alertas de eficiência
     if (stats.psram_utilization > 85.0f) {
         ESP_LOGW(TAG, "⚠️  PSRAM com alta utilização (>85%%)");
     }
-    if (stats.analysis_efficiency > 120.0f) {
-        ESP_LOGW(TAG, "⚠️  Análise usando mais memória que estimado");
+    if (stats.largest_free_block_kb * 1024 < 2 * MAX_IMAGE_SIZE) {
+        ESP_LOGW(TAG, "⚠️  PSRAM fragmentada: maior bloco livre < 2 frames");
     }
     if (stats.free_psram_kb < 500) {
         ESP_LOGW(TAG, "⚠️  PSRAM livre baixa (<500KB)");
@@ -392,11 +789,9 @@ void clear_history_buffer(void) {
     
     ESP_LOGI(TAG, "🧹 Limpando buffer de histórico");
     
-    for (int i = 0; i < HISTORY_BUFFER_SIZE; i++) {
-        if (history_buffer.frames[i]) {
-            free_cloned_frame(history_buffer.frames[i]);
-            history_buffer.frames[i] = NULL;
-        }
+    // Devolver as referências do histórico; slots sem outros donos voltam ao pool
+    for (int i = 0; i < HISTORY_DEPTH; i++) {
+        frame_handle_release(history_buffer.frames[i]);
     }
     
     memset(&history_buffer, 0, sizeof(image_history_t));
@@ -411,10 +806,15 @@ void advanced_analysis_deinit(void) {
     clear_history_buffer();
     
     // Limpar referências múltiplas
-    if (multi_ref.day_reference) free_cloned_frame(multi_ref.day_reference);
-    if (multi_ref.night_reference) free_cloned_frame(multi_ref.night_reference);
-    if (multi_ref.clear_reference) free_cloned_frame(multi_ref.clear_reference);
-    if (multi_ref.weather_reference) free_cloned_frame(multi_ref.weather_reference);
+    for (int i = 0; i < MULTI_REFERENCE_COUNT; i++) {
+        frame_handle_release(multi_ref.entries[i].frame);
+    }
+    plane_cache_clear();
+    thumbnail_deinit();
+    if (thumb_arena) {
+        mem_free(thumb_arena);
+        thumb_arena = NULL;
+    }
     
     memset(&multi_ref, 0, sizeof(multi_reference_t));
     system_initialized = false;
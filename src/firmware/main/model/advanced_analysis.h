@@ -4,9 +4,9 @@
  * 
  * Este módulo implementa recursos avançados de análise de imagens
  * aproveitando os ~4MB de PSRAM utilizáveis:
- * - Buffer circular de histórico de imagens
+ * - Buffer circular de histórico de imagens (frames compartilhados do pool)
  * - Análise temporal de padrões
- * - Múltiplas imagens de referência
+ * - Banco de referências agrupado em clusters de cena por assinatura
  * - Detecção de tendências
  * 
  * @author Gabriel Passos - UNESP 2025
@@ -17,22 +17,72 @@
 
 #include "esp_camera.h"
 #include "config.h"
+#include "compare.h"
+#include "frame_handle.h"
+#include "frame_signature.h"
 #include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if HISTORY_BUFFER_SIZE < 3 || HISTORY_DEPTH < HISTORY_BUFFER_SIZE
+#error "Histórico precisa de 3 frames completos e profundidade >= HISTORY_BUFFER_SIZE"
+#endif
+#if HISTORY_THUMB_SLOT_SIZE > 65535 || HISTORY_THUMB_SCALE_SHIFT < COMPARE_SCALE_SHIFT
+#error "Miniatura: slot até 64 KB e escala não maior que a do plano de comparação"
+#endif
+
 // Estrutura para histórico de imagens
+// As HISTORY_BUFFER_SIZE entradas mais recentes (e as marcadas como evento)
+// mantêm o frame completo; todas guardam uma miniatura em tons de cinza.
 typedef struct {
-    camera_fb_t* frames[HISTORY_BUFFER_SIZE];
-    float differences[HISTORY_BUFFER_SIZE];
-    uint64_t timestamps[HISTORY_BUFFER_SIZE];
+    frame_handle_t* frames[HISTORY_DEPTH];   // Frames compartilhados (NULL = só miniatura, vazio ou não copiado; planos no plane_cache)
+    uint16_t thumb_len[HISTORY_DEPTH];       // Bytes da miniatura no slot da entrada (0 = sem miniatura)
+    bool events[HISTORY_DEPTH];              // Entrada de alerta (frame completo retido)
+    float differences[HISTORY_DEPTH];
+    uint64_t timestamps[HISTORY_DEPTH];
     int current_index;
     int count;
+    uint16_t thumb_width;                    // Dimensões das miniaturas (mesmas para todas as entradas)
+    uint16_t thumb_height;
+    uint32_t thumbs_encoded;                 // Miniaturas codificadas
+    uint32_t thumbs_failed;                  // Miniaturas descartadas (slot pequeno ou falha)
     bool initialized;
 } image_history_t;
 
+/**
+ * @brief Entrada do histórico (válida até a próxima inserção)
+ */
+typedef struct {
+    const uint8_t* thumbnail;   ///< JPEG em tons de cinza (NULL = sem miniatura)
+    size_t thumbnail_len;       ///< Bytes da miniatura
+    uint16_t thumbnail_width;   ///< Largura da miniatura (px)
+    uint16_t thumbnail_height;  ///< Altura da miniatura (px)
+    frame_handle_t* frame;      ///< Frame completo (NULL = só miniatura; sem referência extra)
+    float difference;           ///< Diferença da captura (%)
+    uint64_t timestamp;         ///< Instante da captura (µs do esp_timer; inserção se sem frame)
+    bool event;                 ///< Marcada como evento
+} history_entry_view_t;
+
+/**
+ * @brief Resultado da diferenciação de três frames do histórico
+ * 
+ * Com D1 = |f(t) - f(t-1)| e D2 = |f(t-1) - f(t-2)| por bloco:
+ * - transitório: D1 e D2 altos (algo apareceu só em t-1)
+ * - persistente: D2 alto e D1 baixo (mudança em t-1 que permaneceu em t)
+ * - início: D1 alto e D2 baixo (mudança nova em t, ainda não confirmada)
+ */
+typedef struct {
+    int transient_blocks;       ///< Blocos com movimento transitório
+    int persistent_blocks;      ///< Blocos com mudança persistente
+    int onset_blocks;           ///< Blocos com mudança recém-iniciada
+    int total_blocks;           ///< Blocos analisados
+    float transient_percent;    ///< Percentual de blocos transitórios
+    float persistent_percent;   ///< Percentual de blocos persistentes
+    float onset_percent;        ///< Percentual de blocos em início de mudança
+} three_frame_result_t;
+
 /**
  * @brief Estrutura para análise temporal
  */
@@ -45,43 +95,152 @@ typedef struct {
     bool decreasing_trend;      ///< Tendência decrescente
 } temporal_analysis_t;
 
-// Estrutura para múltiplas referências
+// Número de entradas do banco de referências (limitado por REFERENCE_BANK_MAX_KB)
+#define MULTI_REFERENCE_COUNT REFERENCE_BANK_ENTRIES
+
+#if REFERENCE_BANK_ENTRIES < 1 || REFERENCE_BANK_ENTRIES > COMPARE_MAX_BATCH
+#error "REFERENCE_BANK_ENTRIES deve ficar entre 1 e COMPARE_MAX_BATCH"
+#endif
+
+// A comparação em lote mantém os planos de todas as entradas ao mesmo tempo
+#if PLANE_CACHE_BUDGET_KB * 1024 / (COMPARE_PLANE_WIDTH * COMPARE_PLANE_HEIGHT) < REFERENCE_BANK_ENTRIES || \
+    PLANE_CACHE_MAX_ENTRIES < REFERENCE_BANK_ENTRIES
+#error "PLANE_CACHE_BUDGET_KB/PLANE_CACHE_MAX_ENTRIES devem comportar os planos do banco de referências"
+#endif
+
+// Entrada do banco de referências: um cluster de cena e seu representante
+typedef struct {
+    frame_handle_t* frame;          // Frame compartilhado do representante (plano no plane_cache)
+    frame_signature_t signature;    // Assinatura do representante
+    uint16_t centroid[COMPARE_MAX_BLOCKS]; // Luminância média por bloco das capturas da cena (8.8)
+    uint64_t created;               // Criação do cluster
+    uint64_t last_used;             // Última seleção ou atualização
+    uint32_t members;               // Capturas atribuídas ao cluster
+    uint32_t recent;                // Uso recente com decaimento (escolhe a cena substituída)
+    bool valid;
+} reference_entry_t;
+
+// Banco de referências agrupado por cena
 typedef struct {
-    camera_fb_t* day_reference;     // Referência diurna
-    camera_fb_t* night_reference;   // Referência noturna
-    camera_fb_t* clear_reference;   // Referência tempo claro
-    camera_fb_t* weather_reference; // Referência tempo ruim
-    uint64_t last_update_time;
+    reference_entry_t entries[MULTI_REFERENCE_COUNT];
+    int active_index;               // Entrada usada na última seleção (-1 = nenhuma)
+    uint32_t created;               // Clusters criados em entradas livres
+    uint32_t replaced;              // Clusters que substituíram a cena menos usada
 } multi_reference_t;
 
+/**
+ * @brief Resumo de um cluster de cena para telemetria
+ */
+typedef struct {
+    bool valid;                 ///< Entrada ocupada
+    uint32_t members;           ///< Capturas atribuídas
+    uint32_t recent;            ///< Uso recente (com decaimento)
+    uint8_t mean_luma;          ///< Luminância média do centroide
+    uint32_t age_s;             ///< Tempo desde a criação
+    uint32_t idle_s;            ///< Tempo desde a última captura atribuída
+} reference_cluster_info_t;
+
+/**
+ * @brief Estado do banco de clusters
+ */
+typedef struct {
+    int capacity;               ///< Entradas disponíveis (após o teto de memória)
+    int count;                  ///< Entradas ocupadas
+    int active_index;           ///< Cluster da referência ativa (-1 = nenhum)
+    uint32_t created;           ///< Clusters criados em entradas livres
+    uint32_t replaced;          ///< Substituições da cena menos usada
+    size_t memory_bytes;        ///< Memória ocupada pelo banco (slots + planos)
+    reference_cluster_info_t clusters[MULTI_REFERENCE_COUNT];
+} reference_bank_stats_t;
+
 /**
  * @brief Estrutura para estatísticas de eficiência de memória
  */
 typedef struct {
     size_t total_psram_kb;      ///< PSRAM total em KB
     size_t free_psram_kb;       ///< PSRAM livre em KB
-    size_t used_by_analysis_kb; ///< Memória usada pela análise em KB
+    size_t used_by_analysis_kb; ///< Frames e planos do histórico/referências em KB
     float psram_utilization;    ///< Utilização total da PSRAM em %
-    float analysis_efficiency;  ///< Eficiência da análise vs estimado em %
+    size_t tracked_kb;          ///< Memória contabilizada de todos os subsistemas (mem_account)
+    size_t tracked_peak_kb;     ///< Pico da memória contabilizada
     int active_references;      ///< Número de referências ativas
-    int history_frames;         ///< Frames no histórico
+    int history_frames;         ///< Entradas no histórico
+    int history_full_frames;    ///< Entradas com frame completo
+    size_t history_thumb_kb;    ///< Miniaturas do histórico em KB
     float buffer_utilization;   ///< Utilização do buffer em %
+    size_t largest_free_block_kb; ///< Maior bloco contíguo livre na PSRAM (fragmentação)
+    size_t plane_cache_kb;      ///< Planos decodificados em cache
+    float plane_cache_hit_rate; ///< Acertos / consultas do cache de planos (%)
+    uint32_t oversize_frames;   ///< Frames não copiados para o pool por tamanho
+    int pool_in_use;            ///< Slots do pool de frames com referências
+    int pool_peak;              ///< Maior ocupação do pool de frames
 } memory_efficiency_t;
 
 /**
  * Inicializa o sistema de análise avançada
- * @return ESP_OK se bem-sucedido
+ * @return ESP_OK se bem-sucedido, ESP_ERR_INVALID_STATE sem pool de frames
  */
 esp_err_t advanced_analysis_init(void);
 
 /**
  * Adiciona uma nova imagem ao buffer de histórico
- * @param frame Frame a ser adicionado
+ * @param frame Frame a ser adicionado (copiado para o pool)
  * @param difference Diferença calculada
  * @return ESP_OK se bem-sucedido
  */
 esp_err_t add_to_history(camera_fb_t* frame, float difference);
 
+/**
+ * Adiciona um frame ao histórico reaproveitando o plano já decodificado
+ * @param frame Frame a ser adicionado (copiado para o pool)
+ * @param difference Diferença calculada
+ * @param plane Plano reduzido do frame (NULL = decodificar quando necessário)
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t add_to_history_with_plane(camera_fb_t* frame, float difference, const luma_plane_t* plane);
+
+/**
+ * Adiciona ao histórico um frame já compartilhado, sem nova cópia
+ * 
+ * O histórico passa a ser dono de uma referência do handle e o plano vai
+ * para o plane_cache. A miniatura é codificada a partir do plano; o frame
+ * completo é devolvido quando a entrada sai das HISTORY_BUFFER_SIZE mais
+ * recentes (exceto eventos). Sem handle (frame grande demais ou pool
+ * esgotado), ficam diferença, timestamp e a miniatura do plano fornecido.
+ * 
+ * @param handle Frame compartilhado (NULL = sem frame completo)
+ * @param difference Diferença calculada
+ * @param plane Plano reduzido do frame (NULL = decodificar do handle quando necessário)
+ * @return ESP_OK se bem-sucedido, ESP_ERR_INVALID_SIZE sem handle
+ */
+esp_err_t add_handle_to_history(frame_handle_t* handle, float difference, const luma_plane_t* plane);
+
+/**
+ * Marca a entrada mais recente como evento: o frame completo é mantido
+ * depois que ela sai da janela recente
+ * 
+ * Ao exceder HISTORY_EVENT_FRAMES, o evento mais antigo passa a ter só a miniatura.
+ * 
+ * @return ESP_OK se bem-sucedido, ESP_ERR_INVALID_STATE com histórico vazio,
+ *         ESP_ERR_NOT_SUPPORTED sem miniaturas ou sem cota de eventos
+ */
+esp_err_t mark_history_event(void);
+
+/**
+ * Consulta uma entrada do histórico (usada pelo clipe pré-alerta)
+ * @param age 0 = mais recente, até count - 1
+ * @param entry Saída: miniatura, frame completo (se retido) e metadados
+ * @return ESP_OK se bem-sucedido, ESP_ERR_NOT_FOUND fora do histórico
+ */
+esp_err_t get_history_entry(int age, history_entry_view_t* entry);
+
+/**
+ * Diferenciação de três frames sobre os planos em cache do histórico
+ * @param result Estrutura para armazenar resultados
+ * @return ESP_OK se bem-sucedido, ESP_ERR_INVALID_STATE com menos de 3 planos
+ */
+esp_err_t detect_three_frame_change(three_frame_result_t* result);
+
 /**
  * Realiza análise temporal baseada no histórico
  * @param analysis Estrutura para armazenar resultados
@@ -90,21 +249,53 @@ esp_err_t add_to_history(camera_fb_t* frame, float difference);
 esp_err_t perform_temporal_analysis(temporal_analysis_t* analysis);
 
 /**
- * Atualiza as referências múltiplas baseado nas condições
- * @param current_frame Frame atual
- * @param time_of_day Hora do dia (0-23)
- * @param weather_condition Condição climática estimada
+ * Grava o frame atual no banco de referências
+ * 
+ * Se o centroide mais próximo estiver a até REFERENCE_MATCH_DISTANCE, o
+ * representante desse cluster é renovado; senão a cena nova ocupa uma
+ * entrada livre ou substitui o cluster menos usado recentemente. Só as
+ * renovações de referência criam clusters, então um objeto de passagem
+ * não vira cena. As referências compartilham o handle do frame (sem cópia).
+ * 
+ * @param current_frame Frame atual já copiado para o pool
+ * @param plane Plano reduzido do frame (NULL = decodificar do handle)
+ * @param signature Assinatura do frame
+ * @return Índice da entrada gravada, ou -1 em erro
+ */
+int update_multi_references(frame_handle_t* current_frame, const luma_plane_t* plane,
+                            const frame_signature_t* signature);
+
+/**
+ * Atribui a captura ao cluster de centroide mais próximo
+ * 
+ * Com o plano, os clusters a até REFERENCE_SHORTLIST_MARGIN do mais
+ * próximo (no máximo REFERENCE_SHORTLIST) são comparados pixel a pixel em
+ * um único lote e vence o de menor mudança; a referência ativa só perde
+ * por mais de REFERENCE_SCORE_MARGIN. Sem lote, a ativa só é trocada se o
+ * candidato for mais próximo por pelo menos REFERENCE_SWITCH_MARGIN.
+ * Capturas a até REFERENCE_MATCH_DISTANCE contam como membros e ajustam o
+ * centroide.
+ * 
+ * @param signature Assinatura da captura atual
+ * @param plane Plano reduzido da captura (NULL = só assinatura)
+ * @param distance Saída: distância ao centroide escolhido (pode ser NULL)
+ * @return Índice da entrada, ou -1 com o banco vazio
+ */
+int select_similar_reference(const frame_signature_t* signature, luma_plane_t* plane, float* distance);
+
+/**
+ * Estado dos clusters de cena (contagens de membros para telemetria)
+ * @param stats Saída
  * @return ESP_OK se bem-sucedido
  */
-esp_err_t update_multi_references(camera_fb_t* current_frame, int time_of_day, int weather_condition);
+esp_err_t get_reference_bank_stats(reference_bank_stats_t* stats);
 
 /**
- * Seleciona a melhor referência para comparação
- * @param time_of_day Hora do dia atual
- * @param weather_condition Condição climática atual
- * @return Ponteiro para a melhor referência
+ * Entrada do banco de referências
+ * @param index Índice retornado por select_similar_reference()
+ * @return Entrada válida ou NULL
  */
-camera_fb_t* get_best_reference(int time_of_day, int weather_condition);
+reference_entry_t* get_reference_entry(int index);
 
 /**
  * Calcula índice de estabilidade da cena
@@ -113,14 +304,16 @@ camera_fb_t* get_best_reference(int time_of_day, int weather_condition);
 float calculate_stability_index(void);
 
 /**
- * Detecta padrões anômalos no histórico
+ * Verifica se a diferença mais recente do histórico é atípica para a câmera
+ * (acima do p99 e a ROBUST_ANOMALY_Z desvios robustos da mediana)
  * @return true se anomalia detectada
  */
 bool detect_anomaly_pattern(void);
 
 /**
  * Obtém estatísticas do buffer de histórico
- * @param used_memory Memória usada em bytes
+ * @param used_memory Memória usada em bytes (JPEGs retidos pelo tamanho real,
+ *        planos em cache e área de miniaturas)
  * @param buffer_utilization Utilização do buffer (0.0-1.0)
  * @return ESP_OK se bem-sucedido
  */
@@ -1,180 +1,1130 @@
 /**
  * @file compare.c
  * @brief Implementação da comparação de imagens otimizada para HVGA
- * 
+ *
  * Este módulo implementa:
- * - Comparação de imagens usando RGB565 para eficiência
- * - Análise por blocos 16x16 com amostragem
+ * - Decodificação JPEG em escala reduzida para plano de luminância
+ * - Análise por blocos 16x16 no plano reduzido (32x32 em HVGA)
+ * - Comparação em lote contra múltiplas referências em cache
+ * - Engines selecionáveis: SAD de luminância, SSIM inteiro e densidade de bordas
+ * - Máscara aprendida de blocos que mudam em quase toda captura
+ * - Limiares escalados pelo ganho do sensor (tabela de ruído calibrada)
  * - Algoritmo otimizado para resolução HVGA (480x320)
- * 
+ *
  * @author Gabriel Passos - UNESP 2025
  */
 #include "compare.h"
 #include "esp_log.h"
 #include "config.h"
 #include "esp_camera.h"
+#include "esp_timer.h"
 #include "img_converters.h"
-#include "esp_heap_caps.h"
+#include "mem_account.h"
+#include "nvs.h"
+#include "noise_gain_table.h"
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 
 static const char *TAG = "IMG_COMPARE";
 
+// Configurações melhoradas para detecção robusta
+#define BLOCK_DIFF_THRESHOLD   60   // Threshold mais alto para filtrar ruído
+#define NOISE_FLOOR            15   // Piso de ruído base
+#define MIN_SIGNIFICANT_BLOCKS 3    // Mínimo de blocos para considerar mudança
+#define SSIM_BLOCK_THRESHOLD   64   // Dissimilaridade SSIM (0-255) para bloco alterado (SSIM < 0.5)
+#define EDGE_MAGNITUDE_THRESHOLD 96 // |gx|+|gy| Sobel mínimo para pixel de borda
+#define EDGE_DENSITY_THRESHOLD 40   // Variação de densidade de bordas (0-255) para bloco alterado
+#define LEGACY_BLOCK_SIZE      32   // Métrica anterior: blocos na resolução cheia
+#define LEGACY_SAMPLE_STEP     6    // Métrica anterior: um pixel a cada 6 em cada eixo
+
+// Persistência da máscara de regiões ruidosas
+#define NUISANCE_NVS_NAMESPACE "compare"
+#define NUISANCE_NVS_KEY       "nuisance"
+#define ENGINE_NVS_KEY         "engine"    // u8 opcional: sobrescreve COMPARE_DEFAULT_ENGINE no boot
+#define NUISANCE_VERSION       1
+#define NUISANCE_RATE_ONE      65535   // Taxa 100% em Q16
+#define NUISANCE_PCT_TO_Q16(p) ((uint32_t)(p) * NUISANCE_RATE_ONE / 100)
+
 /**
- * Algoritmo principal de comparação de imagens
- * Otimizado para HVGA (480x320) com qualidade JPEG 5
+ * Frequência de mudança por bloco (média móvel exponencial em Q16)
+ * Gravada na NVS como blob único
  */
-float calculate_image_difference(camera_fb_t* frame1, camera_fb_t* frame2) {
-    if (!frame1 || !frame2) {
-        ESP_LOGE(TAG, "Frames inválidos");
+typedef struct {
+    uint16_t version;
+    uint16_t blocks;
+    uint32_t samples;                       // Comparações acumuladas
+    uint16_t rate[COMPARE_MAX_BLOCKS];      // Fração de capturas com mudança (Q16)
+    uint8_t masked[COMPARE_MAX_BLOCKS];     // 1 = bloco ignorado na contagem
+} nuisance_state_t;
+
+static nuisance_state_t nuisance = {
+    .version = NUISANCE_VERSION,
+    .blocks = COMPARE_MAX_BLOCKS,
+};
+static uint32_t nuisance_pending_updates = 0;
+
+// Blocos excluídos por módulos externos (ex.: lente obstruída)
+static uint8_t exclusion_mask[COMPARE_MAX_BLOCKS];
+static bool exclusion_active = false;
+
+// Buffer RGB565 temporário da decodificação (reutilizado entre chamadas)
+static uint8_t *rgb565_scratch = NULL;
+static size_t rgb565_scratch_size = 0;
+static const uint8_t *scratch_pixels = NULL;   // Plano cuja cor está no buffer (NULL = nenhum)
+
+// Buffer das decodificações que não retêm cor (planos em cache, referências)
+static uint8_t *rgb565_aside = NULL;
+static size_t rgb565_aside_size = 0;
+
+// Faixa de linhas em RAM interna para o cálculo de gradiente
+static uint8_t *edge_band = NULL;
+static size_t edge_band_size = 0;
+
+/**
+ * Garante que o plano tenha buffer para as dimensões pedidas
+ */
+static esp_err_t ensure_plane(luma_plane_t* plane, uint16_t width, uint16_t height) {
+    // Pixels serão reescritos ou realocados: a cor do buffer deixa de ser deles
+    if (plane->pixels && plane->pixels == scratch_pixels) {
+        scratch_pixels = NULL;
+    }
+
+    if (plane->pixels && plane->width == width && plane->height == height) {
+        return ESP_OK;
+    }
+
+    if (plane->pixels) {
+        mem_free(plane->pixels);
+        plane->pixels = NULL;
+    }
+
+    plane->pixels = (uint8_t *)mem_alloc(MEM_TAG_COMPARE, (size_t)width * height, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!plane->pixels) {
+        ESP_LOGE(TAG, "Falha ao alocar plano de luminância %ux%u", width, height);
+        plane->width = 0;
+        plane->height = 0;
+        return ESP_ERR_NO_MEM;
+    }
+
+    plane->width = width;
+    plane->height = height;
+    return ESP_OK;
+}
+
+/**
+ * Garante um buffer RGB565 de pelo menos size bytes (reutilizado entre chamadas)
+ */
+static esp_err_t ensure_scratch(uint8_t** buffer, size_t* buffer_size, size_t size) {
+    if (*buffer_size >= size) {
+        return ESP_OK;
+    }
+    if (*buffer) {
+        mem_free(*buffer);
+    }
+    *buffer = (uint8_t *)mem_alloc(MEM_TAG_COMPARE, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    *buffer_size = *buffer ? size : 0;
+    if (!*buffer) {
+        ESP_LOGE(TAG, "Falha ao alocar buffer RGB565");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Decodifica o JPEG em rgb565 (já na escala reduzida) e converte para luminância
+ */
+static esp_err_t decode_into(const camera_fb_t* frame, luma_plane_t* plane, uint8_t* rgb565) {
+    uint16_t width = frame->width >> COMPARE_SCALE_SHIFT;
+    uint16_t height = frame->height >> COMPARE_SCALE_SHIFT;
+    size_t pixel_count = (size_t)width * height;
+
+    if (ensure_plane(plane, width, height) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Pixels serão substituídos: invalidar mapas derivados em cache
+    plane->edges_valid = false;
+    plane->gain_x16 = 0;
+
+    if (!jpg2rgb565(frame->buf, frame->len, rgb565, (jpg_scale_t)COMPARE_SCALE_SHIFT)) {
+        ESP_LOGE(TAG, "Falha ao decodificar JPEG");
+        return ESP_FAIL;
+    }
+
+    // Converter para luminância
+    const uint8_t *src = rgb565;
+    uint8_t *dst = plane->pixels;
+    for (size_t i = 0; i < pixel_count; i++, src += 2) {
+        // RGB565: RRRRRGGGGGGBBBBB
+        uint16_t pixel = ((uint16_t)src[0] << 8) | src[1];
+        int r = (pixel >> 11) & 0x1F;
+        int g = (pixel >> 5) & 0x3F;
+        int b = pixel & 0x1F;
+
+        // Converter para escala 0-255 e calcular luminância
+        r = (r << 3) | (r >> 2);
+        g = (g << 2) | (g >> 4);
+        b = (b << 3) | (b >> 2);
+
+        dst[i] = (uint8_t)((r * 77 + g * 150 + b * 29) >> 8);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t compare_decode_luma(const camera_fb_t* frame, luma_plane_t* plane) {
+    if (!frame || !plane || !frame->buf) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Buffer RGB565 reduzido (1/4 da área com COMPARE_SCALE_SHIFT = 1)
+    size_t pixel_count = (size_t)(frame->width >> COMPARE_SCALE_SHIFT) * (frame->height >> COMPARE_SCALE_SHIFT);
+    if (ensure_scratch(&rgb565_scratch, &rgb565_scratch_size, pixel_count * 2) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // A cor no buffer passa a ser deste plano só se a decodificação concluir
+    scratch_pixels = NULL;
+    esp_err_t err = decode_into(frame, plane, rgb565_scratch);
+    if (err == ESP_OK) {
+        scratch_pixels = plane->pixels;
+    }
+    return err;
+}
+
+esp_err_t compare_decode_luma_only(const camera_fb_t* frame, luma_plane_t* plane) {
+    if (!frame || !plane || !frame->buf) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t pixel_count = (size_t)(frame->width >> COMPARE_SCALE_SHIFT) * (frame->height >> COMPARE_SCALE_SHIFT);
+    if (ensure_scratch(&rgb565_aside, &rgb565_aside_size, pixel_count * 2) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    return decode_into(frame, plane, rgb565_aside);
+}
+
+esp_err_t compare_copy_luma(const luma_plane_t* src, luma_plane_t* dst) {
+    if (!src || !dst || !src->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (ensure_plane(dst, src->width, src->height) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    memcpy(dst->pixels, src->pixels, (size_t)src->width * src->height);
+    memcpy(dst->edge_density, src->edge_density, sizeof(dst->edge_density));
+    dst->edges_valid = src->edges_valid;
+    dst->gain_x16 = src->gain_x16;
+    return ESP_OK;
+}
+
+void compare_free_luma(luma_plane_t* plane) {
+    if (!plane) return;
+
+    if (plane->pixels) {
+        if (plane->pixels == scratch_pixels) {
+            scratch_pixels = NULL;
+        }
+        mem_free(plane->pixels);
+    }
+    memset(plane, 0, sizeof(luma_plane_t));
+}
+
+/**
+ * Converte contagem de blocos alterados em percentual com os filtros de ruído
+ */
+static float finalize_change_percentage(int changed_blocks, int total_blocks) {
+    if (total_blocks <= 0) {
         return 0.0f;
     }
-    
-    // Verificar se as imagens têm o mesmo tamanho
-    if (frame1->width != frame2->width || frame1->height != frame2->height) {
-        ESP_LOGE(TAG, "Imagens com tamanhos diferentes: %dx%d vs %dx%d",
-                 frame1->width, frame1->height, frame2->width, frame2->height);
-        return 50.0f; // Retorna diferença máxima
+
+    // Filtro de ruído melhorado - verificar blocos mínimos
+    if (changed_blocks < MIN_SIGNIFICANT_BLOCKS) {
+        ESP_LOGD(TAG, "Blocos alterados (%d) abaixo do mínimo (%d) - considerado ruído",
+                 changed_blocks, MIN_SIGNIFICANT_BLOCKS);
+        return 0.0f;
+    }
+
+    // Calcular porcentagem de mudança
+    float change_percentage = (float)changed_blocks / (float)total_blocks * 100.0f;
+
+    ESP_LOGD(TAG, "Blocos analisados: %d, mudados: %d, mudança: %.1f%%",
+             total_blocks, changed_blocks, change_percentage);
+
+    // Aplicar filtro de ruído aprimorado
+    if (change_percentage < 3.0f) {
+        ESP_LOGD(TAG, "Mudança %.1f%% considerada ruído (< 3.0%%)", change_percentage);
+        return 0.0f; // Ignorar mudanças menores que 3%
+    }
+
+    // Suavizar pequenas flutuações
+    if (change_percentage < 8.0f) {
+        change_percentage *= 0.8f; // Reduzir sensibilidade para mudanças pequenas
+        ESP_LOGD(TAG, "Mudança pequena suavizada para: %.1f%%", change_percentage);
+    }
+
+    return change_percentage;
+}
+
+// Engine de comparação ativo (selecionável em tempo de execução)
+static compare_engine_t active_engine = (compare_engine_t)COMPARE_DEFAULT_ENGINE;
+
+/**
+ * Dissimilaridade SAD do bloco (0-255) com piso de ruído aplicado
+ */
+static inline uint8_t sad_block_score(uint32_t block_diff_sum, int pixels, int noise_floor) {
+    int avg_diff = block_diff_sum / pixels;
+
+    // Aplicar piso de ruído - ignorar diferenças muito pequenas
+    if (avg_diff <= noise_floor) {
+        return 0;
+    }
+
+    return (uint8_t)(avg_diff > 255 ? 255 : avg_diff);
+}
+
+/**
+ * SSIM inteiro do bloco a partir das somas acumuladas em uma passada
+ * Retorna a dissimilaridade estrutural (1 - SSIM) / 2 escalada para 0-255
+ */
+static uint8_t ssim_block_score(int64_t n, int64_t sx, int64_t sy,
+                                int64_t sxx, int64_t syy, int64_t sxy) {
+    // Constantes de estabilização escaladas por N²: C1 = (0.01*255)², C2 = (0.03*255)²
+    const int64_t c1 = (65025LL * n * n) / 10000;
+    const int64_t c2 = (585225LL * n * n) / 10000;
+
+    // Média, variância e covariância em unidades de N² (sem divisões)
+    int64_t num1 = 2 * sx * sy + c1;
+    int64_t den1 = sx * sx + sy * sy + c1;
+    int64_t num2 = 2 * (n * sxy - sx * sy) + c2;
+    int64_t den2 = (n * sxx - sx * sx) + (n * syy - sy * sy) + c2;
+
+    // Termos de luminância e estrutura em Q16, separados para não estourar 64 bits
+    int64_t lum_q16 = (num1 * 65536) / den1;
+    int64_t struct_q16 = (num2 * 65536) / den2;
+    int64_t ssim_q16 = (lum_q16 * struct_q16) / 65536;
+
+    int64_t dissim = ((65536 - ssim_q16) * 255) / 131072;
+    if (dissim < 0) dissim = 0;
+    if (dissim > 255) dissim = 255;
+    return (uint8_t)dissim;
+}
+
+static inline int engine_block_threshold(compare_engine_t engine) {
+    switch (engine) {
+        case COMPARE_ENGINE_SSIM:     return SSIM_BLOCK_THRESHOLD;
+        case COMPARE_ENGINE_GRADIENT: return EDGE_DENSITY_THRESHOLD;
+        default:                      return BLOCK_DIFF_THRESHOLD;
+    }
+}
+
+/**
+ * Escala de ruído (Q8) para um ganho, interpolada entre as oitavas da tabela
+ */
+static uint16_t noise_scale_for_gain(uint16_t gain_x16) {
+    // Ganho desconhecido ou 1x: limiares originais
+    if (!GAIN_AWARE_THRESHOLDS || gain_x16 <= 16) {
+        return 256;
+    }
+
+    int stop = 0;
+    while (stop < NOISE_GAIN_TABLE_SIZE - 1 && gain_x16 >= (32 << stop)) {
+        stop++;
+    }
+    if (stop == NOISE_GAIN_TABLE_SIZE - 1) {
+        return noise_gain_scale_q8[stop];
+    }
+
+    uint32_t base = 16u << stop;
+    int32_t frac = (int32_t)(((gain_x16 - base) * 256) / base);
+    int32_t low = noise_gain_scale_q8[stop];
+    int32_t high = noise_gain_scale_q8[stop + 1];
+    return (uint16_t)(low + (((high - low) * frac) >> 8));
+}
+
+/**
+ * Calcula a densidade de bordas por bloco (Sobel inteiro) com cache no plano
+ *
+ * O plano fica na PSRAM; cada faixa de blocos (mais uma linha de borda acima
+ * e abaixo) é copiada para um buffer em RAM interna antes do cálculo.
+ */
+static esp_err_t compute_edge_density(luma_plane_t* plane) {
+    if (plane->edges_valid) {
+        return ESP_OK;
+    }
+
+    const int width = plane->width;
+    const int blocks_x = plane->width / COMPARE_BLOCK_SIZE;
+    const int blocks_y = plane->height / COMPARE_BLOCK_SIZE;
+    const int band_rows = COMPARE_BLOCK_SIZE + 2;
+    const int pixels_per_block = COMPARE_BLOCK_SIZE * COMPARE_BLOCK_SIZE;
+
+    size_t needed = (size_t)band_rows * width;
+    if (edge_band_size < needed) {
+        if (edge_band) {
+            mem_free(edge_band);
+        }
+        edge_band = (uint8_t *)mem_alloc(MEM_TAG_COMPARE, needed, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        edge_band_size = edge_band ? needed : 0;
+        if (!edge_band) {
+            ESP_LOGE(TAG, "Falha ao alocar faixa de bordas em RAM interna");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    uint16_t edge_count[COMPARE_BLOCKS_X];
+
+    for (int by = 0; by < blocks_y; by++) {
+        // Copiar faixa com uma linha extra acima/abaixo (replicada nas bordas da imagem)
+        int first_row = by * COMPARE_BLOCK_SIZE - 1;
+        for (int i = 0; i < band_rows; i++) {
+            int src_row = first_row + i;
+            if (src_row < 0) src_row = 0;
+            if (src_row >= plane->height) src_row = plane->height - 1;
+            memcpy(edge_band + (size_t)i * width, plane->pixels + (size_t)src_row * width, width);
+        }
+
+        memset(edge_count, 0, sizeof(edge_count));
+        for (int y = 1; y <= COMPARE_BLOCK_SIZE; y++) {
+            const uint8_t *above = edge_band + (size_t)(y - 1) * width;
+            const uint8_t *row = edge_band + (size_t)y * width;
+            const uint8_t *below = edge_band + (size_t)(y + 1) * width;
+
+            for (int x = 1; x < blocks_x * COMPARE_BLOCK_SIZE - 1 && x < width - 1; x++) {
+                int gx = (above[x + 1] + 2 * row[x + 1] + below[x + 1]) -
+                         (above[x - 1] + 2 * row[x - 1] + below[x - 1]);
+                int gy = (below[x - 1] + 2 * below[x] + below[x + 1]) -
+                         (above[x - 1] + 2 * above[x] + above[x + 1]);
+
+                // Magnitude aproximada |gx| + |gy| (sem raiz quadrada)
+                if (abs(gx) + abs(gy) > EDGE_MAGNITUDE_THRESHOLD) {
+                    edge_count[x / COMPARE_BLOCK_SIZE]++;
+                }
+            }
+        }
+
+        for (int bx = 0; bx < blocks_x; bx++) {
+            plane->edge_density[by * blocks_x + bx] = (uint8_t)((edge_count[bx] * 255) / pixels_per_block);
+        }
+    }
+
+    plane->edges_valid = true;
+    return ESP_OK;
+}
+
+static bool planes_compatible(const luma_plane_t* a, const luma_plane_t* b) {
+    return a && b && a->pixels && b->pixels && a->width == b->width && a->height == b->height;
+}
+
+/**
+ * Núcleo de comparação em passada única contra N referências
+ *
+ * Estatísticas do plano atual são acumuladas uma vez por bloco e cada
+ * referência acumula apenas os seus termos. Se result != NULL, recebe o
+ * mapa por bloco da primeira referência.
+ */
+static esp_err_t compare_kernel(compare_engine_t engine, luma_plane_t* current,
+                                luma_plane_t* const refs[], int ref_count,
+                                float* scores, int* best_index, compare_result_t* result) {
+    if (!current || !current->pixels || !refs || !scores || !best_index ||
+        ref_count <= 0 || ref_count > COMPARE_MAX_BATCH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Apenas referências compatíveis participam da passada
+    const uint8_t *active[COMPARE_MAX_BATCH];
+    luma_plane_t *active_planes[COMPARE_MAX_BATCH];
+    int active_map[COMPARE_MAX_BATCH];
+    int active_count = 0;
+
+    for (int r = 0; r < ref_count; r++) {
+        scores[r] = -1.0f;
+        if (planes_compatible(current, refs[r])) {
+            active[active_count] = refs[r]->pixels;
+            active_planes[active_count] = refs[r];
+            active_map[active_count] = r;
+            active_count++;
+        } else if (refs[r]) {
+            ESP_LOGW(TAG, "Referência %d ignorada (plano ausente ou tamanho diferente)", r);
+        }
+    }
+
+    *best_index = -1;
+    if (active_count == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const int width = current->width;
+    int blocks_x = current->width / COMPARE_BLOCK_SIZE;
+    int blocks_y = current->height / COMPARE_BLOCK_SIZE;
+    int total_blocks = blocks_x * blocks_y;
+
+    if (total_blocks > COMPARE_MAX_BLOCKS) {
+        ESP_LOGE(TAG, "Plano %ux%u excede a grade configurada (%d blocos)",
+                 current->width, current->height, COMPARE_MAX_BLOCKS);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Gradiente: mapas de densidade de bordas (referências usam o cache do plano)
+    if (engine == COMPARE_ENGINE_GRADIENT) {
+        if (compute_edge_density(current) != ESP_OK) {
+            return ESP_ERR_NO_MEM;
+        }
+        for (int r = 0; r < active_count; r++) {
+            if (compute_edge_density(active_planes[r]) != ESP_OK) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+    }
+
+    const int pixels_per_block = COMPARE_BLOCK_SIZE * COMPARE_BLOCK_SIZE;
+    const bool use_mask = NUISANCE_MASK_ENABLED && total_blocks == nuisance.blocks;
+    const bool use_exclusion = exclusion_active && total_blocks <= COMPARE_MAX_BLOCKS;
+    int masked_blocks = 0;
+    int excluded_blocks = 0;
+    int texture_lost = 0, texture_gained = 0;
+    int changed_blocks[COMPARE_MAX_BATCH] = {0};
+    uint32_t total_score[COMPARE_MAX_BATCH] = {0};
+    uint32_t sum_d[COMPARE_MAX_BATCH];   // SAD: soma |c - r| / SSIM: soma r
+    uint32_t sum_rr[COMPARE_MAX_BATCH];  // SSIM: soma r²
+    uint32_t sum_cr[COMPARE_MAX_BATCH];  // SSIM: soma c·r
+    int threshold[COMPARE_MAX_BATCH];    // Limiar por bloco escalado pelo ganho
+    int noise_floor[COMPARE_MAX_BATCH];  // SAD: piso de ruído escalado pelo ganho
+
+    // O frame mais ruidoso do par (maior ganho) define a escala
+    for (int r = 0; r < active_count; r++) {
+        uint16_t gain = current->gain_x16 > active_planes[r]->gain_x16 ?
+                        current->gain_x16 : active_planes[r]->gain_x16;
+        uint32_t scale = noise_scale_for_gain(gain);
+        threshold[r] = (int)((engine_block_threshold(engine) * scale) >> 8);
+        if (threshold[r] > 254) threshold[r] = 254;
+        noise_floor[r] = (int)((NOISE_FLOOR * scale) >> 8);
+    }
+
+    for (int by = 0; by < blocks_y; by++) {
+        for (int bx = 0; bx < blocks_x; bx++) {
+            uint32_t sum_c = 0, sum_cc = 0;
+            memset(sum_d, 0, sizeof(sum_d));
+            memset(sum_rr, 0, sizeof(sum_rr));
+            memset(sum_cr, 0, sizeof(sum_cr));
+
+            // Passada única: cada pixel atual é lido uma vez para todas as referências
+            for (int y = 0; y < COMPARE_BLOCK_SIZE && engine != COMPARE_ENGINE_GRADIENT; y++) {
+                size_t row = (size_t)(by * COMPARE_BLOCK_SIZE + y) * width + bx * COMPARE_BLOCK_SIZE;
+                const uint8_t *cur = current->pixels + row;
+
+                if (engine == COMPARE_ENGINE_SSIM) {
+                    for (int x = 0; x < COMPARE_BLOCK_SIZE; x++) {
+                        uint32_t c = cur[x];
+                        sum_c += c;
+                        sum_cc += c * c;
+                        for (int r = 0; r < active_count; r++) {
+                            uint32_t v = active[r][row + x];
+                            sum_d[r] += v;
+                            sum_rr[r] += v * v;
+                            sum_cr[r] += c * v;
+                        }
+                    }
+                } else {
+                    for (int x = 0; x < COMPARE_BLOCK_SIZE; x++) {
+                        int c = cur[x];
+                        for (int r = 0; r < active_count; r++) {
+                            sum_d[r] += abs(c - active[r][row + x]);
+                        }
+                    }
+                }
+            }
+
+            int block_index = by * blocks_x + bx;
+            bool excluded = use_exclusion && exclusion_mask[block_index];
+            bool masked = !excluded && use_mask && nuisance.masked[block_index];
+            masked_blocks += masked;
+            excluded_blocks += excluded;
+
+            for (int r = 0; r < active_count; r++) {
+                uint8_t score;
+                int texture_delta = 0;
+
+                if (engine == COMPARE_ENGINE_SSIM) {
+                    score = ssim_block_score(pixels_per_block, sum_d[r], sum_c, sum_rr[r], sum_cc, sum_cr[r]);
+                } else if (engine == COMPARE_ENGINE_GRADIENT) {
+                    texture_delta = (int)current->edge_density[block_index] -
+                                    (int)active_planes[r]->edge_density[block_index];
+                    score = (uint8_t)abs(texture_delta);
+                } else {
+                    score = sad_block_score(sum_d[r], pixels_per_block, noise_floor[r]);
+                }
+
+                // Mapa por bloco sempre completo: a máscara aprende com os scores brutos
+                if (result && r == 0) {
+                    result->block_scores[block_index] = score;
+                    result->texture_delta[block_index] = (int8_t)(texture_delta / 2);
+                }
+                if (masked || excluded) {
+                    continue;
+                }
+
+                total_score[r] += score;
+                if (score > threshold[r]) {
+                    changed_blocks[r]++;
+                }
+                if (result && r == 0) {
+                    if (score > threshold[r]) {
+                        if (texture_delta < 0) texture_lost++;
+                        else texture_gained++;
+                    }
+                }
+            }
+        }
+    }
+
+    // Blocos mascarados ou excluídos saem também do denominador
+    int analyzed_blocks = total_blocks - masked_blocks - excluded_blocks;
+
+    // Converter em percentuais e escolher a referência mais parecida
+    int best = -1;
+    for (int r = 0; r < active_count; r++) {
+        float score = finalize_change_percentage(changed_blocks[r], analyzed_blocks);
+        scores[active_map[r]] = score;
+
+        if (best < 0 || score < scores[active_map[best]] ||
+            (score == scores[active_map[best]] && total_score[r] < total_score[best])) {
+            best = r;
+        }
+    }
+
+    if (result) {
+        result->engine = engine;
+        result->difference = scores[active_map[0]];
+        result->changed_blocks = changed_blocks[0];
+        result->total_blocks = analyzed_blocks;
+        result->masked_blocks = masked_blocks;
+        result->excluded_blocks = excluded_blocks;
+        result->block_threshold = threshold[0];
+        if (analyzed_blocks > 0) {
+            result->texture_lost = (float)texture_lost / (float)analyzed_blocks * 100.0f;
+            result->texture_gained = (float)texture_gained / (float)analyzed_blocks * 100.0f;
+        }
+    }
+
+    *best_index = active_map[best];
+    return ESP_OK;
+}
+
+void compare_set_engine(compare_engine_t engine) {
+    if (engine < COMPARE_ENGINE_SAD || engine > COMPARE_ENGINE_GRADIENT) {
+        ESP_LOGW(TAG, "Engine de comparação inválido: %d", engine);
+        return;
+    }
+
+    if (engine != active_engine) {
+        ESP_LOGI(TAG, "🔀 Engine de comparação: %s -> %s",
+                 compare_engine_name(active_engine), compare_engine_name(engine));
+        active_engine = engine;
+    }
+}
+
+esp_err_t compare_engine_init(void) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NUISANCE_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t engine = 0;
+    err = nvs_get_u8(handle, ENGINE_NVS_KEY, &engine);
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "🔀 Engine de comparação padrão: %s", compare_engine_name(active_engine));
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (engine > COMPARE_ENGINE_GRADIENT) {
+        ESP_LOGW(TAG, "Engine salvo na NVS inválido (%u) - mantendo %s", engine,
+                 compare_engine_name(active_engine));
+        return ESP_ERR_INVALID_ARG;
+    }
+    compare_set_engine((compare_engine_t)engine);
+    return ESP_OK;
+}
+
+compare_engine_t compare_get_engine(void) {
+    return active_engine;
+}
+
+const char* compare_engine_name(compare_engine_t engine) {
+    switch (engine) {
+        case COMPARE_ENGINE_SAD:  return "sad";
+        case COMPARE_ENGINE_SSIM: return "ssim";
+        case COMPARE_ENGINE_GRADIENT: return "gradient";
+        default:                  return "unknown";
     }
-    
-    // Alocar buffers RGB565 (mais eficiente que RGB888)
+}
+
+esp_err_t compare_luma_batch(luma_plane_t* current, luma_plane_t* const refs[], int ref_count,
+                             float* scores, int* best_index) {
+    return compare_kernel(active_engine, current, refs, ref_count, scores, best_index, NULL);
+}
+
+esp_err_t compare_luma_planes_ex(luma_plane_t* reference, luma_plane_t* current, compare_result_t* result) {
+    if (!result) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(result, 0, sizeof(compare_result_t));
+    if (!planes_compatible(reference, current)) {
+        ESP_LOGE(TAG, "Planos inválidos ou com tamanhos diferentes");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    luma_plane_t* refs[1] = { reference };
+    float score = 0.0f;
+    int best = -1;
+
+    return compare_kernel(active_engine, current, refs, 1, &score, &best, result);
+}
+
+float compare_luma_planes(luma_plane_t* reference, luma_plane_t* current) {
+    compare_result_t result;
+
+    if (compare_luma_planes_ex(reference, current, &result) != ESP_OK) {
+        return 0.0f;
+    }
+
+    return result.difference;
+}
+
+// Luminância 0-255 de um pixel RGB565 (big-endian, como entregue por jpg2rgb565)
+static inline int rgb565_luma(const uint8_t* px) {
+    uint16_t pixel = ((uint16_t)px[0] << 8) | px[1];
+    int r = (pixel >> 11) & 0x1F;
+    int g = (pixel >> 5) & 0x3F;
+    int b = pixel & 0x1F;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+/**
+ * Métrica anterior aos planos reduzidos: decodificação na resolução cheia,
+ * blocos 32x32 e 36 amostras por bloco. Mantida porque os limiares foram
+ * calibrados nela e ela ainda acusa traços finos e texturas de 1-2 px que
+ * a média 2x2 do plano reduzido apaga (test_compare_metric)
+ */
+static float legacy_image_difference(camera_fb_t* frame1, camera_fb_t* frame2) {
     size_t rgb565_size = frame1->width * frame1->height * 2;
-    uint8_t *rgb565_buf1 = (uint8_t *)heap_caps_malloc(rgb565_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    uint8_t *rgb565_buf2 = (uint8_t *)heap_caps_malloc(rgb565_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    
+    uint8_t *rgb565_buf1 = (uint8_t *)mem_alloc(MEM_TAG_COMPARE, rgb565_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint8_t *rgb565_buf2 = (uint8_t *)mem_alloc(MEM_TAG_COMPARE, rgb565_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+
     if (!rgb565_buf1 || !rgb565_buf2) {
         ESP_LOGE(TAG, "Falha ao alocar buffers RGB565");
-        if (rgb565_buf1) free(rgb565_buf1);
-        if (rgb565_buf2) free(rgb565_buf2);
-        
+        mem_free(rgb565_buf1);
+        mem_free(rgb565_buf2);
+
         // Fallback para comparação por tamanho
         float size_diff = abs((int)frame1->len - (int)frame2->len);
         float avg_size = (frame1->len + frame2->len) / 2.0f;
         return (size_diff / avg_size) * 100.0f;
     }
-    
-    // Decodificar JPEG para RGB565
-    bool decoded1 = jpg2rgb565(frame1->buf, frame1->len, rgb565_buf1, JPG_SCALE_NONE);
-    bool decoded2 = jpg2rgb565(frame2->buf, frame2->len, rgb565_buf2, JPG_SCALE_NONE);
-    
-    if (!decoded1 || !decoded2) {
+
+    if (!jpg2rgb565(frame1->buf, frame1->len, rgb565_buf1, JPG_SCALE_NONE) ||
+        !jpg2rgb565(frame2->buf, frame2->len, rgb565_buf2, JPG_SCALE_NONE)) {
         ESP_LOGE(TAG, "Falha ao decodificar JPEG");
-        free(rgb565_buf1);
-        free(rgb565_buf2);
+        mem_free(rgb565_buf1);
+        mem_free(rgb565_buf2);
         return 0.0f;
     }
-    
-    // Configurações melhoradas para detecção robusta
-    const int BLOCK_SIZE = 32;           // Blocos maiores para estabilidade
-    const int SAMPLE_RATE = 6;           // Amostragem menos densa
-    const int BLOCK_DIFF_THRESHOLD = 60; // Threshold mais alto para filtrar ruído
-    const int NOISE_FLOOR = 15;          // Piso de ruído base
-    const int MIN_SIGNIFICANT_BLOCKS = 3; // Mínimo de blocos para considerar mudança
-    
-    int blocks_x = frame1->width / BLOCK_SIZE;
-    int blocks_y = frame1->height / BLOCK_SIZE;
-    int total_blocks = blocks_x * blocks_y;
+
+    const int width = frame1->width;
+    const int blocks_x = frame1->width / LEGACY_BLOCK_SIZE;
+    const int blocks_y = frame1->height / LEGACY_BLOCK_SIZE;
     int changed_blocks = 0;
-    
-    // Analisar cada bloco
+
     for (int by = 0; by < blocks_y; by++) {
         for (int bx = 0; bx < blocks_x; bx++) {
             int block_diff_sum = 0;
             int pixels_compared = 0;
-            
-            // Comparar pixels dentro do bloco (com amostragem)
-            for (int y = 0; y < BLOCK_SIZE; y += SAMPLE_RATE) {
-                for (int x = 0; x < BLOCK_SIZE; x += SAMPLE_RATE) {
-                    int px = bx * BLOCK_SIZE + x;
-                    int py = by * BLOCK_SIZE + y;
-                    
-                    if (px < frame1->width && py < frame1->height) {
-                        int idx = (py * frame1->width + px) * 2; // RGB565 = 2 bytes per pixel
-                        
-                        // Extrair componentes RGB565 e converter para luminância
-                        uint16_t pixel1 = ((uint16_t)rgb565_buf1[idx] << 8) | rgb565_buf1[idx + 1];
-                        uint16_t pixel2 = ((uint16_t)rgb565_buf2[idx] << 8) | rgb565_buf2[idx + 1];
-                        
-                        // RGB565: RRRRRGGGGGGBBBBB
-                        int r1 = (pixel1 >> 11) & 0x1F;
-                        int g1 = (pixel1 >> 5) & 0x3F;
-                        int b1 = pixel1 & 0x1F;
-                        
-                        int r2 = (pixel2 >> 11) & 0x1F;
-                        int g2 = (pixel2 >> 5) & 0x3F;
-                        int b2 = pixel2 & 0x1F;
-                        
-                        // Converter para escala 0-255 e calcular luminância
-                        r1 = (r1 << 3) | (r1 >> 2);
-                        g1 = (g1 << 2) | (g1 >> 4);
-                        b1 = (b1 << 3) | (b1 >> 2);
-                        
-                        r2 = (r2 << 3) | (r2 >> 2);
-                        g2 = (g2 << 2) | (g2 >> 4);
-                        b2 = (b2 << 3) | (b2 >> 2);
-                        
-                        int lum1 = (r1 * 77 + g1 * 150 + b1 * 29) >> 8;
-                        int lum2 = (r2 * 77 + g2 * 150 + b2 * 29) >> 8;
-                        
-                        block_diff_sum += abs(lum1 - lum2);
-                        pixels_compared++;
-                    }
+            for (int y = 0; y < LEGACY_BLOCK_SIZE; y += LEGACY_SAMPLE_STEP) {
+                for (int x = 0; x < LEGACY_BLOCK_SIZE; x += LEGACY_SAMPLE_STEP) {
+                    size_t idx = ((size_t)(by * LEGACY_BLOCK_SIZE + y) * width + bx * LEGACY_BLOCK_SIZE + x) * 2;
+                    block_diff_sum += abs(rgb565_luma(rgb565_buf1 + idx) - rgb565_luma(rgb565_buf2 + idx));
+                    pixels_compared++;
                 }
             }
-            
-            // Calcular diferença média do bloco com filtro melhorado
-            if (pixels_compared > 0) {
-                int avg_diff = block_diff_sum / pixels_compared;
-                
-                // Aplicar piso de ruído - ignorar diferenças muito pequenas
-                if (avg_diff <= NOISE_FLOOR) {
-                    avg_diff = 0;
-                }
-                
-                // Verificar se a diferença é significativa
-                if (avg_diff > BLOCK_DIFF_THRESHOLD) {
-                    changed_blocks++;
-                }
+            if (sad_block_score(block_diff_sum, pixels_compared, NOISE_FLOOR) > BLOCK_DIFF_THRESHOLD) {
+                changed_blocks++;
             }
         }
     }
-    
-    // Liberar buffers
-    free(rgb565_buf1);
-    free(rgb565_buf2);
-    
-    // Filtro de ruído melhorado - verificar blocos mínimos
-    if (changed_blocks < MIN_SIGNIFICANT_BLOCKS) {
-        ESP_LOGD(TAG, "Blocos alterados (%d) abaixo do mínimo (%d) - considerado ruído", 
-                 changed_blocks, MIN_SIGNIFICANT_BLOCKS);
+
+    mem_free(rgb565_buf1);
+    mem_free(rgb565_buf2);
+
+    return finalize_change_percentage(changed_blocks, blocks_x * blocks_y);
+}
+
+/**
+ * Algoritmo principal de comparação de imagens
+ * Otimizado para HVGA (480x320) com qualidade JPEG 5
+ * Com COMPARE_LEGACY_METRIC usa a métrica em resolução cheia em que os
+ * limiares foram calibrados; senão, os planos reduzidos
+ */
+float calculate_image_difference(camera_fb_t* frame1, camera_fb_t* frame2) {
+    if (!frame1 || !frame2) {
+        ESP_LOGE(TAG, "Frames inválidos");
         return 0.0f;
     }
-    
-    // Calcular porcentagem de mudança
-    float change_percentage = (float)changed_blocks / (float)total_blocks * 100.0f;
-    
-    ESP_LOGD(TAG, "Blocos analisados: %d, mudados: %d, mudança: %.1f%%",
-             total_blocks, changed_blocks, change_percentage);
-    
-    // Aplicar filtro de ruído aprimorado
-    if (change_percentage < 3.0f) {
-        ESP_LOGD(TAG, "Mudança %.1f%% considerada ruído (< 3.0%%)", change_percentage);
-        return 0.0f; // Ignorar mudanças menores que 3%
+
+    // Verificar se as imagens têm o mesmo tamanho
+    if (frame1->width != frame2->width || frame1->height != frame2->height) {
+        ESP_LOGE(TAG, "Imagens com tamanhos diferentes: %dx%d vs %dx%d",
+                 frame1->width, frame1->height, frame2->width, frame2->height);
+        return 50.0f; // Retorna diferença máxima
     }
-    
-    // Suavizar pequenas flutuações
-    if (change_percentage < 8.0f) {
-        change_percentage *= 0.8f; // Reduzir sensibilidade para mudanças pequenas
-        ESP_LOGD(TAG, "Mudança pequena suavizada para: %.1f%%", change_percentage);
+
+    if (COMPARE_LEGACY_METRIC) {
+        return legacy_image_difference(frame1, frame2);
+    }
+
+    luma_plane_t plane1 = {0};
+    luma_plane_t plane2 = {0};
+    esp_err_t err1 = compare_decode_luma_only(frame1, &plane1);
+    esp_err_t err2 = (err1 == ESP_OK) ? compare_decode_luma_only(frame2, &plane2) : err1;
+
+    if (err1 == ESP_ERR_NO_MEM || err2 == ESP_ERR_NO_MEM) {
+        ESP_LOGE(TAG, "Falha ao alocar planos de luminância");
+        compare_free_luma(&plane1);
+        compare_free_luma(&plane2);
+
+        // Fallback para comparação por tamanho
+        float size_diff = abs((int)frame1->len - (int)frame2->len);
+        float avg_size = (frame1->len + frame2->len) / 2.0f;
+        return (size_diff / avg_size) * 100.0f;
     }
-    
+
+    float change_percentage = 0.0f;
+    if (err1 == ESP_OK && err2 == ESP_OK) {
+        change_percentage = compare_luma_planes(&plane1, &plane2);
+    }
+
+    compare_free_luma(&plane1);
+    compare_free_luma(&plane2);
+
     return change_percentage;
 }
 
+void compare_benchmark_batch(camera_fb_t* frame) {
+    if (!frame) return;
+
+    luma_plane_t current = {0};
+    luma_plane_t refs_storage[COMPARE_MAX_BATCH] = {0};
+    luma_plane_t* refs[COMPARE_MAX_BATCH];
+    float scores[COMPARE_MAX_BATCH];
+    int best = -1;
+
+    int64_t t0 = esp_timer_get_time();
+    if (compare_decode_luma_only(frame, &current) != ESP_OK) {
+        ESP_LOGE(TAG, "Benchmark abortado: falha na decodificação");
+        return;
+    }
+    int64_t decode_us = esp_timer_get_time() - t0;
+
+    // Referências sintéticas: cópias do frame atual (custo idêntico ao real)
+    int available = 0;
+    for (int i = 0; i < COMPARE_MAX_BATCH; i++) {
+        if (compare_copy_luma(&current, &refs_storage[i]) != ESP_OK) break;
+        refs[i] = &refs_storage[i];
+        available++;
+    }
+
+    ESP_LOGI(TAG, "⏱️ === BENCHMARK COMPARAÇÃO EM LOTE (%ux%u, decode %" PRId64 " us) ===",
+             current.width, current.height, decode_us);
+
+    for (int engine = COMPARE_ENGINE_SAD; engine <= COMPARE_ENGINE_GRADIENT; engine++) {
+        // Invalidar caches de bordas para medir o custo completo do gradiente
+        for (int i = 0; i < available; i++) refs_storage[i].edges_valid = false;
+
+        for (int n = 1; n <= available; n++) {
+            t0 = esp_timer_get_time();
+            compare_kernel((compare_engine_t)engine, &current, refs, n, scores, &best, NULL);
+            int64_t batch_us = esp_timer_get_time() - t0;
+
+            // Equivalente sem lote: N decodificações + N comparações individuais
+            int64_t separate_us = 0;
+            for (int i = 0; i < n; i++) {
+                t0 = esp_timer_get_time();
+                compare_decode_luma_only(frame, &current);
+                compare_kernel((compare_engine_t)engine, &current, &refs[i], 1, scores, &best, NULL);
+                separate_us += esp_timer_get_time() - t0;
+            }
+
+            ESP_LOGI(TAG, "⏱️ [%s] N=%d: lote %" PRId64 " us (+decode %" PRId64 " us) | separado %" PRId64 " us",
+                     compare_engine_name((compare_engine_t)engine), n, batch_us, decode_us, separate_us);
+        }
+    }
+
+    for (int i = 0; i < COMPARE_MAX_BATCH; i++) {
+        compare_free_luma(&refs_storage[i]);
+    }
+    compare_free_luma(&current);
+}
+
+void compare_set_exclusion_mask(const uint8_t* mask) {
+    exclusion_active = false;
+    if (!mask) {
+        memset(exclusion_mask, 0, sizeof(exclusion_mask));
+        return;
+    }
+
+    for (int i = 0; i < COMPARE_MAX_BLOCKS; i++) {
+        exclusion_mask[i] = mask[i] ? 1 : 0;
+        exclusion_active |= (exclusion_mask[i] != 0);
+    }
+}
+
+esp_err_t compare_nuisance_init(void) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NUISANCE_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "🌳 Máscara de regiões ruidosas: sem dados salvos, aprendendo do zero");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    nuisance_state_t loaded;
+    size_t size = sizeof(loaded);
+    err = nvs_get_blob(handle, NUISANCE_NVS_KEY, &loaded, &size);
+    nvs_close(handle);
+
+    if (err != ESP_OK || size != sizeof(loaded) ||
+        loaded.version != NUISANCE_VERSION || loaded.blocks != COMPARE_MAX_BLOCKS) {
+        ESP_LOGW(TAG, "🌳 Máscara salva ausente ou incompatível - aprendendo do zero");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    nuisance = loaded;
+    int masked = 0;
+    for (int i = 0; i < COMPARE_MAX_BLOCKS; i++) {
+        masked += nuisance.masked[i];
+    }
+    ESP_LOGI(TAG, "🌳 Máscara carregada da NVS: %d/%d blocos mascarados (%" PRIu32 " amostras)",
+             masked, COMPARE_MAX_BLOCKS, nuisance.samples);
+    return ESP_OK;
+}
+
+bool compare_nuisance_update(const compare_result_t* result) {
+    if (!result || result->total_blocks + result->masked_blocks + result->excluded_blocks != nuisance.blocks) {
+        return false;
+    }
+
+    const int threshold = result->block_threshold > 0 ? result->block_threshold
+                                                      : engine_block_threshold(result->engine);
+    const uint32_t ceiling = NUISANCE_PCT_TO_Q16(NUISANCE_RATE_CEILING);
+    const uint32_t release = NUISANCE_PCT_TO_Q16(NUISANCE_RATE_RELEASE);
+    const int max_masked = (nuisance.blocks * NUISANCE_MAX_MASKED_PCT) / 100;
+    // Só mascarar depois de uma janela completa de observações
+    const bool warmed_up = nuisance.samples >= (1u << NUISANCE_WINDOW_SHIFT);
+
+    int masked_count = 0;
+    for (int i = 0; i < nuisance.blocks; i++) {
+        masked_count += nuisance.masked[i];
+    }
+
+    bool mask_changed = false;
+    for (int i = 0; i < nuisance.blocks; i++) {
+        // Blocos excluídos (lente obstruída) não dizem nada sobre a cena
+        if (result->excluded_blocks > 0 && exclusion_mask[i]) {
+            continue;
+        }
+
+        // Média móvel exponencial da fração de capturas em que o bloco mudou
+        int32_t target = (result->block_scores[i] > threshold) ? NUISANCE_RATE_ONE : 0;
+        int32_t rate = nuisance.rate[i];
+        rate += (target - rate) >> NUISANCE_WINDOW_SHIFT;
+        nuisance.rate[i] = (uint16_t)rate;
+
+        if (!nuisance.masked[i] && warmed_up && (uint32_t)rate >= ceiling && masked_count < max_masked) {
+            nuisance.masked[i] = 1;
+            masked_count++;
+            mask_changed = true;
+            ESP_LOGI(TAG, "🌳 Bloco %d (%d,%d) mascarado: muda em %" PRIu32 "%% das capturas",
+                     i, i % COMPARE_BLOCKS_X, i / COMPARE_BLOCKS_X, ((uint32_t)rate * 100) / NUISANCE_RATE_ONE);
+        } else if (nuisance.masked[i] && (uint32_t)rate < release) {
+            nuisance.masked[i] = 0;
+            masked_count--;
+            mask_changed = true;
+            ESP_LOGI(TAG, "🌳 Bloco %d (%d,%d) liberado: cena estabilizada", i, i % COMPARE_BLOCKS_X, i / COMPARE_BLOCKS_X);
+        }
+    }
+
+    if (nuisance.samples < UINT32_MAX) {
+        nuisance.samples++;
+    }
+
+    // Gravar periodicamente (desgaste da flash) ou quando a máscara muda
+    if (mask_changed || ++nuisance_pending_updates >= NUISANCE_SAVE_INTERVAL) {
+        compare_nuisance_save();
+    }
+
+    return mask_changed;
+}
+
+esp_err_t compare_nuisance_save(void) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(NUISANCE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao abrir NVS para a máscara: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(handle, NUISANCE_NVS_KEY, &nuisance, sizeof(nuisance));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao gravar máscara na NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    nuisance_pending_updates = 0;
+    ESP_LOGD(TAG, "Máscara de regiões ruidosas gravada na NVS");
+    return ESP_OK;
+}
+
+esp_err_t compare_nuisance_reset(void) {
+    memset(&nuisance, 0, sizeof(nuisance));
+    nuisance.version = NUISANCE_VERSION;
+    nuisance.blocks = COMPARE_MAX_BLOCKS;
+    ESP_LOGI(TAG, "🌳 Máscara de regiões ruidosas reiniciada");
+    return compare_nuisance_save();
+}
+
+int compare_nuisance_get(uint8_t* rate_percent, uint8_t* masked, int max_blocks) {
+    int count = nuisance.blocks < max_blocks ? nuisance.blocks : max_blocks;
+
+    for (int i = 0; i < count; i++) {
+        if (rate_percent) {
+            rate_percent[i] = (uint8_t)(((uint32_t)nuisance.rate[i] * 100) / NUISANCE_RATE_ONE);
+        }
+        if (masked) {
+            masked[i] = nuisance.masked[i];
+        }
+    }
+    return count;
+}
+
+int compare_block_chroma(const luma_plane_t* plane, uint8_t* cb, uint8_t* cr, int max_blocks) {
+    if (!plane || !cb || !cr || !rgb565_scratch || !plane->pixels || plane->pixels != scratch_pixels) {
+        return 0;
+    }
+
+    const int blocks_x = plane->width / COMPARE_BLOCK_SIZE;
+    const int blocks_y = plane->height / COMPARE_BLOCK_SIZE;
+    if (blocks_x * blocks_y > max_blocks) {
+        return 0;
+    }
+
+    const int pixels = COMPARE_BLOCK_SIZE * COMPARE_BLOCK_SIZE;
+    for (int by = 0; by < blocks_y; by++) {
+        for (int bx = 0; bx < blocks_x; bx++) {
+            int32_t sum_cb = 0, sum_cr = 0;
+            for (int y = by * COMPARE_BLOCK_SIZE; y < (by + 1) * COMPARE_BLOCK_SIZE; y++) {
+                const uint8_t *src = rgb565_scratch + ((size_t)y * plane->width + bx * COMPARE_BLOCK_SIZE) * 2;
+                for (int x = 0; x < COMPARE_BLOCK_SIZE; x++, src += 2) {
+                    uint16_t pixel = ((uint16_t)src[0] << 8) | src[1];
+                    int r = ((pixel >> 11) & 0x1F) << 3;
+                    int g = ((pixel >> 5) & 0x3F) << 2;
+                    int b = (pixel & 0x1F) << 3;
+                    // BT.601 sem o deslocamento de 128 (somado na média)
+                    sum_cb += -43 * r - 85 * g + 128 * b;
+                    sum_cr += 128 * r - 107 * g - 21 * b;
+                }
+            }
+            int i = by * blocks_x + bx;
+            int mean_cb = 128 + (sum_cb / pixels) / 256;
+            int mean_cr = 128 + (sum_cr / pixels) / 256;
+            cb[i] = (uint8_t)(mean_cb < 0 ? 0 : mean_cb > 255 ? 255 : mean_cb);
+            cr[i] = (uint8_t)(mean_cr < 0 ? 0 : mean_cr > 255 ? 255 : mean_cr);
+        }
+    }
+    return blocks_x * blocks_y;
+}
+
+int compare_block_color(const luma_plane_t* plane, uint8_t* dark, uint8_t* saturation,
+                        int max_blocks, int step) {
+    if (!plane || !dark || !saturation || !rgb565_scratch || step < 1 ||
+        !plane->pixels || plane->pixels != scratch_pixels) {
+        return 0;
+    }
+
+    const int blocks_x = plane->width / COMPARE_BLOCK_SIZE;
+    const int blocks_y = plane->height / COMPARE_BLOCK_SIZE;
+    if (blocks_x * blocks_y > max_blocks) {
+        return 0;
+    }
+
+    const int per_side = (COMPARE_BLOCK_SIZE + step - 1) / step;
+    const int samples = per_side * per_side;
+    for (int by = 0; by < blocks_y; by++) {
+        for (int bx = 0; bx < blocks_x; bx++) {
+            int block_dark = 255;
+            uint32_t sum_sat = 0;
+            for (int y = by * COMPARE_BLOCK_SIZE; y < (by + 1) * COMPARE_BLOCK_SIZE; y += step) {
+                const uint8_t *src = rgb565_scratch + ((size_t)y * plane->width + bx * COMPARE_BLOCK_SIZE) * 2;
+                for (int x = 0; x < COMPARE_BLOCK_SIZE; x += step, src += 2 * step) {
+                    uint16_t pixel = ((uint16_t)src[0] << 8) | src[1];
+                    int r = ((pixel >> 11) & 0x1F) << 3;
+                    int g = ((pixel >> 5) & 0x3F) << 2;
+                    int b = (pixel & 0x1F) << 3;
+                    int lo = r < g ? (r < b ? r : b) : (g < b ? g : b);
+                    int hi = r > g ? (r > b ? r : b) : (g > b ? g : b);
+                    if (lo < block_dark) {
+                        block_dark = lo;
+                    }
+                    if (hi > 0) {
+                        sum_sat += (uint32_t)((hi - lo) * 255 / hi);
+                    }
+                }
+            }
+            int i = by * blocks_x + bx;
+            dark[i] = (uint8_t)block_dark;
+            saturation[i] = (uint8_t)(sum_sat / samples);
+        }
+    }
+    return blocks_x * blocks_y;
+}
+
+esp_err_t compare_edge_density(luma_plane_t* plane) {
+    if (!plane || !plane->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return compute_edge_density(plane);
+}
+
 /**
- * Função obsoleta mantida para compatibilidade
- * TODO: Remover quando não for mais necessária
+ * Libera os buffers temporários de decodificação e de gradiente
  */
 void compare_free_buffers(void) {
-    ESP_LOGD(TAG, "compare_free_buffers() - função obsoleta");
+    if (rgb565_scratch) {
+        mem_free(rgb565_scratch);
+        rgb565_scratch = NULL;
+        rgb565_scratch_size = 0;
+        scratch_pixels = NULL;
+    }
+    if (rgb565_aside) {
+        mem_free(rgb565_aside);
+        rgb565_aside = NULL;
+        rgb565_aside_size = 0;
+    }
+    if (edge_band) {
+        mem_free(edge_band);
+        edge_band = NULL;
+        edge_band_size = 0;
+    }
+    ESP_LOGD(TAG, "Buffers de decodificação liberados");
 }
@@ -1,34 +1,320 @@
 /**
  * @file compare.h
  * @brief Interface para comparação de imagens e detecção de movimento
- * 
+ *
  * Este módulo fornece funções para:
  * - Comparação de imagens pixel a pixel com decodificação JPEG
  * - Análise por blocos para otimização de performance
  * - Algoritmo otimizado para HVGA (480x320)
- * 
+ * - Planos de luminância reduzidos reutilizáveis (uma decodificação por frame)
+ * - Comparação em lote de um frame contra N referências
+ * - Engines SAD, SSIM inteiro e densidade de bordas, selecionáveis em tempo de execução
+ * - Máscara aprendida de regiões ruidosas (persistida na NVS)
+ * - Piso de ruído e limiares escalados pelo ganho do sensor
+ * - Máscara de exclusão externa (blocos com a lente obstruída)
+ *
  * @author Gabriel Passos - UNESP 2025
  */
 #ifndef COMPARE_H
 #define COMPARE_H
 
 #include "esp_camera.h"
+#include "esp_err.h"
+#include "config.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Dimensões do plano reduzido e da grade de blocos
+#define COMPARE_PLANE_WIDTH   (IMAGE_WIDTH >> COMPARE_SCALE_SHIFT)
+#define COMPARE_PLANE_HEIGHT  (IMAGE_HEIGHT >> COMPARE_SCALE_SHIFT)
+#define COMPARE_BLOCKS_X      (COMPARE_PLANE_WIDTH / COMPARE_BLOCK_SIZE)
+#define COMPARE_BLOCKS_Y      (COMPARE_PLANE_HEIGHT / COMPARE_BLOCK_SIZE)
+#define COMPARE_MAX_BLOCKS    (COMPARE_BLOCKS_X * COMPARE_BLOCKS_Y)
+
+/**
+ * @brief Plano de luminância (8 bits) decodificado em escala reduzida
+ *
+ * O buffer fica na PSRAM e é reaproveitado entre decodificações do
+ * mesmo tamanho, evitando alocações a cada ciclo.
+ */
+typedef struct {
+    uint8_t *pixels;    ///< Luminância 0-255, largura x altura bytes
+    uint16_t width;     ///< Largura do plano
+    uint16_t height;    ///< Altura do plano
+    uint16_t gain_x16;  ///< Ganho do sensor na captura (16 = 1x, 0 = desconhecido)
+    bool edges_valid;   ///< edge_density calculado para os pixels atuais
+    uint8_t edge_density[COMPARE_MAX_BLOCKS]; ///< Densidade de bordas por bloco (0-255, cache)
+} luma_plane_t;
+
+/**
+ * @brief Engines de comparação disponíveis
+ */
+typedef enum {
+    COMPARE_ENGINE_SAD = 0,     ///< Diferença absoluta média de luminância por bloco
+    COMPARE_ENGINE_SSIM = 1,    ///< Dissimilaridade estrutural (SSIM inteiro por bloco)
+    COMPARE_ENGINE_GRADIENT = 2,///< Variação da densidade de bordas (Sobel) por bloco
+} compare_engine_t;
+
+/**
+ * @brief Resultado detalhado de uma comparação entre dois planos
+ */
+typedef struct {
+    compare_engine_t engine;                    ///< Engine usado
+    float difference;                           ///< Percentual de mudança (0.0 a 100.0)
+    int changed_blocks;                         ///< Blocos acima do limiar do engine (fora da máscara)
+    int total_blocks;                           ///< Blocos analisados (fora da máscara)
+    int masked_blocks;                          ///< Blocos ignorados pela máscara de regiões ruidosas
+    int excluded_blocks;                        ///< Blocos ignorados pela máscara de exclusão (lente obstruída)
+    int block_threshold;                        ///< Limiar por bloco aplicado (escalado pelo ganho)
+    uint8_t block_scores[COMPARE_MAX_BLOCKS];   ///< Dissimilaridade por bloco (0-255)
+    int8_t texture_delta[COMPARE_MAX_BLOCKS];   ///< Gradiente: textura ganha (>0) ou perdida (<0) por bloco
+    float texture_lost;                         ///< Gradiente: % de blocos com perda de textura
+    float texture_gained;                       ///< Gradiente: % de blocos com ganho de textura
+} compare_result_t;
 
 /**
  * @brief Calcula a diferença percentual entre duas imagens
- * 
+ *
+ * Com COMPARE_LEGACY_METRIC (padrão), decodifica as duas na resolução
+ * cheia e compara blocos 32x32 amostrados a cada 6 px, a métrica em que
+ * os limiares foram calibrados. Sem ela, usa os planos de 1/2 escala com
+ * blocos 16x16 densos: mesma grade, menos ruído, mas traços finos e
+ * textura de 1 px deixam de ser acusados (test_compare_metric e
+ * docs/technical_guide.md, 3.4).
+ *
  * @param frame1 Primeira imagem para comparação
  * @param frame2 Segunda imagem para comparação
  * @return float Percentual de diferença entre as imagens (0.0 a 100.0)
  */
 float calculate_image_difference(camera_fb_t* frame1, camera_fb_t* frame2);
 
+/**
+ * @brief Decodifica um JPEG para plano de luminância reduzido
+ *
+ * Reutiliza plane->pixels se já alocado com as mesmas dimensões. O ganho
+ * do plano volta a desconhecido; o chamador deve preencher gain_x16.
+ *
+ * @param frame Frame JPEG de origem
+ * @param plane Plano de destino (zerado ou previamente decodificado)
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t compare_decode_luma(const camera_fb_t* frame, luma_plane_t* plane);
+
+/**
+ * @brief Decodifica um JPEG para plano de luminância sem reter a cor
+ *
+ * Usa um buffer RGB565 próprio: a cor da última compare_decode_luma()
+ * continua disponível para compare_block_chroma()/compare_block_color().
+ * Para planos em cache, referências e demais frames que não são a
+ * captura em análise.
+ *
+ * @param frame Frame JPEG de origem
+ * @param plane Plano de destino (zerado ou previamente decodificado)
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t compare_decode_luma_only(const camera_fb_t* frame, luma_plane_t* plane);
+
+/**
+ * @brief Copia um plano já decodificado (sem nova decodificação)
+ *
+ * @param src Plano de origem
+ * @param dst Plano de destino (buffer reaproveitado se compatível)
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t compare_copy_luma(const luma_plane_t* src, luma_plane_t* dst);
+
+/**
+ * @brief Libera o buffer de um plano de luminância
+ *
+ * @param plane Plano a liberar
+ */
+void compare_free_luma(luma_plane_t* plane);
+
+/**
+ * @brief Compara dois planos já decodificados
+ *
+ * @param reference Plano de referência
+ * @param current Plano atual
+ * @return float Percentual de diferença (mesma escala de calculate_image_difference)
+ */
+float compare_luma_planes(luma_plane_t* reference, luma_plane_t* current);
+
+/**
+ * @brief Compara dois planos e devolve o mapa de dissimilaridade por bloco
+ *
+ * @param reference Plano de referência
+ * @param current Plano atual
+ * @param result Saída: percentual, contagem e mapa por bloco
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t compare_luma_planes_ex(luma_plane_t* reference, luma_plane_t* current, compare_result_t* result);
+
+/**
+ * @brief Seleciona o engine de comparação usado pelas próximas chamadas
+ *
+ * @param engine Engine desejado
+ */
+void compare_set_engine(compare_engine_t engine);
+
+/**
+ * @brief Aplica o engine gravado na NVS (namespace "compare", chave u8 "engine")
+ *
+ * Deve ser chamada após nvs_flash_init(). Permite trocar o engine em campo
+ * sem recompilar; sem a chave vale COMPARE_DEFAULT_ENGINE.
+ *
+ * @return esp_err_t ESP_OK se aplicado, ESP_ERR_NOT_FOUND sem chave,
+ *         ESP_ERR_INVALID_ARG com valor fora do intervalo
+ */
+esp_err_t compare_engine_init(void);
+
+/**
+ * @brief Obtém o engine de comparação ativo
+ *
+ * @return compare_engine_t Engine ativo
+ */
+compare_engine_t compare_get_engine(void);
+
+/**
+ * @brief Nome curto do engine (para logs e telemetria)
+ *
+ * @param engine Engine
+ * @return const char* Nome ("sad", "ssim", "gradient")
+ */
+const char* compare_engine_name(compare_engine_t engine);
+
+/**
+ * @brief Compara um plano contra N referências em uma única passada
+ *
+ * Cada pixel do plano atual é lido uma vez e confrontado com todas as
+ * referências. O melhor candidato é o de menor percentual de mudança,
+ * desempatado pela soma das dissimilaridades por bloco.
+ *
+ * @param current Plano atual
+ * @param refs Planos de referência (entradas NULL são ignoradas)
+ * @param ref_count Número de referências (até COMPARE_MAX_BATCH)
+ * @param scores Saída: percentual por referência (-1.0 se ignorada)
+ * @param best_index Saída: índice da referência mais parecida (-1 se nenhuma)
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t compare_luma_batch(luma_plane_t* current, luma_plane_t* const refs[], int ref_count,
+                             float* scores, int* best_index);
+
+/**
+ * @brief Mede o custo da comparação em lote em função de N
+ *
+ * Registra no log, para cada engine, o tempo de decodificação, do lote com
+ * N = 1..COMPARE_MAX_BATCH e do equivalente com N decodificações separadas.
+ * O mesmo kernel roda no PC com `make bench` (src/firmware/test/host);
+ * números medidos em docs/technical_guide.md.
+ *
+ * @param frame Frame JPEG usado como carga de teste
+ */
+void compare_benchmark_batch(camera_fb_t* frame);
+
+/**
+ * @brief Define blocos excluídos das próximas comparações (ex.: lente obstruída)
+ *
+ * A máscara é copiada; blocos excluídos não entram na contagem de mudança,
+ * no denominador do percentual nem no aprendizado de regiões ruidosas.
+ *
+ * @param mask Vetor de COMPARE_MAX_BLOCKS (1 = excluir) ou NULL para limpar
+ */
+void compare_set_exclusion_mask(const uint8_t* mask);
+
+/**
+ * @brief Carrega da NVS a máscara de regiões ruidosas aprendida
+ *
+ * Deve ser chamada após nvs_flash_init(). Sem dados salvos (ou com
+ * grade diferente) o aprendizado recomeça do zero.
+ *
+ * @return esp_err_t ESP_OK se carregada, ESP_ERR_NOT_FOUND se não havia máscara salva
+ */
+esp_err_t compare_nuisance_init(void);
+
+/**
+ * @brief Atualiza a frequência de mudança por bloco com uma comparação
+ *
+ * Deve receber apenas comparações contra a referência principal. Blocos cuja
+ * taxa de mudança passa de NUISANCE_RATE_CEILING são mascarados e voltam a ser
+ * analisados quando a taxa cai abaixo de NUISANCE_RATE_RELEASE.
+ *
+ * @param result Resultado de compare_luma_planes_ex()
+ * @return true se a máscara mudou nesta atualização
+ */
+bool compare_nuisance_update(const compare_result_t* result);
+
+/**
+ * @brief Grava o estado da máscara na NVS
+ *
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t compare_nuisance_save(void);
+
+/**
+ * @brief Descarta o aprendizado (ex.: câmera reposicionada)
+ *
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t compare_nuisance_reset(void);
+
+/**
+ * @brief Obtém a taxa de mudança e o estado da máscara por bloco
+ *
+ * @param rate_percent Saída: taxa de mudança por bloco (0-100), pode ser NULL
+ * @param masked Saída: 1 se o bloco está mascarado, pode ser NULL
+ * @param max_blocks Capacidade dos vetores de saída
+ * @return int Número de blocos preenchidos (COMPARE_MAX_BLOCKS no máximo)
+ */
+int compare_nuisance_get(uint8_t* rate_percent, uint8_t* masked, int max_blocks);
+
+/**
+ * @brief Crominância média por bloco da última decodificação
+ *
+ * Reaproveita o buffer RGB565 de compare_decode_luma(). Vale para o plano
+ * da última compare_decode_luma() enquanto seus pixels não forem
+ * reescritos; decodificações por compare_decode_luma_only() (cache de
+ * planos, referências) não interferem.
+ *
+ * @param plane Plano decodificado por compare_decode_luma()
+ * @param cb Saída: Cb médio por bloco (0-255)
+ * @param cr Saída: Cr médio por bloco (0-255)
+ * @param max_blocks Capacidade dos vetores de saída
+ * @return int Número de blocos preenchidos (0 se a cor no buffer não é deste plano)
+ */
+int compare_block_chroma(const luma_plane_t* plane, uint8_t* cb, uint8_t* cr, int max_blocks);
+
+/**
+ * @brief Canal escuro e saturação por bloco da última decodificação
+ *
+ * Mesmo buffer RGB565 de compare_block_chroma(), amostrado a cada
+ * step pixels em cada direção, com a mesma validade.
+ *
+ * @param plane Plano decodificado por compare_decode_luma()
+ * @param dark Saída: menor min(R,G,B) do bloco (0-255)
+ * @param saturation Saída: saturação média do bloco (0-255)
+ * @param max_blocks Capacidade dos vetores de saída
+ * @param step Passo da amostragem (1 = todos os pixels)
+ * @return int Número de blocos preenchidos (0 se a cor no buffer não é deste plano)
+ */
+int compare_block_color(const luma_plane_t* plane, uint8_t* dark, uint8_t* saturation,
+                        int max_blocks, int step);
+
+/**
+ * @brief Densidade de bordas (Sobel) por bloco, com cache no plano
+ *
+ * Reaproveitada pela engine de gradiente na mesma captura.
+ *
+ * @param plane Plano de luminância
+ * @return esp_err_t ESP_OK com plane->edge_density preenchido
+ */
+esp_err_t compare_edge_density(luma_plane_t* plane);
+
 /**
  * @brief Libera os buffers de decodificação usados na comparação
- * 
+ *
  * Deve ser chamada quando o sistema precisa liberar memória
  * ou ao finalizar o uso do módulo de comparação
  */
 void compare_free_buffers(void);
 
-#endif // COMPARE_H 
\ No newline at end of file
+#endif // COMPARE_H
@@ -0,0 +1,194 @@
+/**
+ * @file event_clip.c
+ * @brief Implementação do clipe pré-alerta e da tarefa de envio
+ *
+ * O histórico é lido apenas pela tarefa de análise, que também o alimenta.
+ * A fila leva a lista de frames (cada handle com uma referência extra) e as
+ * miniaturas vão copiadas para clip_thumbs, então o histórico pode
+ * continuar girando enquanto o clipe é publicado. Como há um único buffer
+ * de miniaturas, um novo clipe só é aceito depois que o anterior termina.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "event_clip.h"
+#include "advanced_analysis.h"
+#include "config.h"
+#include "mem_account.h"
+#include "mqtt_send.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "EVENT_CLIP";
+
+typedef struct {
+    frame_handle_t* frame;      // Frame completo retido (NULL = miniatura)
+    camera_fb_t thumbnail;      // Miniatura copiada em clip_thumbs (len 0 = sem miniatura)
+    int64_t captured_us;
+} clip_slot_t;
+
+typedef struct {
+    uint32_t alert_id;
+    float difference;
+    int64_t trigger_us;                      // Captura do gatilho (fora do clipe)
+    int count;
+    clip_slot_t frames[EVENT_CLIP_FRAMES];   // Do mais antigo ao mais recente
+} clip_job_t;
+
+static QueueHandle_t clip_queue = NULL;
+static uint8_t* clip_thumbs = NULL;          // EVENT_CLIP_FRAMES miniaturas do clipe em envio
+static atomic_bool clip_busy = false;        // Clipe na fila ou em envio
+
+static volatile uint32_t clips_sent = 0;
+static volatile uint32_t clips_dropped = 0;
+static volatile uint32_t frames_sent = 0;
+static volatile uint32_t frames_failed = 0;
+static volatile uint32_t thumbnails_sent = 0;
+
+static void clip_sender_task(void *pvParameter) {
+    static clip_job_t job;      // Fora da pilha da tarefa
+
+    while (1) {
+        if (xQueueReceive(clip_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        ESP_LOGI(TAG, "🎬 Enviando clipe do alerta #%" PRIu32 " (%d frames)", job.alert_id, job.count);
+        for (int i = 0; i < job.count; i++) {
+            clip_slot_t *slot = &job.frames[i];
+            mqtt_clip_info_t info = {
+                .alert_id = job.alert_id,
+                .index = i,
+                .count = job.count,
+                .offset_ms = (int32_t)((slot->captured_us - job.trigger_us) / 1000),
+                .difference = job.difference,
+                .thumbnail = slot->frame == NULL,
+                .captured_us = slot->captured_us,
+            };
+            camera_fb_t *fb = slot->frame ? frame_handle_fb(slot->frame) : &slot->thumbnail;
+            if (mqtt_send_clip_frame(fb, &info) == ESP_OK) {
+                frames_sent++;
+                if (info.thumbnail) {
+                    thumbnails_sent++;
+                }
+            } else {
+                frames_failed++;
+            }
+            frame_handle_release(slot->frame);
+
+            // Ritmo: libera a conexão para a telemetria da captura seguinte
+            if (i + 1 < job.count) {
+                vTaskDelay(pdMS_TO_TICKS(EVENT_CLIP_PACE_MS));
+            }
+        }
+        clips_sent++;
+        atomic_store(&clip_busy, false);
+    }
+}
+
+esp_err_t event_clip_init(void) {
+    if (clip_queue) {
+        return ESP_OK;
+    }
+
+    if (HISTORY_THUMBNAILS_ENABLED) {
+        clip_thumbs = mem_alloc(MEM_TAG_FRAME_POOL, (size_t)EVENT_CLIP_FRAMES * HISTORY_THUMB_SLOT_SIZE,
+                                MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!clip_thumbs) {
+            ESP_LOGW(TAG, "⚠️ Sem memória para miniaturas - clipes só com frames completos");
+        }
+    }
+
+    clip_queue = xQueueCreate(1, sizeof(clip_job_t));
+    if (!clip_queue) {
+        ESP_LOGE(TAG, "Falha ao criar fila de clipes");
+        mem_free(clip_thumbs);
+        clip_thumbs = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(clip_sender_task, "event_clip", 4096, NULL, EVENT_CLIP_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Falha ao criar tarefa de envio de clipes");
+        vQueueDelete(clip_queue);
+        clip_queue = NULL;
+        mem_free(clip_thumbs);
+        clip_thumbs = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "✅ Clipe pré-alerta: %d entradas do histórico, %d ms entre envios",
+             EVENT_CLIP_FRAMES, EVENT_CLIP_PACE_MS);
+    return ESP_OK;
+}
+
+esp_err_t event_clip_flush(uint32_t alert_id, float difference, int64_t trigger_us) {
+    if (!clip_queue) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Sem espera: com um clipe ainda em envio este alerta fica sem clipe
+    if (atomic_exchange(&clip_busy, true)) {
+        clips_dropped++;
+        ESP_LOGW(TAG, "⚠️ Clipe do alerta #%" PRIu32 " descartado (envio anterior em andamento)", alert_id);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    static clip_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.alert_id = alert_id;
+    job.difference = difference;
+    job.trigger_us = trigger_us;
+
+    // Do mais antigo ao mais recente; entradas sem frame nem miniatura ficam de fora
+    for (int age = EVENT_CLIP_FRAMES - 1; age >= 0; age--) {
+        history_entry_view_t entry;
+        if (get_history_entry(age, &entry) != ESP_OK) {
+            continue;
+        }
+        clip_slot_t *slot = &job.frames[job.count];
+        if (entry.frame) {
+            slot->frame = frame_handle_retain(entry.frame);
+        } else if (entry.thumbnail && clip_thumbs && entry.thumbnail_len <= HISTORY_THUMB_SLOT_SIZE) {
+            uint8_t *copy = clip_thumbs + (size_t)job.count * HISTORY_THUMB_SLOT_SIZE;
+            memcpy(copy, entry.thumbnail, entry.thumbnail_len);
+            slot->thumbnail.buf = copy;
+            slot->thumbnail.len = entry.thumbnail_len;
+            slot->thumbnail.width = entry.thumbnail_width;
+            slot->thumbnail.height = entry.thumbnail_height;
+            slot->thumbnail.format = PIXFORMAT_JPEG;
+        } else {
+            continue;
+        }
+        slot->captured_us = (int64_t)entry.timestamp;
+        job.count++;
+    }
+
+    if (job.count == 0) {
+        atomic_store(&clip_busy, false);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xQueueSend(clip_queue, &job, 0) != pdTRUE) {
+        // Não acontece com clip_busy, mas os handles não podem vazar
+        for (int i = 0; i < job.count; i++) {
+            frame_handle_release(job.frames[i].frame);
+        }
+        atomic_store(&clip_busy, false);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void event_clip_get_stats(event_clip_stats_t* stats) {
+    if (!stats) return;
+
+    stats->thumbnails_sent = thumbnails_sent;
+    stats->clips_sent = clips_sent;
+    stats->clips_dropped = clips_dropped;
+    stats->frames_sent = frames_sent;
+    stats->frames_failed = frames_failed;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file event_clip.h
+ * @brief Clipe pré-alerta: últimas capturas enviadas em ordem quando um alerta dispara
+ *
+ * O clipe é montado a partir das últimas EVENT_CLIP_FRAMES entradas do
+ * histórico: entradas que ainda têm o frame completo entram pelo handle do
+ * pool (apenas frame_handle_retain(), sem cópia); as demais entram pela
+ * miniatura em tons de cinza, copiada para um buffer do clipe. No alerta,
+ * o clipe é entregue a uma tarefa de menor prioridade que publica os
+ * frames em sequência com intervalo EVENT_CLIP_PACE_MS, sem bloquear a
+ * análise. Um clipe por vez.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#ifndef EVENT_CLIP_H
+#define EVENT_CLIP_H
+
+#include "esp_err.h"
+#include "frame_handle.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Estatísticas dos clipes
+ */
+typedef struct {
+    uint32_t thumbnails_sent;   ///< Frames do clipe enviados como miniatura
+    uint32_t clips_sent;        ///< Clipes publicados
+    uint32_t clips_dropped;     ///< Alertas sem clipe (outro clipe em envio)
+    uint32_t frames_sent;       ///< Frames publicados em clipes
+    uint32_t frames_failed;     ///< Frames com falha de publicação
+} event_clip_stats_t;
+
+/**
+ * Cria a fila e a tarefa de envio dos clipes
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t event_clip_init(void);
+
+/**
+ * Monta o clipe com as entradas atuais do histórico e o entrega à tarefa de envio
+ * (chamar da tarefa que alimenta o histórico, antes de inserir o gatilho: o
+ * gatilho já é publicado com o alerta)
+ * @param alert_id Identificador do alerta (mesmo do payload de alerta)
+ * @param difference Diferença que disparou o alerta (%)
+ * @param trigger_us Instante da captura do gatilho (referência de offset_ms)
+ * @return ESP_OK, ESP_ERR_INVALID_STATE com histórico vazio, ESP_ERR_TIMEOUT com clipe em envio
+ */
+esp_err_t event_clip_flush(uint32_t alert_id, float difference, int64_t trigger_us);
+
+/**
+ * Obtém as estatísticas
+ */
+void event_clip_get_stats(event_clip_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_CLIP_H
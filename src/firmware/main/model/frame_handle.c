@@ -0,0 +1,148 @@
+/**
+ * @file frame_handle.c
+ * @brief Implementação do pool de frames com contagem de referências
+ *
+ * Um slot é reservado trocando atomicamente sua contagem de 0 para 1, de
+ * modo que criação e liberação em tarefas diferentes não precisam de mutex.
+ * A última liberação só decrementa a contagem: depois dela o slot pode já
+ * ter sido reservado por outra tarefa, então nenhum campo é tocado.
+ * Contadores e identificadores também são atômicos.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "frame_handle.h"
+#include "config.h"
+#include "esp_log.h"
+#include "mem_account.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "FRAME_POOL";
+
+static uint8_t* pool_slab = NULL;
+static frame_handle_t handles[FRAME_POOL_SLOTS];
+static atomic_int in_use = 0;
+static atomic_int peak_in_use = 0;
+static atomic_uint created = 0;
+static atomic_uint oversize = 0;
+static atomic_uint exhausted = 0;
+static atomic_uint next_id = 0;
+
+esp_err_t frame_pool_init(void) {
+    if (pool_slab) {
+        return ESP_OK;
+    }
+
+    pool_slab = (uint8_t*)mem_alloc(MEM_TAG_FRAME_POOL, (size_t)FRAME_POOL_SLOTS * MAX_IMAGE_SIZE,
+                                    MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!pool_slab) {
+        ESP_LOGE(TAG, "Falha ao alocar pool de frames (%d x %d KB)", FRAME_POOL_SLOTS, MAX_IMAGE_SIZE / 1024);
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(handles, 0, sizeof(handles));
+    for (int i = 0; i < FRAME_POOL_SLOTS; i++) {
+        handles[i].fb.buf = pool_slab + (size_t)i * MAX_IMAGE_SIZE;
+        atomic_init(&handles[i].refs, 0);
+    }
+    atomic_store(&in_use, 0);
+
+    ESP_LOGI(TAG, "✅ Pool de frames: %d slots x %d KB na PSRAM", FRAME_POOL_SLOTS, MAX_IMAGE_SIZE / 1024);
+    return ESP_OK;
+}
+
+bool frame_pool_ready(void) {
+    return pool_slab != NULL;
+}
+
+frame_handle_t* frame_handle_create(const camera_fb_t* fb) {
+    if (!pool_slab || !fb || !fb->buf) {
+        return NULL;
+    }
+
+    if (fb->len > MAX_IMAGE_SIZE) {
+        atomic_fetch_add(&oversize, 1);
+        ESP_LOGW(TAG, "⚠️ Frame de %zu bytes excede o slot do pool (%d bytes)", fb->len, MAX_IMAGE_SIZE);
+        return NULL;
+    }
+
+    for (int i = 0; i < FRAME_POOL_SLOTS; i++) {
+        int expected = 0;
+        if (!atomic_compare_exchange_strong(&handles[i].refs, &expected, 1)) {
+            continue;
+        }
+
+        // Slot reservado: apenas esta tarefa o acessa até o handle ser publicado
+        frame_handle_t* handle = &handles[i];
+        memcpy(handle->fb.buf, fb->buf, fb->len);
+        handle->fb.len = fb->len;
+        handle->fb.width = fb->width;
+        handle->fb.height = fb->height;
+        handle->fb.format = fb->format;
+        handle->fb.timestamp = fb->timestamp;
+        uint32_t id = (uint32_t)atomic_fetch_add(&next_id, 1) + 1;
+        if (id == 0) {
+            id = (uint32_t)atomic_fetch_add(&next_id, 1) + 1;   // 0 fica reservado para "sem frame"
+        }
+        handle->id = id;
+
+        int used = atomic_fetch_add(&in_use, 1) + 1;
+        int peak = atomic_load(&peak_in_use);
+        while (used > peak && !atomic_compare_exchange_weak(&peak_in_use, &peak, used)) {
+        }
+        atomic_fetch_add(&created, 1);
+        return handle;
+    }
+
+    atomic_fetch_add(&exhausted, 1);
+    ESP_LOGE(TAG, "❌ Pool de frames esgotado (%d slots em uso)", FRAME_POOL_SLOTS);
+    return NULL;
+}
+
+frame_handle_t* frame_handle_retain(frame_handle_t* handle) {
+    if (handle) {
+        atomic_fetch_add(&handle->refs, 1);
+    }
+    return handle;
+}
+
+void frame_handle_release(frame_handle_t* handle) {
+    if (!handle) {
+        return;
+    }
+
+    int previous = atomic_fetch_sub(&handle->refs, 1);
+    if (previous == 1) {
+        // Slot livre a partir daqui: não escrever nele (pode já ter outro dono)
+        atomic_fetch_sub(&in_use, 1);
+    } else if (previous <= 0) {
+        // Liberação a mais: restaurar e sinalizar o erro de posse
+        atomic_fetch_add(&handle->refs, 1);
+        ESP_LOGE(TAG, "❌ Liberação de frame sem referência (slot %d)", (int)(handle - handles));
+    }
+}
+
+void frame_pool_get_stats(frame_pool_stats_t* stats) {
+    if (!stats) return;
+
+    stats->slots = pool_slab ? FRAME_POOL_SLOTS : 0;
+    stats->in_use = atomic_load(&in_use);
+    stats->peak_in_use = atomic_load(&peak_in_use);
+    stats->created = atomic_load(&created);
+    stats->oversize = atomic_load(&oversize);
+    stats->exhausted = atomic_load(&exhausted);
+}
+
+void frame_pool_deinit(void) {
+    if (!pool_slab) return;
+
+    int used = atomic_load(&in_use);
+    if (used > 0) {
+        ESP_LOGW(TAG, "⚠️ Liberando pool com %d frames ainda referenciados", used);
+    }
+
+    mem_free(pool_slab);
+    pool_slab = NULL;
+    memset(handles, 0, sizeof(handles));
+}
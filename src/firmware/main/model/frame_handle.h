@@ -0,0 +1,105 @@
+/**
+ * @file frame_handle.h
+ * @brief Frames JPEG compartilhados com contagem de referências
+ *
+ * Uma captura é copiada uma única vez para um slot do pool em PSRAM e o
+ * handle é compartilhado entre referência, histórico e multi-referências.
+ * Cada consumidor chama frame_handle_retain() ao guardar o frame e
+ * frame_handle_release() ao descartá-lo; a última liberação devolve o
+ * slot ao pool, sem chamadas ao alocador em regime.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#ifndef FRAME_HANDLE_H
+#define FRAME_HANDLE_H
+
+#include "esp_camera.h"
+#include "esp_err.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Frame compartilhado (payload pertence ao pool)
+ */
+typedef struct {
+    camera_fb_t fb;             ///< Cabeçalho com buf apontando para o slot do pool
+    atomic_int refs;            ///< Donos atuais (0 = slot livre)
+    uint32_t id;                ///< Identificador único da captura no slot (nunca 0; chave do cache de planos)
+} frame_handle_t;
+
+/**
+ * @brief Estatísticas do pool de frames
+ */
+typedef struct {
+    int slots;                  ///< Slots no pool
+    int in_use;                 ///< Slots com referências ativas
+    int peak_in_use;            ///< Maior ocupação observada
+    uint32_t created;           ///< Capturas copiadas para o pool
+    uint32_t oversize;          ///< Frames maiores que MAX_IMAGE_SIZE (não copiados)
+    uint32_t exhausted;         ///< Criações sem slot livre
+} frame_pool_stats_t;
+
+/**
+ * Aloca o pool de FRAME_POOL_SLOTS slots de MAX_IMAGE_SIZE bytes na PSRAM
+ * @return ESP_OK se bem-sucedido, ESP_ERR_NO_MEM sem PSRAM contígua
+ */
+esp_err_t frame_pool_init(void);
+
+/**
+ * Indica se o pool foi alocado
+ */
+bool frame_pool_ready(void);
+
+/**
+ * Copia uma captura para um slot livre do pool
+ * @param fb Frame do driver da câmera (pode ser devolvido logo após)
+ * @return Handle com uma referência, ou NULL (frame grande demais ou pool esgotado)
+ */
+frame_handle_t* frame_handle_create(const camera_fb_t* fb);
+
+/**
+ * Adiciona um dono ao handle
+ * @return O próprio handle (NULL se handle for NULL)
+ */
+frame_handle_t* frame_handle_retain(frame_handle_t* handle);
+
+/**
+ * Remove um dono; a última liberação devolve o slot ao pool
+ * @param handle Handle a liberar (NULL é ignorado)
+ */
+void frame_handle_release(frame_handle_t* handle);
+
+/**
+ * Frame do handle no formato do driver da câmera
+ */
+static inline camera_fb_t* frame_handle_fb(frame_handle_t* handle) {
+    return handle ? &handle->fb : NULL;
+}
+
+/**
+ * Instante da captura registrado pelo driver (µs do esp_timer; 0 sem handle)
+ */
+static inline int64_t frame_handle_captured_us(const frame_handle_t* handle) {
+    return handle ? (int64_t)handle->fb.timestamp.tv_sec * 1000000 + handle->fb.timestamp.tv_usec : 0;
+}
+
+/**
+ * Obtém as estatísticas do pool
+ */
+void frame_pool_get_stats(frame_pool_stats_t* stats);
+
+/**
+ * Libera o pool (todos os handles devem ter sido liberados)
+ */
+void frame_pool_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_HANDLE_H
@@ -0,0 +1,227 @@
+/**
+ * @file frame_signature.c
+ * @brief Implementação do anel de assinaturas em estrutura de vetores
+ *
+ * Cada campo tem seu próprio vetor: a busca binária por horário percorre
+ * só os 4 bytes de tempo de cada entrada, e a comparação lê 150 bytes
+ * contíguos de uma única assinatura.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "frame_signature.h"
+#include "config.h"
+#include "esp_log.h"
+#include "mem_account.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "FRAME_SIG";
+
+// Vetores do anel (índice físico = (head + lógico) % capacidade)
+static uint32_t* ring_time = NULL;
+static uint8_t* ring_mean = NULL;
+static uint8_t* ring_luma = NULL;       // FRAME_SIGNATURE_CAPACITY x COMPARE_MAX_BLOCKS
+static uint8_t* ring_chroma = NULL;     // Idem, apenas com FRAME_SIGNATURE_CHROMA
+static int head = 0;
+static int count = 0;
+
+static inline int physical(int logical) {
+    return (head + logical) % FRAME_SIGNATURE_CAPACITY;
+}
+
+size_t frame_signature_memory(void) {
+    size_t per_entry = sizeof(uint32_t) + 1 + COMPARE_MAX_BLOCKS + (FRAME_SIGNATURE_CHROMA ? COMPARE_MAX_BLOCKS : 0);
+    return per_entry * FRAME_SIGNATURE_CAPACITY;
+}
+
+esp_err_t frame_signature_init(void) {
+    if (ring_time) {
+        return ESP_OK;
+    }
+
+    ring_time = (uint32_t*)mem_alloc(MEM_TAG_SIGNATURE, FRAME_SIGNATURE_CAPACITY * sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+    ring_mean = (uint8_t*)mem_alloc(MEM_TAG_SIGNATURE, FRAME_SIGNATURE_CAPACITY, MALLOC_CAP_SPIRAM);
+    ring_luma = (uint8_t*)mem_alloc(MEM_TAG_SIGNATURE, (size_t)FRAME_SIGNATURE_CAPACITY * COMPARE_MAX_BLOCKS, MALLOC_CAP_SPIRAM);
+    if (FRAME_SIGNATURE_CHROMA) {
+        ring_chroma = (uint8_t*)mem_alloc(MEM_TAG_SIGNATURE, (size_t)FRAME_SIGNATURE_CAPACITY * COMPARE_MAX_BLOCKS, MALLOC_CAP_SPIRAM);
+    }
+
+    if (!ring_time || !ring_mean || !ring_luma || (FRAME_SIGNATURE_CHROMA && !ring_chroma)) {
+        ESP_LOGE(TAG, "Falha ao alocar anel de assinaturas (%" PRIu32 " KB)", (uint32_t)(frame_signature_memory() / 1024));
+        mem_free(ring_time);
+        mem_free(ring_mean);
+        mem_free(ring_luma);
+        mem_free(ring_chroma);
+        ring_time = NULL;
+        ring_mean = ring_luma = ring_chroma = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    head = 0;
+    count = 0;
+    ESP_LOGI(TAG, "✅ Anel de assinaturas: %d x %d bytes = %" PRIu32 " KB na PSRAM (%.1f h a %d s)",
+             FRAME_SIGNATURE_CAPACITY, (int)(frame_signature_memory() / FRAME_SIGNATURE_CAPACITY),
+             (uint32_t)(frame_signature_memory() / 1024),
+             FRAME_SIGNATURE_CAPACITY * (CAPTURE_INTERVAL_MS / 1000.0f) / 3600.0f, CAPTURE_INTERVAL_MS / 1000);
+    return ESP_OK;
+}
+
+esp_err_t frame_signature_compute(const luma_plane_t* plane, frame_signature_t* sig) {
+    if (!plane || !plane->pixels || !sig) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const int blocks_x = plane->width / COMPARE_BLOCK_SIZE;
+    const int blocks_y = plane->height / COMPARE_BLOCK_SIZE;
+    if (blocks_x * blocks_y != COMPARE_MAX_BLOCKS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(sig, 0, sizeof(frame_signature_t));
+    sig->time_s = (uint32_t)(esp_timer_get_time() / 1000000);
+
+    // Somas por bloco linha a linha (acesso sequencial ao plano)
+    uint32_t sums[COMPARE_BLOCKS_X];
+    uint32_t total = 0;
+    for (int by = 0; by < blocks_y; by++) {
+        memset(sums, 0, sizeof(sums));
+        for (int y = by * COMPARE_BLOCK_SIZE; y < (by + 1) * COMPARE_BLOCK_SIZE; y++) {
+            const uint8_t *row = plane->pixels + (size_t)y * plane->width;
+            for (int x = 0; x < blocks_x * COMPARE_BLOCK_SIZE; x++) {
+                sums[x / COMPARE_BLOCK_SIZE] += row[x];
+            }
+        }
+        for (int bx = 0; bx < blocks_x; bx++) {
+            uint8_t mean = (uint8_t)(sums[bx] / (COMPARE_BLOCK_SIZE * COMPARE_BLOCK_SIZE));
+            sig->luma[by * blocks_x + bx] = mean;
+            total += mean;
+        }
+    }
+    sig->mean_luma = (uint8_t)(total / COMPARE_MAX_BLOCKS);
+
+    if (FRAME_SIGNATURE_CHROMA) {
+        static uint8_t cb[COMPARE_MAX_BLOCKS], cr[COMPARE_MAX_BLOCKS];
+        if (compare_block_chroma(plane, cb, cr, COMPARE_MAX_BLOCKS) == COMPARE_MAX_BLOCKS) {
+            for (int i = 0; i < COMPARE_MAX_BLOCKS; i++) {
+                sig->chroma[i] = (uint8_t)((cb[i] & 0xF0) | (cr[i] >> 4));
+            }
+            sig->has_chroma = true;
+        }
+    }
+
+    return ESP_OK;
+}
+
+void frame_signature_push(const frame_signature_t* sig) {
+    if (!ring_time || !sig) return;
+
+    int slot;
+    if (count < FRAME_SIGNATURE_CAPACITY) {
+        slot = physical(count);
+        count++;
+    } else {
+        slot = head;
+        head = (head + 1) % FRAME_SIGNATURE_CAPACITY;
+    }
+
+    ring_time[slot] = sig->time_s;
+    ring_mean[slot] = sig->mean_luma;
+    memcpy(ring_luma + (size_t)slot * COMPARE_MAX_BLOCKS, sig->luma, COMPARE_MAX_BLOCKS);
+    if (ring_chroma) {
+        // Sem cor nesta captura: cinza neutro (Cb = Cr = 128)
+        if (sig->has_chroma) {
+            memcpy(ring_chroma + (size_t)slot * COMPARE_MAX_BLOCKS, sig->chroma, COMPARE_MAX_BLOCKS);
+        } else {
+            memset(ring_chroma + (size_t)slot * COMPARE_MAX_BLOCKS, 0x88, COMPARE_MAX_BLOCKS);
+        }
+    }
+}
+
+/**
+ * Índice lógico da assinatura mais próxima de target_s (tempos crescentes)
+ */
+static int find_closest(uint32_t target_s) {
+    int lo = 0, hi = count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (ring_time[physical(mid)] < target_s) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    // lo = primeira entrada >= alvo; a anterior pode estar mais perto
+    if (lo > 0 && target_s - ring_time[physical(lo - 1)] < ring_time[physical(lo)] - target_s) {
+        lo--;
+    }
+    return lo;
+}
+
+esp_err_t frame_signature_compare_ago(const frame_signature_t* sig, uint32_t seconds_ago,
+                                      signature_match_t* match) {
+    if (!sig || !match) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(match, 0, sizeof(signature_match_t));
+    match->chroma_delta = -1.0f;
+    if (!ring_time || count == 0 || sig->time_s < seconds_ago) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t start = esp_timer_get_time();
+    uint32_t target = sig->time_s - seconds_ago;
+    int slot = physical(find_closest(target));
+    uint32_t when = ring_time[slot];
+    uint32_t gap = when > target ? when - target : target - when;
+
+    if (gap <= FRAME_SIGNATURE_MATCH_S) {
+        const uint8_t *past = ring_luma + (size_t)slot * COMPARE_MAX_BLOCKS;
+        uint32_t sum = 0;
+        for (int i = 0; i < COMPARE_MAX_BLOCKS; i++) {
+            int d = abs((int)sig->luma[i] - (int)past[i]);
+            sum += d;
+            if (d > FRAME_SIGNATURE_DELTA) {
+                match->changed_blocks++;
+            }
+        }
+
+        match->found = true;
+        match->age_s = sig->time_s - when;
+        match->mean_abs_delta = (float)sum / COMPARE_MAX_BLOCKS;
+        match->changed_percent = (float)match->changed_blocks / COMPARE_MAX_BLOCKS * 100.0f;
+        match->brightness_delta = (int)sig->mean_luma - (int)ring_mean[slot];
+
+        if (ring_chroma && sig->has_chroma) {
+            const uint8_t *past_c = ring_chroma + (size_t)slot * COMPARE_MAX_BLOCKS;
+            uint32_t csum = 0;
+            for (int i = 0; i < COMPARE_MAX_BLOCKS; i++) {
+                csum += abs((sig->chroma[i] >> 4) - (past_c[i] >> 4)) +
+                        abs((sig->chroma[i] & 0x0F) - (past_c[i] & 0x0F));
+            }
+            match->chroma_delta = (float)csum * 16.0f / COMPARE_MAX_BLOCKS;
+        }
+    }
+
+    match->query_us = (uint32_t)(esp_timer_get_time() - start);
+    return ESP_OK;
+}
+
+float frame_signature_distance(const frame_signature_t* a, const frame_signature_t* b) {
+    if (!a || !b) {
+        return 255.0f;
+    }
+
+    uint32_t sum = 0;
+    for (int i = 0; i < COMPARE_MAX_BLOCKS; i++) {
+        sum += abs((int)a->luma[i] - (int)b->luma[i]);
+    }
+    return (float)sum / COMPARE_MAX_BLOCKS;
+}
+
+int frame_signature_count(void) {
+    return count;
+}
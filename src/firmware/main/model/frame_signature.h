@@ -0,0 +1,101 @@
+/**
+ * @file frame_signature.h
+ * @brief Assinaturas compactas por captura para histórico de 24 horas
+ *
+ * Cada captura gera a luminância média de cada bloco da grade de
+ * comparação (150 bytes) e, opcionalmente, a crominância média (mais 150
+ * bytes). As assinaturas ficam num anel em estrutura de vetores na PSRAM,
+ * de modo que consultas como "agora x mesmo horário ontem" rodam sem
+ * decodificar nenhum JPEG.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#ifndef FRAME_SIGNATURE_H
+#define FRAME_SIGNATURE_H
+
+#include "compare.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Assinatura de uma captura
+ */
+typedef struct {
+    uint32_t time_s;                        ///< Segundos desde o boot
+    uint8_t mean_luma;                      ///< Luminância média do frame
+    bool has_chroma;                        ///< Campo chroma preenchido
+    uint8_t weather;                        ///< weather_condition_t da captura (0 = desconhecida)
+    uint8_t luma[COMPARE_MAX_BLOCKS];       ///< Luminância média por bloco
+    uint8_t chroma[COMPARE_MAX_BLOCKS];     ///< Cb (4 bits altos) e Cr (4 bits baixos) por bloco
+} frame_signature_t;
+
+/**
+ * @brief Resultado da comparação com uma assinatura armazenada
+ */
+typedef struct {
+    bool found;                 ///< Havia assinatura dentro da tolerância
+    uint32_t age_s;             ///< Idade da assinatura comparada
+    float mean_abs_delta;       ///< Diferença média de luminância por bloco
+    int changed_blocks;         ///< Blocos com diferença > FRAME_SIGNATURE_DELTA
+    float changed_percent;      ///< Percentual de blocos alterados
+    int brightness_delta;       ///< Luminância média atual - passada
+    float chroma_delta;         ///< Diferença média de Cb+Cr por bloco (escala 0-255, -1 sem cor)
+    uint32_t query_us;          ///< Custo da consulta (busca + comparação)
+} signature_match_t;
+
+/**
+ * Aloca o anel de FRAME_SIGNATURE_CAPACITY assinaturas na PSRAM
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t frame_signature_init(void);
+
+/**
+ * Calcula a assinatura de um plano recém-decodificado
+ * @param plane Plano de luminância (crominância vem do mesmo decode)
+ * @param sig Assinatura de saída (time_s = agora)
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t frame_signature_compute(const luma_plane_t* plane, frame_signature_t* sig);
+
+/**
+ * Armazena uma assinatura; a mais antiga é sobrescrita com o anel cheio
+ */
+void frame_signature_push(const frame_signature_t* sig);
+
+/**
+ * Compara com a assinatura mais próxima de seconds_ago atrás
+ * @param sig Assinatura atual
+ * @param seconds_ago Distância no passado (ex.: 86400 = mesmo horário ontem)
+ * @param match Resultado (found = false sem assinatura dentro de FRAME_SIGNATURE_MATCH_S)
+ * @return ESP_OK se a consulta foi executada
+ */
+esp_err_t frame_signature_compare_ago(const frame_signature_t* sig, uint32_t seconds_ago,
+                                      signature_match_t* match);
+
+/**
+ * Distância entre duas assinaturas: diferença média de luminância por bloco
+ * @return 0-255 (0 = idênticas)
+ */
+float frame_signature_distance(const frame_signature_t* a, const frame_signature_t* b);
+
+/**
+ * Número de assinaturas armazenadas
+ */
+int frame_signature_count(void);
+
+/**
+ * Memória total do anel em bytes
+ */
+size_t frame_signature_memory(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FRAME_SIGNATURE_H
@@ -12,15 +12,26 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "esp_spiffs.h"
+#include "time_sync.h"
 #include <time.h>
 #include <sys/time.h>
 #include <inttypes.h>
+#include <string.h>
 
 static const char *TAG = "INIT_HW";
 
 // Mutex para acesso à câmera
 SemaphoreHandle_t camera_mutex = NULL;
 
+// Registradores do OV2640 no banco do sensor (bit 8 seleciona o banco em get_reg)
+#define OV2640_REG_GAIN      0x100   // GAIN: bits 7:4 dobram o ganho, 3:0 = frações de 1/16
+#define OV2640_REG_AEC_LOW   0x104   // REG04[1:0] = AEC[1:0]
+#define OV2640_REG_AEC_MID   0x110   // AEC[9:2]
+#define OV2640_REG_AEC_HIGH  0x145   // REG45[5:0] = AEC[15:10]
+
+// Estado do sensor associado ao último frame capturado
+static camera_exposure_t last_exposure = {0};
+
 esp_err_t camera_init(void) {
     ESP_LOGI(TAG, "Inicializando câmera...");
     
@@ -297,6 +308,10 @@ esp_err_t smart_capture_with_correction(camera_fb_t **fb_out) {
         
         // Verificar se há tint verde
         if (!detect_green_tint(fb)) {
+            // Registrar ganho/exposição com que o frame foi capturado
+            if (camera_read_exposure_state(&last_exposure) != ESP_OK) {
+                memset(&last_exposure, 0, sizeof(last_exposure));
+            }
             *fb_out = fb;
             ESP_LOGI(TAG, "✅ Captura OK na tentativa %d", retry + 1);
             update_quality_stats(had_green_tint, retry);
@@ -323,33 +338,92 @@ esp_err_t smart_capture_with_correction(camera_fb_t **fb_out) {
     return ESP_FAIL;
 }
 
-void apply_time_based_settings(void) {
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    
-    int hour = timeinfo.tm_hour;
+void apply_light_settings(light_period_t period) {
     sensor_t *s = esp_camera_sensor_get();
-    
     if (!s) {
-        ESP_LOGW(TAG, "⚠️ Sensor não disponível para configurações por horário");
+        ESP_LOGW(TAG, "⚠️ Sensor não disponível para o perfil de iluminação");
         return;
     }
     
-    if (hour >= 6 && hour <= 18) {
-        // Período diurno - configurações para luz natural
+    if (period == LIGHT_DAY) {
+        // Luz natural
         s->set_wb_mode(s, 1);      // Sunny
         s->set_saturation(s, -1);  // Saturação reduzida
         s->set_agc_gain(s, 3);     // Ganho baixo
-        ESP_LOGI(TAG, "☀️ Configurações diurnas aplicadas (hora: %d)", hour);
-    } else {
-        // Período noturno - configurações para luz artificial
+        ESP_LOGI(TAG, "☀️ Perfil diurno aplicado");
+    } else if (period == LIGHT_TWILIGHT) {
+        // Luz mista: balanço automático e ganho intermediário
+        s->set_wb_mode(s, 0);      // Auto
+        s->set_saturation(s, -1);
+        s->set_agc_gain(s, 5);
+        ESP_LOGI(TAG, "🌆 Perfil de crepúsculo aplicado");
+    } else if (period == LIGHT_NIGHT) {
+        // Luz artificial
         s->set_wb_mode(s, 3);      // Office
         s->set_saturation(s, -2);  // Saturação mais reduzida
         s->set_agc_gain(s, 8);     // Ganho aumentado
-        ESP_LOGI(TAG, "🌙 Configurações noturnas aplicadas (hora: %d)", hour);
+        ESP_LOGI(TAG, "🌙 Perfil noturno aplicado");
+    }
+}
+
+void apply_time_based_settings(void) {
+    // Luz medida tem prioridade; sem ela vale o relógio, se já sincronizado
+    light_period_t period = light_level_current();
+    if (period == LIGHT_UNKNOWN) {
+        if (!time_sync_is_synced()) {
+            // Relógio ainda em 1970 (hora 0 = noite): mantém o perfil atual
+            ESP_LOGD(TAG, "Sem luz medida e relógio não sincronizado - perfil mantido");
+            return;
+        }
+        time_t now;
+        struct tm timeinfo;
+        time(&now);
+        localtime_r(&now, &timeinfo);
+        period = (timeinfo.tm_hour >= 6 && timeinfo.tm_hour <= 18) ? LIGHT_DAY : LIGHT_NIGHT;
+    }
+    apply_light_settings(period);
+}
+
+esp_err_t camera_read_exposure_state(camera_exposure_t* state) {
+    if (!state) {
+        return ESP_ERR_INVALID_ARG;
     }
+
+    sensor_t *s = esp_camera_sensor_get();
+    if (!s) {
+        ESP_LOGW(TAG, "⚠️ Sensor não disponível para leitura de ganho/exposição");
+        return ESP_FAIL;
+    }
+
+    if (s->id.PID == OV2640_PID && s->get_reg) {
+        int gain = s->get_reg(s, OV2640_REG_GAIN, 0xFF);
+        int aec_low = s->get_reg(s, OV2640_REG_AEC_LOW, 0x03);
+        int aec_mid = s->get_reg(s, OV2640_REG_AEC_MID, 0xFF);
+        int aec_high = s->get_reg(s, OV2640_REG_AEC_HIGH, 0x3F);
+
+        if (gain >= 0 && aec_low >= 0 && aec_mid >= 0 && aec_high >= 0) {
+            // Ganho = (bit7+1)(bit6+1)(bit5+1)(bit4+1) * (1 + GAIN[3:0]/16)
+            uint16_t multiplier = 1;
+            for (int bit = 4; bit < 8; bit++) {
+                if (gain & (1 << bit)) multiplier *= 2;
+            }
+            state->gain_x16 = multiplier * (16 + (gain & 0x0F));
+            state->exposure = (uint16_t)((aec_high << 10) | (aec_mid << 2) | aec_low);
+            state->from_registers = true;
+            return ESP_OK;
+        }
+        ESP_LOGD(TAG, "Falha ao ler registradores AGC/AEC - usando status do sensor");
+    }
+
+    // Fallback: valores configurados (agc_gain 0-30 corresponde a 1x-31x)
+    state->gain_x16 = (uint16_t)((s->status.agc_gain + 1) * 16);
+    state->exposure = s->status.aec_value;
+    state->from_registers = false;
+    return ESP_OK;
+}
+
+camera_exposure_t camera_get_last_exposure(void) {
+    return last_exposure;
 }
 
 void update_quality_stats(bool had_green_tint, int retries) {
@@ -6,6 +6,7 @@
  * - Inicialização da câmera
  * - Configuração de GPIOs
  * - Inicialização de periféricos
+ * - Leitura do estado de ganho/exposição (AGC/AEC) do sensor
  * 
  * @author Gabriel Passos - UNESP 2025
  */
@@ -15,12 +16,22 @@
 // Incluir cabeçalhos essenciais para as definições usadas abaixo
 #include "esp_err.h"
 #include "esp_camera.h"
+#include "light_level.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
 // Mutex para acesso seguro à câmera, usado em main.c
 extern SemaphoreHandle_t camera_mutex;
 
+/**
+ * @brief Ganho e exposição efetivos do sensor no momento de uma captura
+ */
+typedef struct {
+    uint16_t gain_x16;      ///< Ganho analógico efetivo (16 = 1x, 128 = 8x)
+    uint16_t exposure;      ///< Tempo de exposição em linhas (AEC)
+    bool from_registers;    ///< true se lido dos registradores, false se estimado do status
+} camera_exposure_t;
+
 /**
  * @brief Inicializa a câmera com configurações padrão
  * 
@@ -93,10 +104,39 @@ bool detect_green_tint(camera_fb_t *fb);
 esp_err_t smart_capture_with_correction(camera_fb_t **fb_out);
 
 /**
- * @brief Aplicar configurações adaptativas baseadas no horário
+ * @brief Aplicar o perfil do sensor (balanço de branco, saturação, ganho) do período
+ * @param period Período de iluminação classificado
+ */
+void apply_light_settings(light_period_t period);
+
+/**
+ * @brief Aplicar o perfil do período atual: luz medida, ou o horário se o
+ *        relógio já foi sincronizado por SNTP
+ *
+ * Sem luz medida e sem sincronização nada é aplicado (o sensor mantém o
+ * perfil atual), já que o relógio ainda marca 1970.
  */
 void apply_time_based_settings(void);
 
+/**
+ * @brief Lê o ganho e a exposição atuais do sensor (AGC/AEC)
+ *
+ * No OV2640 lê os registradores de ganho e AEC do banco do sensor; nos
+ * demais sensores usa os valores configurados em sensor->status.
+ *
+ * @param state Saída: ganho e exposição efetivos
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t camera_read_exposure_state(camera_exposure_t* state);
+
+/**
+ * @brief Ganho e exposição registrados na última captura inteligente
+ *
+ * @return camera_exposure_t Estado lido junto ao frame retornado por
+ *         smart_capture_with_correction() (gain_x16 = 0 se desconhecido)
+ */
+camera_exposure_t camera_get_last_exposure(void);
+
 /**
  * @brief Atualizar estatísticas de qualidade da imagem
  * @param had_green_tint true se houve tint verde
@@ -197,4 +197,17 @@ esp_err_t mqtt_wait_connected(uint32_t timeout_ms) {
     } else {
         return ESP_ERR_TIMEOUT;
     }
-} 
\ No newline at end of file
+} 
+
+esp_err_t wifi_get_rssi(int8_t *rssi) {
+    if (!rssi) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    wifi_ap_record_t ap_info;
+    esp_err_t err = esp_wifi_sta_get_ap_info(&ap_info);
+    if (err == ESP_OK) {
+        *rssi = ap_info.rssi;
+    }
+    return err;
+}
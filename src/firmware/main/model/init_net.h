@@ -6,6 +6,7 @@
  * - Inicialização do WiFi
  * - Inicialização do MQTT
  * - Gerenciamento de conexão
+ * - Intensidade do sinal do AP
  * 
  * @author Gabriel Passos - UNESP 2025
  */
@@ -65,4 +66,12 @@ esp_err_t wifi_wait_connected(uint32_t timeout_ms);
  */
 esp_err_t mqtt_wait_connected(uint32_t timeout_ms);
 
+/**
+ * @brief Lê o RSSI do AP associado
+ * 
+ * @param rssi Saída em dBm
+ * @return esp_err_t ESP_OK se associado, ESP_ERR_WIFI_NOT_CONNECT caso contrário
+ */
+esp_err_t wifi_get_rssi(int8_t *rssi);
+
 #endif // INIT_NET_H 
\ No newline at end of file
@@ -0,0 +1,181 @@
+/**
+ * @file lens_check.c
+ * @brief Implementação da detecção de obstrução da lente
+ *
+ * Gotas e embaçamento borram regiões do frame: a energia de alta frequência
+ * (variância do Laplaciano) cai em relação ao contraste do próprio bloco.
+ * A razão entre as duas variâncias independe da iluminação e é comparada
+ * com a linha de base aprendida de cada bloco.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#include "lens_check.h"
+#include "config.h"
+#include "esp_log.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "LENS_CHECK";
+
+#define LENS_VARIANCE_EPS          16   // Estabiliza a razão em blocos de pouco contraste
+#define LENS_MIN_TEXTURE_VARIANCE  40   // Variância mínima de luminância da linha de base para avaliar o bloco
+
+// Linha de base por bloco (nitidez normalizada e contraste)
+static uint32_t baseline_sharpness[COMPARE_MAX_BLOCKS];
+static uint32_t baseline_variance[COMPARE_MAX_BLOCKS];
+static uint16_t occluded_streak[COMPARE_MAX_BLOCKS];
+static uint32_t captures = 0;
+static bool last_obstructed = false;
+
+/**
+ * Variância a partir das somas (n·Σx² - (Σx)²) / n²
+ */
+static inline uint32_t block_variance(uint32_t n, int64_t sum, uint64_t sum_sq) {
+    if (n == 0) return 0;
+    int64_t num = (int64_t)n * (int64_t)sum_sq - sum * sum;
+    return num > 0 ? (uint32_t)(num / ((int64_t)n * n)) : 0;
+}
+
+static inline void ema_update(uint32_t* value, uint32_t sample) {
+    int64_t delta = (int64_t)sample - (int64_t)*value;
+    *value = (uint32_t)((int64_t)*value + delta / (1 << LENS_BASELINE_SHIFT));
+}
+
+esp_err_t lens_check_update(const luma_plane_t* plane, lens_status_t* status) {
+    if (!plane || !plane->pixels || !status) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const int width = plane->width;
+    const int height = plane->height;
+    const int blocks_x = width / COMPARE_BLOCK_SIZE;
+    const int blocks_y = height / COMPARE_BLOCK_SIZE;
+
+    if (blocks_x * blocks_y > COMPARE_MAX_BLOCKS) {
+        ESP_LOGE(TAG, "Plano %dx%d excede a grade configurada", width, height);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(status, 0, sizeof(lens_status_t));
+    const bool warmed_up = captures >= LENS_WARMUP_CAPTURES;
+
+    // Somas por bloco da faixa atual: Laplaciano (4 vizinhos) e luminância
+    int32_t sum_l[COMPARE_BLOCKS_X];
+    uint64_t sum_ll[COMPARE_BLOCKS_X];
+    uint32_t sum_i[COMPARE_BLOCKS_X];
+    uint32_t sum_ii[COMPARE_BLOCKS_X];
+    uint16_t count[COMPARE_BLOCKS_X];
+
+    for (int by = 0; by < blocks_y; by++) {
+        memset(sum_l, 0, sizeof(sum_l));
+        memset(sum_ll, 0, sizeof(sum_ll));
+        memset(sum_i, 0, sizeof(sum_i));
+        memset(sum_ii, 0, sizeof(sum_ii));
+        memset(count, 0, sizeof(count));
+
+        for (int y = by * COMPARE_BLOCK_SIZE; y < (by + 1) * COMPARE_BLOCK_SIZE; y++) {
+            // Laplaciano só em pixels internos do plano
+            if (y == 0 || y >= height - 1) continue;
+
+            const uint8_t *above = plane->pixels + (size_t)(y - 1) * width;
+            const uint8_t *row = plane->pixels + (size_t)y * width;
+            const uint8_t *below = plane->pixels + (size_t)(y + 1) * width;
+
+            for (int x = 1; x < blocks_x * COMPARE_BLOCK_SIZE && x < width - 1; x++) {
+                int c = row[x];
+                int lap = 4 * c - above[x] - below[x] - row[x - 1] - row[x + 1];
+                int bx = x / COMPARE_BLOCK_SIZE;
+
+                sum_l[bx] += lap;
+                sum_ll[bx] += (uint32_t)(lap * lap);
+                sum_i[bx] += c;
+                sum_ii[bx] += (uint32_t)(c * c);
+                count[bx]++;
+            }
+        }
+
+        for (int bx = 0; bx < blocks_x; bx++) {
+            int i = by * blocks_x + bx;
+            uint32_t var_lap = block_variance(count[bx], sum_l[bx], sum_ll[bx]);
+            uint32_t var_img = block_variance(count[bx], sum_i[bx], sum_ii[bx]);
+
+            // Nitidez normalizada pelo contraste do bloco (independe da iluminação)
+            uint32_t sharpness = (uint32_t)(((uint64_t)var_lap * 16) / (var_img + LENS_VARIANCE_EPS));
+
+            if (captures == 0) {
+                baseline_sharpness[i] = sharpness;
+                baseline_variance[i] = var_img;
+            }
+
+            bool evaluable = warmed_up && baseline_variance[i] >= LENS_MIN_TEXTURE_VARIANCE;
+            bool occluded = evaluable &&
+                            (uint64_t)sharpness * 100 < (uint64_t)baseline_sharpness[i] * LENS_SOFT_PERCENT;
+
+            if (evaluable) {
+                status->evaluated_blocks++;
+            }
+            if (occluded) {
+                status->occluded[i] = 1;
+                status->occluded_blocks++;
+                if (occluded_streak[i] < UINT16_MAX) occluded_streak[i]++;
+            } else {
+                occluded_streak[i] = 0;
+            }
+
+            // Linha de base segue apenas blocos nítidos; perda de nitidez muito
+            // longa é tratada como mudança real da cena e absorvida
+            if (!occluded || occluded_streak[i] >= LENS_REBASELINE_CAPTURES) {
+                ema_update(&baseline_sharpness[i], sharpness);
+                ema_update(&baseline_variance[i], var_img);
+            }
+        }
+    }
+
+    if (captures < UINT32_MAX) {
+        captures++;
+    }
+
+    status->warmed_up = warmed_up;
+    if (status->evaluated_blocks > 0) {
+        status->occluded_percent = (float)status->occluded_blocks / (float)status->evaluated_blocks * 100.0f;
+    }
+    status->obstructed = status->occluded_percent >= LENS_OBSTRUCTED_PERCENT;
+
+    if (status->obstructed != last_obstructed) {
+        if (status->obstructed) {
+            ESP_LOGW(TAG, "💧 Lente obstruída: %d/%d blocos sem nitidez (%.1f%%)",
+                     status->occluded_blocks, status->evaluated_blocks, status->occluded_percent);
+        } else {
+            ESP_LOGI(TAG, "✅ Lente desobstruída (%.1f%% dos blocos sem nitidez)", status->occluded_percent);
+        }
+        last_obstructed = status->obstructed;
+    }
+
+    return ESP_OK;
+}
+
+void lens_check_reset(void) {
+    memset(baseline_sharpness, 0, sizeof(baseline_sharpness));
+    memset(baseline_variance, 0, sizeof(baseline_variance));
+    memset(occluded_streak, 0, sizeof(occluded_streak));
+    captures = 0;
+    last_obstructed = false;
+    ESP_LOGI(TAG, "Linha de base de nitidez reiniciada");
+}
+
+void lens_check_export(lens_baseline_t* baseline) {
+    if (!baseline) return;
+    memcpy(baseline->sharpness, baseline_sharpness, sizeof(baseline_sharpness));
+    memcpy(baseline->variance, baseline_variance, sizeof(baseline_variance));
+    baseline->captures = captures;
+}
+
+void lens_check_import(const lens_baseline_t* baseline) {
+    if (!baseline) return;
+    memcpy(baseline_sharpness, baseline->sharpness, sizeof(baseline_sharpness));
+    memcpy(baseline_variance, baseline->variance, sizeof(baseline_variance));
+    memset(occluded_streak, 0, sizeof(occluded_streak));
+    captures = baseline->captures;
+    last_obstructed = false;
+    ESP_LOGI(TAG, "Linha de base de nitidez restaurada (%" PRIu32 " capturas)", captures);
+}
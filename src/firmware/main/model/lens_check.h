@@ -0,0 +1,80 @@
+/**
+ * @file lens_check.h
+ * @brief Detecção de obstrução da lente (gotas de chuva, embaçamento)
+ *
+ * Este módulo fornece funções para:
+ * - Nitidez por bloco (variância do Laplaciano) no plano de luminância da comparação
+ * - Linha de base de nitidez por bloco aprendida ao longo das capturas
+ * - Classificação de blocos "amolecidos" como obstruídos
+ * - Status "lens_obstructed" quando a obstrução cobre parte relevante do frame
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef LENS_CHECK_H
+#define LENS_CHECK_H
+
+#include "esp_err.h"
+#include "compare.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Resultado da verificação da lente para um frame
+ */
+typedef struct {
+    int occluded_blocks;                    ///< Blocos classificados como obstruídos
+    int evaluated_blocks;                   ///< Blocos com textura suficiente para avaliar
+    float occluded_percent;                 ///< Percentual de blocos avaliados obstruídos
+    bool obstructed;                        ///< Obstrução acima de LENS_OBSTRUCTED_PERCENT
+    bool warmed_up;                         ///< Linha de base pronta (LENS_WARMUP_CAPTURES)
+    uint8_t occluded[COMPARE_MAX_BLOCKS];   ///< 1 = bloco obstruído (máscara de exclusão)
+} lens_status_t;
+
+/**
+ * @brief Linha de base aprendida (persistida entre reinicializações)
+ */
+typedef struct {
+    uint32_t sharpness[COMPARE_MAX_BLOCKS];
+    uint32_t variance[COMPARE_MAX_BLOCKS];
+    uint32_t captures;
+} lens_baseline_t;
+
+/**
+ * @brief Atualiza a nitidez por bloco e classifica a obstrução da lente
+ *
+ * Reutiliza o plano já decodificado para a comparação (sem nova decodificação).
+ *
+ * @param plane Plano de luminância do frame atual
+ * @param status Saída: blocos obstruídos e status geral
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t lens_check_update(const luma_plane_t* plane, lens_status_t* status);
+
+/**
+ * @brief Descarta a linha de base (ex.: câmera reposicionada ou lente limpa)
+ */
+void lens_check_reset(void);
+
+/**
+ * @brief Copia a linha de base atual
+ *
+ * @param baseline Saída
+ */
+void lens_check_export(lens_baseline_t* baseline);
+
+/**
+ * @brief Restaura uma linha de base salva (dispensa o aquecimento)
+ *
+ * @param baseline Linha de base exportada anteriormente
+ */
+void lens_check_import(const lens_baseline_t* baseline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LENS_CHECK_H
@@ -0,0 +1,113 @@
+/**
+ * @file light_level.c
+ * @brief Implementação da classificação de iluminação
+ *
+ * EV = log2(luma) - log2(exposição) - log2(ganho) + LIGHT_EV_OFFSET.
+ * Com AEC/AGC ativos a luminância do frame fica quase constante, então a
+ * luz real aparece principalmente na exposição e no ganho escolhidos pelo
+ * sensor; sem esses dados o índice usa só a luminância.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "light_level.h"
+#include "config.h"
+#include "esp_log.h"
+#include <math.h>
+
+static const char *TAG = "LIGHT_LEVEL";
+
+static light_period_t confirmed = LIGHT_UNKNOWN;
+static light_period_t candidate = LIGHT_UNKNOWN;
+static int candidate_streak = 0;
+
+/**
+ * Classe do EV com histerese em torno do período confirmado
+ */
+static light_period_t classify(float ev) {
+    float day = LIGHT_DAY_EV;
+    float night = LIGHT_NIGHT_EV;
+
+    // Sair do período atual exige cruzar o limiar com folga
+    if (confirmed == LIGHT_DAY) {
+        day -= LIGHT_HYSTERESIS_EV;
+    } else if (confirmed == LIGHT_NIGHT) {
+        night += LIGHT_HYSTERESIS_EV;
+    } else if (confirmed == LIGHT_TWILIGHT) {
+        day += LIGHT_HYSTERESIS_EV;
+        night -= LIGHT_HYSTERESIS_EV;
+    }
+
+    if (ev >= day) return LIGHT_DAY;
+    if (ev < night) return LIGHT_NIGHT;
+    return LIGHT_TWILIGHT;
+}
+
+esp_err_t light_level_update(const luma_plane_t* plane, uint16_t gain_x16, uint16_t exposure,
+                             light_status_t* status) {
+    if (!plane || !plane->pixels || !status) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Média amostrada (1 a cada 4 pixels em cada direção)
+    uint32_t sum = 0, n = 0;
+    for (int y = 0; y < plane->height; y += 4) {
+        const uint8_t *row = plane->pixels + (size_t)y * plane->width;
+        for (int x = 0; x < plane->width; x += 4) {
+            sum += row[x];
+            n++;
+        }
+    }
+    float mean = n > 0 ? (float)sum / n : 0.0f;
+
+    float ev = log2f(fmaxf(mean, 1.0f)) + LIGHT_EV_OFFSET;
+    if (gain_x16 > 0 && exposure > 0) {
+        ev -= log2f((float)exposure) + log2f(gain_x16 / 16.0f);
+    } else {
+        ev -= LIGHT_NOMINAL_EXPOSURE_EV;
+    }
+
+    light_period_t period = classify(ev);
+    status->changed = false;
+
+    // Primeiro frame define o período; depois exige capturas consecutivas
+    if (confirmed == LIGHT_UNKNOWN) {
+        confirmed = period;
+        candidate_streak = 0;
+        ESP_LOGI(TAG, "💡 Iluminação inicial: %s (EV %.1f)", light_level_name(period), ev);
+    } else if (period != confirmed) {
+        if (period == candidate) {
+            candidate_streak++;
+        } else {
+            candidate = period;
+            candidate_streak = 1;
+        }
+        if (candidate_streak >= LIGHT_CONFIRM_CAPTURES) {
+            ESP_LOGI(TAG, "💡 Iluminação: %s -> %s (EV %.1f, luma %.0f)",
+                     light_level_name(confirmed), light_level_name(period), ev, mean);
+            confirmed = period;
+            candidate_streak = 0;
+            status->changed = true;
+        }
+    } else {
+        candidate_streak = 0;
+    }
+
+    status->period = confirmed;
+    status->ev = ev;
+    status->mean_luma = mean;
+    return ESP_OK;
+}
+
+light_period_t light_level_current(void) {
+    return confirmed;
+}
+
+const char* light_level_name(light_period_t period) {
+    switch (period) {
+        case LIGHT_DAY: return "day";
+        case LIGHT_TWILIGHT: return "twilight";
+        case LIGHT_NIGHT: return "night";
+        default: return "unknown";
+    }
+}
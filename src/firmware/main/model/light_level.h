@@ -0,0 +1,70 @@
+/**
+ * @file light_level.h
+ * @brief Classificação dia/crepúsculo/noite pela luz medida na cena
+ *
+ * Este módulo fornece funções para:
+ * - Índice de luz em escala de EV a partir da luminância média do plano
+ *   reduzido, normalizada pela exposição e pelo ganho do sensor
+ * - Classificação com histerese e confirmação por capturas consecutivas,
+ *   independente do relógio
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef LIGHT_LEVEL_H
+#define LIGHT_LEVEL_H
+
+#include "esp_err.h"
+#include "compare.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Período de iluminação
+ */
+typedef enum {
+    LIGHT_UNKNOWN = 0,
+    LIGHT_NIGHT,
+    LIGHT_TWILIGHT,
+    LIGHT_DAY,
+} light_period_t;
+
+/**
+ * @brief Resultado da classificação de um frame
+ */
+typedef struct {
+    light_period_t period;      ///< Período confirmado
+    float ev;                   ///< Índice de luz (log2; maior = mais claro)
+    float mean_luma;            ///< Luminância média do plano (0-255)
+    bool changed;               ///< Período confirmado mudou neste frame
+} light_status_t;
+
+/**
+ * Classifica a iluminação do frame atual
+ * @param plane Plano de luminância reduzido
+ * @param gain_x16 Ganho do sensor na captura (16 = 1x, 0 = desconhecido)
+ * @param exposure Exposição AEC em linhas (0 = desconhecida)
+ * @param status Saída
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t light_level_update(const luma_plane_t* plane, uint16_t gain_x16, uint16_t exposure,
+                             light_status_t* status);
+
+/**
+ * Período confirmado atual
+ */
+light_period_t light_level_current(void);
+
+/**
+ * Nome do período ("day", "twilight", "night", "unknown")
+ */
+const char* light_level_name(light_period_t period);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIGHT_LEVEL_H
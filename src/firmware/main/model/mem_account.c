@@ -0,0 +1,161 @@
+/**
+ * @file mem_account.c
+ * @brief Implementação da contabilidade de memória por subsistema
+ *
+ * O cabeçalho tem 16 bytes para manter o alinhamento que heap_caps_malloc
+ * garante ao ponteiro devolvido. Os contadores são atômicos: alocações
+ * de MQTT e da tarefa de monitoramento podem ocorrer em paralelo.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "mem_account.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "MEM_ACCOUNT";
+
+#define MEM_HEADER_MAGIC 0x4D454D41  // "MEMA"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t tag;
+    uint32_t reserved;
+} mem_header_t;
+
+_Static_assert(sizeof(mem_header_t) == 16, "cabeçalho deve preservar alinhamento de 16 bytes");
+
+typedef struct {
+    atomic_size_t live;
+    atomic_size_t peak;
+    atomic_uint allocs;
+    atomic_uint frees;
+    atomic_uint failures;
+} tag_counters_t;
+
+static tag_counters_t counters[MEM_TAG_COUNT];
+static atomic_size_t tracked_live;
+static atomic_size_t tracked_peak;
+
+static const char *tag_names[MEM_TAG_COUNT] = {
+    [MEM_TAG_COMPARE] = "compare",
+    [MEM_TAG_FRAME_POOL] = "frame_pool",
+    [MEM_TAG_SIGNATURE] = "signature",
+    [MEM_TAG_TIME_SERIES] = "time_series",
+    [MEM_TAG_MQTT] = "mqtt",
+    [MEM_TAG_STATE] = "state",
+    [MEM_TAG_MAIN] = "main",
+};
+
+static void update_peak(atomic_size_t* peak, size_t value) {
+    size_t current = atomic_load(peak);
+    while (value > current && !atomic_compare_exchange_weak(peak, &current, value)) {
+    }
+}
+
+void* mem_alloc(mem_tag_t tag, size_t size, uint32_t caps) {
+    if (tag >= MEM_TAG_COUNT) {
+        tag = MEM_TAG_MAIN;
+    }
+
+    mem_header_t *header = (mem_header_t*)heap_caps_malloc(sizeof(mem_header_t) + size, caps);
+    if (!header) {
+        atomic_fetch_add(&counters[tag].failures, 1);
+        return NULL;
+    }
+
+    header->magic = MEM_HEADER_MAGIC;
+    header->size = (uint32_t)size;
+    header->tag = tag;
+    header->reserved = 0;
+
+    size_t live = atomic_fetch_add(&counters[tag].live, size) + size;
+    update_peak(&counters[tag].peak, live);
+    atomic_fetch_add(&counters[tag].allocs, 1);
+    update_peak(&tracked_peak, atomic_fetch_add(&tracked_live, size) + size);
+
+    return header + 1;
+}
+
+void mem_free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    mem_header_t *header = (mem_header_t*)ptr - 1;
+    if (header->magic != MEM_HEADER_MAGIC || header->tag >= MEM_TAG_COUNT) {
+        // Ponteiro não veio de mem_alloc(): liberar direto e sinalizar
+        ESP_LOGE(TAG, "❌ mem_free() em ponteiro não contabilizado %p", ptr);
+        free(ptr);
+        return;
+    }
+
+    tag_counters_t *c = &counters[header->tag];
+    atomic_fetch_sub(&c->live, header->size);
+    atomic_fetch_add(&c->frees, 1);
+    atomic_fetch_sub(&tracked_live, header->size);
+
+    header->magic = 0;  // Detecta liberação dupla
+    free(header);
+}
+
+void mem_account_get_tag(mem_tag_t tag, mem_tag_stats_t* stats) {
+    if (!stats || tag >= MEM_TAG_COUNT) return;
+
+    stats->live_bytes = atomic_load(&counters[tag].live);
+    stats->peak_bytes = atomic_load(&counters[tag].peak);
+    stats->allocs = atomic_load(&counters[tag].allocs);
+    stats->frees = atomic_load(&counters[tag].frees);
+    stats->failures = atomic_load(&counters[tag].failures);
+}
+
+static void heap_snapshot(uint32_t caps, mem_heap_stats_t* heap) {
+    heap->total = heap_caps_get_total_size(caps);
+    heap->free = heap_caps_get_free_size(caps);
+    heap->minimum_free = heap_caps_get_minimum_free_size(caps);
+    heap->largest_free_block = heap_caps_get_largest_free_block(caps);
+}
+
+void mem_account_snapshot(mem_account_report_t* report) {
+    if (!report) return;
+
+    memset(report, 0, sizeof(mem_account_report_t));
+    for (int i = 0; i < MEM_TAG_COUNT; i++) {
+        mem_account_get_tag((mem_tag_t)i, &report->tags[i]);
+    }
+    report->tracked_live = atomic_load(&tracked_live);
+    report->tracked_peak = atomic_load(&tracked_peak);
+    heap_snapshot(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, &report->internal);
+    heap_snapshot(MALLOC_CAP_SPIRAM, &report->psram);
+}
+
+const char* mem_account_tag_name(mem_tag_t tag) {
+    return tag < MEM_TAG_COUNT ? tag_names[tag] : "unknown";
+}
+
+void mem_account_log(void) {
+    static mem_account_report_t report;  // ~200 bytes fora da pilha
+    mem_account_snapshot(&report);
+
+    ESP_LOGI(TAG, "📊 === MEMÓRIA POR SUBSISTEMA ===");
+    for (int i = 0; i < MEM_TAG_COUNT; i++) {
+        const mem_tag_stats_t *t = &report.tags[i];
+        if (t->allocs == 0 && t->failures == 0) continue;
+        ESP_LOGI(TAG, "   %-12s %7" PRIu32 " KB vivos | pico %7" PRIu32 " KB | %" PRIu32 " aloc / %" PRIu32 " lib%s",
+                 mem_account_tag_name((mem_tag_t)i),
+                 (uint32_t)(t->live_bytes / 1024), (uint32_t)(t->peak_bytes / 1024),
+                 t->allocs, t->frees, t->failures ? " | FALHAS" : "");
+    }
+    ESP_LOGI(TAG, "💾 Contabilizado: %" PRIu32 " KB (pico %" PRIu32 " KB)",
+             (uint32_t)(report.tracked_live / 1024), (uint32_t)(report.tracked_peak / 1024));
+    ESP_LOGI(TAG, "💾 Interna: %" PRIu32 "/%" PRIu32 " KB livres | mínimo %" PRIu32 " KB | maior bloco %" PRIu32 " KB",
+             (uint32_t)(report.internal.free / 1024), (uint32_t)(report.internal.total / 1024),
+             (uint32_t)(report.internal.minimum_free / 1024), (uint32_t)(report.internal.largest_free_block / 1024));
+    ESP_LOGI(TAG, "💾 PSRAM: %" PRIu32 "/%" PRIu32 " KB livres | mínimo %" PRIu32 " KB | maior bloco %" PRIu32 " KB",
+             (uint32_t)(report.psram.free / 1024), (uint32_t)(report.psram.total / 1024),
+             (uint32_t)(report.psram.minimum_free / 1024), (uint32_t)(report.psram.largest_free_block / 1024));
+}
@@ -0,0 +1,110 @@
+/**
+ * @file mem_account.h
+ * @brief Contabilidade de memória por subsistema
+ *
+ * Alocações feitas por mem_alloc() levam um cabeçalho com tamanho e tag,
+ * de modo que mem_free() sabe quanto devolver à tag sem consultar o heap.
+ * Para cada tag são mantidos bytes vivos, pico, contagem de alocações,
+ * liberações e falhas; o relatório acrescenta livre, mínimo histórico e
+ * maior bloco livre da RAM interna e da PSRAM, medidos na hora.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#ifndef MEM_ACCOUNT_H
+#define MEM_ACCOUNT_H
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Subsistemas contabilizados
+ */
+typedef enum {
+    MEM_TAG_COMPARE = 0,        ///< Planos de luminância, RGB565 e faixa de bordas
+    MEM_TAG_FRAME_POOL,         ///< Slots de JPEG compartilhados e miniaturas do histórico
+    MEM_TAG_SIGNATURE,          ///< Anel de assinaturas de 24 h
+    MEM_TAG_TIME_SERIES,        ///< Janela da série temporal
+    MEM_TAG_MQTT,               ///< Base64, máscaras e JSON (cJSON)
+    MEM_TAG_STATE,              ///< Persistência na flash
+    MEM_TAG_MAIN,               ///< Laços principais
+    MEM_TAG_COUNT
+} mem_tag_t;
+
+/**
+ * @brief Contadores de uma tag
+ */
+typedef struct {
+    size_t live_bytes;          ///< Bytes alocados no momento
+    size_t peak_bytes;          ///< Maior valor de live_bytes
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;          ///< Alocações que retornaram NULL
+} mem_tag_stats_t;
+
+/**
+ * @brief Estado de um heap (por capacidade)
+ */
+typedef struct {
+    size_t total;
+    size_t free;
+    size_t minimum_free;        ///< Menor valor livre desde o boot
+    size_t largest_free_block;  ///< Fragmentação: maior alocação possível
+} mem_heap_stats_t;
+
+/**
+ * @brief Relatório completo
+ */
+typedef struct {
+    mem_tag_stats_t tags[MEM_TAG_COUNT];
+    size_t tracked_live;        ///< Soma dos bytes vivos das tags
+    size_t tracked_peak;        ///< Maior soma observada
+    mem_heap_stats_t internal;
+    mem_heap_stats_t psram;
+} mem_account_report_t;
+
+/**
+ * Aloca memória contabilizada na tag
+ * @param tag Subsistema dono
+ * @param size Bytes úteis
+ * @param caps Capacidades do heap (MALLOC_CAP_*)
+ * @return Ponteiro ou NULL
+ */
+void* mem_alloc(mem_tag_t tag, size_t size, uint32_t caps);
+
+/**
+ * Libera memória obtida com mem_alloc() (NULL é ignorado)
+ */
+void mem_free(void* ptr);
+
+/**
+ * Obtém os contadores de uma tag
+ */
+void mem_account_get_tag(mem_tag_t tag, mem_tag_stats_t* stats);
+
+/**
+ * Preenche o relatório com os contadores e o estado atual dos heaps
+ */
+void mem_account_snapshot(mem_account_report_t* report);
+
+/**
+ * Nome curto da tag (chave no JSON de telemetria)
+ */
+const char* mem_account_tag_name(mem_tag_t tag);
+
+/**
+ * Imprime o relatório no log
+ */
+void mem_account_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_ACCOUNT_H
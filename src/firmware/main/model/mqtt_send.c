@@ -15,9 +15,37 @@
 #include <string.h>
 #include "init_net.h"
 #include "mbedtls/base64.h"
+#include "mem_account.h"
+#include "time_sync.h"
 
 static const char *TAG = "MQTT_SEND";
 
+static void* json_malloc(size_t size) {
+    return mem_alloc(MEM_TAG_MQTT, size, MALLOC_CAP_DEFAULT);
+}
+
+// Timestamp da captura, não do envio: a fila de publicação pode atrasar segundos
+static uint64_t capture_timestamp(int64_t captured_us) {
+    return captured_us > 0 ? time_sync_timestamp_at(captured_us) : time_sync_timestamp();
+}
+
+// Instante exato da captura em época Unix (ms), omitido sem sincronização
+static void add_captured_ms(cJSON* root, int64_t captured_us) {
+    int64_t epoch_ms = captured_us > 0 ? time_sync_to_epoch_ms(captured_us) : 0;
+    if (epoch_ms != 0) {
+        cJSON_AddNumberToObject(root, "captured_ms", (double)epoch_ms);
+    }
+}
+
+void mqtt_send_track_json_memory(void) {
+    // Payloads JSON passam a contar na tag MQTT; liberar sempre com cJSON_free()
+    cJSON_Hooks hooks = {
+        .malloc_fn = json_malloc,
+        .free_fn = mem_free,
+    };
+    cJSON_InitHooks(&hooks);
+}
+
 esp_err_t mqtt_send_image(camera_fb_t* frame, const char* topic) {
     if (!frame || !topic) {
         ESP_LOGE(TAG, "Parâmetros inválidos");
@@ -31,7 +59,7 @@ esp_err_t mqtt_send_image(camera_fb_t* frame, const char* topic) {
 
     // Calcular tamanho necessário para base64 (4/3 do tamanho original + padding)
     size_t base64_len = ((frame->len + 2) / 3) * 4 + 1;
-    char* base64_buffer = malloc(base64_len);
+    char* base64_buffer = mem_alloc(MEM_TAG_MQTT, base64_len, MALLOC_CAP_DEFAULT);
     if (!base64_buffer) {
         ESP_LOGE(TAG, "Falha ao alocar memória para base64");
         return ESP_ERR_NO_MEM;
@@ -42,14 +70,14 @@ esp_err_t mqtt_send_image(camera_fb_t* frame, const char* topic) {
     int ret = mbedtls_base64_encode((unsigned char*)base64_buffer, base64_len, &out_len, frame->buf, frame->len);
     if (ret != 0) {
         ESP_LOGE(TAG, "Falha na codificação base64: %d", ret);
-        free(base64_buffer);
+        mem_free(base64_buffer);
         return ESP_FAIL;
     }
 
     // Criar JSON com a imagem em base64
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
-    cJSON_AddNumberToObject(root, "timestamp", esp_timer_get_time() / 1000000);
+    cJSON_AddNumberToObject(root, "timestamp", time_sync_timestamp());
     cJSON_AddNumberToObject(root, "width", frame->width);
     cJSON_AddNumberToObject(root, "height", frame->height);
     cJSON_AddNumberToObject(root, "format", frame->format);
@@ -59,7 +87,7 @@ esp_err_t mqtt_send_image(camera_fb_t* frame, const char* topic) {
     
     char *json_payload = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
-    free(base64_buffer);
+    mem_free(base64_buffer);
 
     if (!json_payload) {
         ESP_LOGE(TAG, "Falha ao criar JSON payload");
@@ -68,7 +96,7 @@ esp_err_t mqtt_send_image(camera_fb_t* frame, const char* topic) {
 
     // Enviar JSON com imagem via MQTT
     int msg_id = esp_mqtt_client_publish(mqtt_client, topic, json_payload, strlen(json_payload), 1, 0);
-    free(json_payload);
+    cJSON_free(json_payload);
 
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Falha ao publicar imagem via MQTT");
@@ -80,6 +108,11 @@ esp_err_t mqtt_send_image(camera_fb_t* frame, const char* topic) {
 }
 
 esp_err_t mqtt_send_image_with_info(camera_fb_t* frame, const char* topic, const char* reason, float difference) {
+    return mqtt_send_image_with_info_ext(frame, topic, reason, difference, NULL);
+}
+
+esp_err_t mqtt_send_image_with_info_ext(camera_fb_t* frame, const char* topic, const char* reason,
+                                        float difference, const mqtt_frame_info_t* info) {
     if (!frame || !topic || !reason) {
         ESP_LOGE(TAG, "Parâmetros inválidos");
         return ESP_ERR_INVALID_ARG;
@@ -92,7 +125,7 @@ esp_err_t mqtt_send_image_with_info(camera_fb_t* frame, const char* topic, const
 
     // Calcular tamanho necessário para base64 (4/3 do tamanho original + padding)
     size_t base64_len = ((frame->len + 2) / 3) * 4 + 1;
-    char* base64_buffer = malloc(base64_len);
+    char* base64_buffer = mem_alloc(MEM_TAG_MQTT, base64_len, MALLOC_CAP_DEFAULT);
     if (!base64_buffer) {
         ESP_LOGE(TAG, "Falha ao alocar memória para base64");
         return ESP_ERR_NO_MEM;
@@ -103,14 +136,16 @@ esp_err_t mqtt_send_image_with_info(camera_fb_t* frame, const char* topic, const
     int ret = mbedtls_base64_encode((unsigned char*)base64_buffer, base64_len, &out_len, frame->buf, frame->len);
     if (ret != 0) {
         ESP_LOGE(TAG, "Falha na codificação base64: %d", ret);
-        free(base64_buffer);
+        mem_free(base64_buffer);
         return ESP_FAIL;
     }
 
     // Criar JSON com a imagem em base64 e informações adicionais
+    int64_t captured_us = info ? info->captured_us : 0;
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
-    cJSON_AddNumberToObject(root, "timestamp", esp_timer_get_time() / 1000000);
+    cJSON_AddNumberToObject(root, "timestamp", capture_timestamp(captured_us));
+    add_captured_ms(root, captured_us);
     cJSON_AddNumberToObject(root, "width", frame->width);
     cJSON_AddNumberToObject(root, "height", frame->height);
     cJSON_AddNumberToObject(root, "format", frame->format);
@@ -122,11 +157,24 @@ esp_err_t mqtt_send_image_with_info(camera_fb_t* frame, const char* topic, const
         cJSON_AddNumberToObject(root, "difference", difference);
     }
     
+    // Estado do sensor na captura (ganho 16 = 1x)
+    if (info && info->gain_x16 > 0) {
+        cJSON_AddNumberToObject(root, "gain", info->gain_x16 / 16.0);
+        cJSON_AddNumberToObject(root, "exposure", info->exposure);
+    }
+    
+    // Hash perceptual em hex (64 bits não cabem com precisão em número JSON)
+    if (info && info->has_phash) {
+        char phash_hex[17];
+        snprintf(phash_hex, sizeof(phash_hex), "%016llx", (unsigned long long)info->phash);
+        cJSON_AddStringToObject(root, "phash", phash_hex);
+    }
+    
     cJSON_AddStringToObject(root, "image", base64_buffer);
     
     char *json_payload = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
-    free(base64_buffer);
+    mem_free(base64_buffer);
 
     if (!json_payload) {
         ESP_LOGE(TAG, "Falha ao criar JSON payload");
@@ -135,7 +183,7 @@ esp_err_t mqtt_send_image_with_info(camera_fb_t* frame, const char* topic, const
 
     // Enviar JSON com imagem via MQTT
     int msg_id = esp_mqtt_client_publish(mqtt_client, topic, json_payload, strlen(json_payload), 1, 0);
-    free(json_payload);
+    cJSON_free(json_payload);
 
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Falha ao publicar imagem via MQTT");
@@ -147,6 +195,11 @@ esp_err_t mqtt_send_image_with_info(camera_fb_t* frame, const char* topic, const
 }
 
 esp_err_t mqtt_send_monitoring(uint32_t free_heap, uint32_t free_psram, uint32_t uptime) {
+    return mqtt_send_monitoring_ext(free_heap, free_psram, uptime, NULL);
+}
+
+esp_err_t mqtt_send_monitoring_ext(uint32_t free_heap, uint32_t free_psram, uint32_t uptime,
+                                   const mqtt_status_info_t* info) {
     if (!mqtt_client) {
         ESP_LOGE(TAG, "Cliente MQTT não inicializado");
         return ESP_ERR_INVALID_STATE;
@@ -165,6 +218,18 @@ esp_err_t mqtt_send_monitoring(uint32_t free_heap, uint32_t free_psram, uint32_t
     cJSON_AddNumberToObject(root, "free_psram", free_psram);
     cJSON_AddNumberToObject(root, "min_free_heap", min_free_heap);
     cJSON_AddNumberToObject(root, "uptime", uptime);
+    cJSON_AddBoolToObject(root, "time_synced", time_sync_is_synced());
+    
+    if (info && info->has_quantiles) {
+        cJSON *quantiles = cJSON_AddObjectToObject(root, "difference_quantiles");
+        if (quantiles) {
+            cJSON_AddNumberToObject(quantiles, "samples", info->samples);
+            cJSON_AddNumberToObject(quantiles, "median", info->median);
+            cJSON_AddNumberToObject(quantiles, "p95", info->p95);
+            cJSON_AddNumberToObject(quantiles, "p99", info->p99);
+            cJSON_AddNumberToObject(quantiles, "mad", info->mad);
+        }
+    }
     
     char *payload = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
@@ -178,7 +243,7 @@ esp_err_t mqtt_send_monitoring(uint32_t free_heap, uint32_t free_psram, uint32_t
     snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_STATUS);
     
     int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, strlen(payload), 1, 0);
-    free(payload);
+    cJSON_free(payload);
     
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Falha ao publicar status via MQTT");
@@ -189,6 +254,11 @@ esp_err_t mqtt_send_monitoring(uint32_t free_heap, uint32_t free_psram, uint32_t
 }
 
 esp_err_t mqtt_send_alert(float difference_percent, camera_fb_t* frame) {
+    return mqtt_send_alert_ext(difference_percent, frame, 0, 0);
+}
+
+esp_err_t mqtt_send_alert_ext(float difference_percent, camera_fb_t* frame, uint32_t alert_id,
+                              int64_t captured_us) {
     if (!mqtt_client) {
         ESP_LOGE(TAG, "Cliente MQTT não inicializado");
         return ESP_ERR_INVALID_STATE;
@@ -199,7 +269,11 @@ esp_err_t mqtt_send_alert(float difference_percent, camera_fb_t* frame) {
     cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
     cJSON_AddNumberToObject(root, "difference", difference_percent);
     cJSON_AddStringToObject(root, "type", "motion");
-    cJSON_AddNumberToObject(root, "timestamp", esp_timer_get_time() / 1000000);
+    cJSON_AddNumberToObject(root, "timestamp", capture_timestamp(captured_us));
+    add_captured_ms(root, captured_us);
+    if (alert_id > 0) {
+        cJSON_AddNumberToObject(root, "alert_id", alert_id);
+    }
     
     char *payload = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
@@ -208,7 +282,7 @@ esp_err_t mqtt_send_alert(float difference_percent, camera_fb_t* frame) {
     snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_ALERT);
     
     esp_mqtt_client_publish(mqtt_client, topic, payload, strlen(payload), 1, 0);
-    free(payload);
+    cJSON_free(payload);
 
     // Se configurado, envia a imagem
     if (SEND_IMAGE_ON_ALERT && frame) {
@@ -222,6 +296,13 @@ esp_err_t mqtt_send_alert(float difference_percent, camera_fb_t* frame) {
 esp_err_t mqtt_send_monitoring_data(float difference, uint32_t image_size, 
                                    uint16_t width, uint16_t height, 
                                    uint8_t format, const char* device_id) {
+    return mqtt_send_monitoring_data_ext(difference, image_size, width, height, format, device_id, NULL);
+}
+
+esp_err_t mqtt_send_monitoring_data_ext(float difference, uint32_t image_size,
+                                       uint16_t width, uint16_t height,
+                                       uint8_t format, const char* device_id,
+                                       const mqtt_frame_info_t* info) {
     if (!mqtt_client) {
         ESP_LOGE(TAG, "Cliente MQTT não inicializado");
         return ESP_ERR_INVALID_STATE;
@@ -236,8 +317,8 @@ esp_err_t mqtt_send_monitoring_data(float difference, uint32_t image_size,
         ESP_LOGW(TAG, "Diferença fora do range esperado: %.3f%%", difference);
     }
     
-    char payload[300];
-    uint64_t timestamp = esp_timer_get_time() / 1000000LL;
+    char payload[400];
+    uint64_t timestamp = capture_timestamp(info ? info->captured_us : 0);
     
     int ret = snprintf(payload, sizeof(payload),
         "{"
@@ -249,10 +330,31 @@ esp_err_t mqtt_send_monitoring_data(float difference, uint32_t image_size,
         "\"height\":%u,"
         "\"format\":%u,"
         "\"location\":\"monitoring_esp32cam\","
-        "\"mode\":\"image_comparison\""
-        "}",
+        "\"mode\":\"image_comparison\"",
         timestamp, device_id, difference, image_size, width, height, format);
     
+    // Estado do sensor na captura (ganho 16 = 1x)
+    if (ret > 0 && ret < sizeof(payload) && info && info->gain_x16 > 0) {
+        ret += snprintf(payload + ret, sizeof(payload) - ret,
+                        ",\"gain\":%.2f,\"exposure\":%u",
+                        info->gain_x16 / 16.0f, info->exposure);
+    }
+    if (ret > 0 && ret < sizeof(payload) && info && info->has_phash) {
+        ret += snprintf(payload + ret, sizeof(payload) - ret,
+                        ",\"phash\":\"%016llx\"", (unsigned long long)info->phash);
+    }
+    if (ret > 0 && ret < sizeof(payload) && info && info->light) {
+        ret += snprintf(payload + ret, sizeof(payload) - ret,
+                        ",\"light\":\"%s\",\"light_ev\":%.1f", info->light, info->light_ev);
+    }
+    if (ret > 0 && ret < sizeof(payload) && info && info->weather) {
+        ret += snprintf(payload + ret, sizeof(payload) - ret,
+                        ",\"weather\":\"%s\",\"haze\":%.2f", info->weather, info->haze);
+    }
+    if (ret > 0 && ret < sizeof(payload)) {
+        ret += snprintf(payload + ret, sizeof(payload) - ret, "}");
+    }
+    
     if (ret < 0 || ret >= sizeof(payload)) {
         ESP_LOGE(TAG, "Erro ao formatar payload");
         return ESP_ERR_INVALID_SIZE;
@@ -269,6 +371,489 @@ esp_err_t mqtt_send_monitoring_data(float difference, uint32_t image_size,
     return ESP_OK;
 }
 
+esp_err_t mqtt_send_nuisance_mask(const uint8_t* rate_percent, const uint8_t* masked,
+                                  int blocks_x, int blocks_y) {
+    if (!mqtt_client) {
+        ESP_LOGE(TAG, "Cliente MQTT não inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int blocks = blocks_x * blocks_y;
+    if (!rate_percent || !masked || blocks <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Máscara como string de '0'/'1' (linha a linha) e taxas como vetor inteiro
+    char *mask_str = mem_alloc(MEM_TAG_MQTT, blocks + 1, MALLOC_CAP_DEFAULT);
+    int *rates = mem_alloc(MEM_TAG_MQTT, blocks * sizeof(int), MALLOC_CAP_DEFAULT);
+    if (!mask_str || !rates) {
+        mem_free(mask_str);
+        mem_free(rates);
+        ESP_LOGE(TAG, "Falha ao alocar memória para a máscara");
+        return ESP_ERR_NO_MEM;
+    }
+
+    int masked_count = 0;
+    for (int i = 0; i < blocks; i++) {
+        mask_str[i] = masked[i] ? '1' : '0';
+        masked_count += masked[i] ? 1 : 0;
+        rates[i] = rate_percent[i];
+    }
+    mask_str[blocks] = '\0';
+
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        mem_free(mask_str);
+        mem_free(rates);
+        ESP_LOGE(TAG, "Falha ao criar objeto JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
+    cJSON_AddNumberToObject(root, "timestamp", time_sync_timestamp());
+    cJSON_AddNumberToObject(root, "blocks_x", blocks_x);
+    cJSON_AddNumberToObject(root, "blocks_y", blocks_y);
+    cJSON_AddNumberToObject(root, "masked_blocks", masked_count);
+    cJSON_AddStringToObject(root, "mask", mask_str);
+    cJSON_AddItemToObject(root, "change_rate", cJSON_CreateIntArray(rates, blocks));
+    mem_free(mask_str);
+    mem_free(rates);
+
+    char *payload = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    if (!payload) {
+        ESP_LOGE(TAG, "Falha ao serializar JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_NUISANCE);
+
+    // Retida: operadores veem a máscara atual ao se conectar
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, strlen(payload), 1, 1);
+    cJSON_free(payload);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Falha ao publicar máscara via MQTT");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "🌳 Máscara publicada: %d/%d blocos mascarados", masked_count, blocks);
+    return ESP_OK;
+}
+
+esp_err_t mqtt_send_lens_status(bool obstructed, int occluded_blocks, int evaluated_blocks,
+                                float occluded_percent, const uint8_t* occluded,
+                                int blocks_x, int blocks_y) {
+    if (!mqtt_client) {
+        ESP_LOGE(TAG, "Cliente MQTT não inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int blocks = blocks_x * blocks_y;
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        ESP_LOGE(TAG, "Falha ao criar objeto JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
+    cJSON_AddNumberToObject(root, "timestamp", time_sync_timestamp());
+    cJSON_AddStringToObject(root, "status", obstructed ? "lens_obstructed" : "lens_clear");
+    cJSON_AddNumberToObject(root, "occluded_blocks", occluded_blocks);
+    cJSON_AddNumberToObject(root, "evaluated_blocks", evaluated_blocks);
+    cJSON_AddNumberToObject(root, "occluded_percent", occluded_percent);
+
+    // Mapa de blocos obstruídos como string de '0'/'1' (linha a linha)
+    char *mask_str = (occluded && blocks > 0) ? mem_alloc(MEM_TAG_MQTT, blocks + 1, MALLOC_CAP_DEFAULT) : NULL;
+    if (mask_str) {
+        for (int i = 0; i < blocks; i++) {
+            mask_str[i] = occluded[i] ? '1' : '0';
+        }
+        mask_str[blocks] = '\0';
+        cJSON_AddNumberToObject(root, "blocks_x", blocks_x);
+        cJSON_AddNumberToObject(root, "blocks_y", blocks_y);
+        cJSON_AddStringToObject(root, "mask", mask_str);
+        mem_free(mask_str);
+    }
+
+    char *payload = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    if (!payload) {
+        ESP_LOGE(TAG, "Falha ao serializar JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_LENS);
+
+    // Retida: o último status da lente fica disponível para novos assinantes
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, strlen(payload), 1, 1);
+    cJSON_free(payload);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Falha ao publicar status da lente via MQTT");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mqtt_send_water_level(float level_percent, float confidence, float rate_per_hour,
+                                int64_t captured_us) {
+    if (!mqtt_client) {
+        ESP_LOGE(TAG, "Cliente MQTT não inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Mensagem mínima: dezenas de bytes por captura em vez de uma imagem
+    char payload[128];
+    uint64_t timestamp = capture_timestamp(captured_us);
+
+    int ret = snprintf(payload, sizeof(payload),
+        "{\"ts\":%llu,\"dev\":\"%s\",\"level\":%.1f,\"conf\":%.2f,\"rate\":%.2f}",
+        timestamp, DEVICE_ID, level_percent, confidence, rate_per_hour);
+
+    if (ret < 0 || ret >= sizeof(payload)) {
+        ESP_LOGE(TAG, "Erro ao formatar payload de nível");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_LEVEL);
+
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, ret, 1, 0);
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Falha ao publicar nível via MQTT");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mqtt_send_clip_frame(camera_fb_t* fb, const mqtt_clip_info_t* info) {
+    if (!fb || !fb->buf || !info) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!mqtt_client) {
+        ESP_LOGE(TAG, "Cliente MQTT não inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t base64_len = ((fb->len + 2) / 3) * 4 + 1;
+    char* base64_buffer = mem_alloc(MEM_TAG_MQTT, base64_len, MALLOC_CAP_DEFAULT);
+    if (!base64_buffer) {
+        ESP_LOGE(TAG, "Falha ao alocar memória para base64");
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t out_len = 0;
+    int ret = mbedtls_base64_encode((unsigned char*)base64_buffer, base64_len, &out_len, fb->buf, fb->len);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Falha na codificação base64: %d", ret);
+        mem_free(base64_buffer);
+        return ESP_FAIL;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        mem_free(base64_buffer);
+        ESP_LOGE(TAG, "Falha ao criar objeto JSON");
+        return ESP_ERR_NO_MEM;
+    }
+    cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
+    cJSON_AddNumberToObject(root, "alert_id", info->alert_id);
+    cJSON_AddNumberToObject(root, "timestamp", capture_timestamp(info->captured_us));
+    add_captured_ms(root, info->captured_us);
+    cJSON_AddNumberToObject(root, "index", info->index);
+    cJSON_AddNumberToObject(root, "count", info->count);
+    cJSON_AddNumberToObject(root, "offset_ms", info->offset_ms);
+    cJSON_AddNumberToObject(root, "difference", info->difference);
+    cJSON_AddBoolToObject(root, "thumbnail", info->thumbnail);
+    cJSON_AddNumberToObject(root, "width", fb->width);
+    cJSON_AddNumberToObject(root, "height", fb->height);
+    cJSON_AddNumberToObject(root, "size", fb->len);
+    cJSON_AddStringToObject(root, "image", base64_buffer);
+
+    char *payload = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    mem_free(base64_buffer);
+
+    if (!payload) {
+        ESP_LOGE(TAG, "Falha ao criar JSON payload");
+        return ESP_ERR_NO_MEM;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_CLIP);
+
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, strlen(payload), 1, 0);
+    cJSON_free(payload);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Falha ao publicar frame %d/%d do clipe", info->index + 1, info->count);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void add_heap_json(cJSON* root, const char* name, const mem_heap_stats_t* heap) {
+    cJSON *obj = cJSON_AddObjectToObject(root, name);
+    if (!obj) return;
+    cJSON_AddNumberToObject(obj, "total", heap->total);
+    cJSON_AddNumberToObject(obj, "free", heap->free);
+    cJSON_AddNumberToObject(obj, "min_free", heap->minimum_free);
+    cJSON_AddNumberToObject(obj, "largest_block", heap->largest_free_block);
+}
+
+esp_err_t mqtt_send_memory_status(const mem_account_report_t* report, const plane_cache_stats_t* planes) {
+    if (!mqtt_client) {
+        ESP_LOGE(TAG, "Cliente MQTT não inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!report) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        ESP_LOGE(TAG, "Falha ao criar objeto JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
+    cJSON_AddNumberToObject(root, "timestamp", time_sync_timestamp());
+    cJSON_AddNumberToObject(root, "tracked_live", report->tracked_live);
+    cJSON_AddNumberToObject(root, "tracked_peak", report->tracked_peak);
+    add_heap_json(root, "internal", &report->internal);
+    add_heap_json(root, "psram", &report->psram);
+
+    // Um objeto por subsistema: {"live", "peak", "allocs", "frees", "failures"}
+    cJSON *tags = cJSON_AddObjectToObject(root, "subsystems");
+    for (int i = 0; tags && i < MEM_TAG_COUNT; i++) {
+        const mem_tag_stats_t *t = &report->tags[i];
+        cJSON *obj = cJSON_AddObjectToObject(tags, mem_account_tag_name((mem_tag_t)i));
+        if (!obj) continue;
+        cJSON_AddNumberToObject(obj, "live", t->live_bytes);
+        cJSON_AddNumberToObject(obj, "peak", t->peak_bytes);
+        cJSON_AddNumberToObject(obj, "allocs", t->allocs);
+        cJSON_AddNumberToObject(obj, "frees", t->frees);
+        cJSON_AddNumberToObject(obj, "failures", t->failures);
+    }
+
+    if (planes) {
+        cJSON *cache = cJSON_AddObjectToObject(root, "plane_cache");
+        if (cache) {
+            cJSON_AddNumberToObject(cache, "entries", planes->entries);
+            cJSON_AddNumberToObject(cache, "capacity", planes->capacity);
+            cJSON_AddNumberToObject(cache, "bytes", planes->bytes);
+            cJSON_AddNumberToObject(cache, "budget", planes->budget);
+            cJSON_AddNumberToObject(cache, "hits", planes->hits);
+            cJSON_AddNumberToObject(cache, "misses", planes->misses);
+            cJSON_AddNumberToObject(cache, "inserts", planes->inserts);
+            cJSON_AddNumberToObject(cache, "evictions", planes->evictions);
+        }
+    }
+
+    char *payload = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    if (!payload) {
+        ESP_LOGE(TAG, "Falha ao serializar JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_MEMORY);
+
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, strlen(payload), 1, 0);
+    cJSON_free(payload);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Falha ao publicar memória via MQTT");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mqtt_send_reference_bank(const reference_bank_stats_t* stats) {
+    if (!mqtt_client) {
+        ESP_LOGE(TAG, "Cliente MQTT não inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        ESP_LOGE(TAG, "Falha ao criar objeto JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
+    cJSON_AddNumberToObject(root, "timestamp", time_sync_timestamp());
+    cJSON_AddNumberToObject(root, "capacity", stats->capacity);
+    cJSON_AddNumberToObject(root, "count", stats->count);
+    cJSON_AddNumberToObject(root, "active", stats->active_index);
+    cJSON_AddNumberToObject(root, "created", stats->created);
+    cJSON_AddNumberToObject(root, "replaced", stats->replaced);
+    cJSON_AddNumberToObject(root, "memory", stats->memory_bytes);
+
+    // Um objeto por cluster ocupado: {"index", "members", "recent", "luma", "age_s", "idle_s"}
+    cJSON *clusters = cJSON_AddArrayToObject(root, "clusters");
+    for (int i = 0; clusters && i < stats->capacity; i++) {
+        const reference_cluster_info_t *c = &stats->clusters[i];
+        if (!c->valid) continue;
+        cJSON *obj = cJSON_CreateObject();
+        if (!obj) break;
+        cJSON_AddNumberToObject(obj, "index", i);
+        cJSON_AddNumberToObject(obj, "members", c->members);
+        cJSON_AddNumberToObject(obj, "recent", c->recent);
+        cJSON_AddNumberToObject(obj, "luma", c->mean_luma);
+        cJSON_AddNumberToObject(obj, "age_s", c->age_s);
+        cJSON_AddNumberToObject(obj, "idle_s", c->idle_s);
+        cJSON_AddItemToArray(clusters, obj);
+    }
+
+    char *payload = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    if (!payload) {
+        ESP_LOGE(TAG, "Falha ao serializar JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_SCENES);
+
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, strlen(payload), 1, 0);
+    cJSON_free(payload);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Falha ao publicar clusters de cena via MQTT");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mqtt_send_rollup(const rollup_bucket_t* bucket) {
+    if (!mqtt_client) {
+        ESP_LOGE(TAG, "Cliente MQTT não inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!bucket) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        ESP_LOGE(TAG, "Falha ao criar objeto JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
+    cJSON_AddStringToObject(root, "scale", telemetry_rollup_scale_name(bucket->scale));
+    cJSON_AddNumberToObject(root, "start", bucket->start);
+    cJSON_AddNumberToObject(root, "duration", telemetry_rollup_duration(bucket->scale));
+    cJSON_AddNumberToObject(root, "first", bucket->first);
+    cJSON_AddNumberToObject(root, "last", bucket->last);
+    cJSON_AddBoolToObject(root, "time_synced", time_sync_is_synced());
+
+    // Um objeto por grandeza com amostras: {"min", "max", "mean", "count"}
+    cJSON *metrics = cJSON_AddObjectToObject(root, "metrics");
+    for (int i = 0; metrics && i < ROLLUP_METRIC_COUNT; i++) {
+        const rollup_stat_t *m = &bucket->metrics[i];
+        if (m->count == 0) continue;
+        cJSON *obj = cJSON_AddObjectToObject(metrics, telemetry_rollup_metric_name((rollup_metric_t)i));
+        if (!obj) continue;
+        cJSON_AddNumberToObject(obj, "min", m->min);
+        cJSON_AddNumberToObject(obj, "max", m->max);
+        cJSON_AddNumberToObject(obj, "mean", telemetry_rollup_mean(m));
+        cJSON_AddNumberToObject(obj, "count", m->count);
+    }
+
+    char *payload = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    if (!payload) {
+        ESP_LOGE(TAG, "Falha ao serializar JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_ROLLUP,
+             telemetry_rollup_scale_name(bucket->scale));
+
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, strlen(payload), 1, 0);
+    cJSON_free(payload);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Falha ao publicar agregado %s via MQTT", telemetry_rollup_scale_name(bucket->scale));
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t mqtt_send_pipeline_status(const pipeline_queue_stats_t* queues, int count) {
+    if (!mqtt_client) {
+        ESP_LOGE(TAG, "Cliente MQTT não inicializado");
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!queues || count <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        ESP_LOGE(TAG, "Falha ao criar objeto JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    cJSON_AddStringToObject(root, "device_id", DEVICE_ID);
+    cJSON_AddNumberToObject(root, "timestamp", time_sync_timestamp());
+
+    // Um objeto por estágio consumidor: {"depth", "capacity", "peak", "pushed", "popped", "dropped"}
+    cJSON *stages = cJSON_AddObjectToObject(root, "stages");
+    for (int i = 0; stages && i < count; i++) {
+        const pipeline_queue_stats_t *q = &queues[i];
+        cJSON *obj = cJSON_AddObjectToObject(stages, q->name ? q->name : "unknown");
+        if (!obj) continue;
+        cJSON_AddNumberToObject(obj, "depth", q->depth);
+        cJSON_AddNumberToObject(obj, "capacity", q->capacity);
+        cJSON_AddNumberToObject(obj, "peak", q->peak_depth);
+        cJSON_AddNumberToObject(obj, "pushed", q->pushed);
+        cJSON_AddNumberToObject(obj, "popped", q->popped);
+        cJSON_AddNumberToObject(obj, "dropped", q->dropped);
+    }
+
+    char *payload = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+
+    if (!payload) {
+        ESP_LOGE(TAG, "Falha ao serializar JSON");
+        return ESP_ERR_NO_MEM;
+    }
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/%s", MQTT_TOPIC_BASE, MQTT_TOPIC_PIPELINE);
+
+    int msg_id = esp_mqtt_client_publish(mqtt_client, topic, payload, strlen(payload), 1, 0);
+    cJSON_free(payload);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Falha ao publicar status do pipeline via MQTT");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t mqtt_send_image_fallback(camera_fb_t *fb, const char* reason, const char* device_id) {
     if (!mqtt_client || !fb) {
         ESP_LOGE(TAG, "Parâmetros inválidos para envio de imagem");
@@ -277,7 +862,7 @@ esp_err_t mqtt_send_image_fallback(camera_fb_t *fb, const char* reason, const ch
     
     // Enviar metadados da imagem primeiro
     char metadata[300];
-    uint64_t timestamp = esp_timer_get_time() / 1000000LL;
+    uint64_t timestamp = time_sync_timestamp();
     
     int ret = snprintf(metadata, sizeof(metadata),
         "{"
@@ -6,6 +6,12 @@
  * - Envio de imagens em chunks
  * - Envio de dados de monitoramento
  * - Envio de alertas
+ * - Publicação da máscara de regiões ruidosas
+ * - Status de obstrução da lente
+ * - Telemetria de nível da água
+ * - Clusters de cena do banco de referências
+ * - Agregados de telemetria por minuto/hora/dia
+ * - Filas do pipeline captura/análise/publicação
  * 
  * @author Gabriel Passos - UNESP 2025
  */
@@ -14,12 +20,58 @@
 
 #include "esp_camera.h"
 #include "esp_err.h"
+#include "mem_account.h"
+#include "advanced_analysis.h"
+#include "telemetry_rollup.h"
+#include "plane_cache.h"
+#include "pipeline.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Metadados do frame anexados aos payloads (campos zerados são omitidos).
+ */
+typedef struct {
+    uint16_t gain_x16;      ///< Ganho do sensor na captura (16 = 1x, 0 = desconhecido)
+    uint16_t exposure;      ///< Exposição AEC em linhas
+    bool has_phash;         ///< phash válido
+    uint64_t phash;         ///< Hash perceptual do frame (enviado como 16 dígitos hex)
+    const char* light;      ///< Período de iluminação ("day", "twilight", "night"; NULL omite)
+    float light_ev;         ///< Índice de luz medido
+    const char* weather;    ///< Condição estimada ("clear", "overcast", "rain_fog", "night"; NULL omite)
+    float haze;             ///< Véu atmosférico (canal escuro / luminância, 0-1)
+    int64_t captured_us;    ///< Instante da captura (esp_timer; 0 = momento do envio)
+} mqtt_frame_info_t;
+
+/**
+ * @brief Quantis das diferenças anexados ao status (has_quantiles = false omite).
+ */
+typedef struct {
+    bool has_quantiles;     ///< Campos abaixo válidos
+    uint32_t samples;       ///< Capturas usadas nas estimativas
+    float median;           ///< Mediana das diferenças (%)
+    float p95;              ///< Percentil 95 (%)
+    float p99;              ///< Percentil 99 (%)
+    float mad;              ///< Desvio absoluto mediano (%)
+} mqtt_status_info_t;
+
+/**
+ * @brief Posição de um frame no clipe pré-alerta.
+ */
+typedef struct {
+    uint32_t alert_id;      ///< Alerta ao qual o clipe pertence
+    int index;              ///< Ordem no clipe (0 = mais antigo)
+    int count;              ///< Frames no clipe (capturas anteriores ao gatilho)
+    int32_t offset_ms;      ///< Tempo da captura relativo ao gatilho (< 0)
+    float difference;       ///< Diferença que disparou o alerta (%)
+    bool thumbnail;         ///< Miniatura em tons de cinza do histórico (frame completo já liberado)
+    int64_t captured_us;    ///< Instante da captura (esp_timer)
+} mqtt_clip_info_t;
+
 /**
  * @brief Envia uma imagem via MQTT.
  * A imagem é enviada em chunks para o tópico definido em `MQTT_TOPIC_IMAGE`.
@@ -41,6 +93,19 @@ esp_err_t mqtt_send_image(camera_fb_t* fb, const char* topic);
  */
 esp_err_t mqtt_send_image_with_info(camera_fb_t* fb, const char* topic, const char* reason, float difference);
 
+/**
+ * @brief Envia uma imagem via MQTT com informações adicionais e metadados do frame.
+ * 
+ * @param fb Ponteiro para o frame buffer da câmera.
+ * @param topic Tópico MQTT para publicar a imagem.
+ * @param reason Motivo do envio da imagem.
+ * @param difference Diferença detectada (para alertas).
+ * @param info Metadados do frame (pode ser NULL).
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_image_with_info_ext(camera_fb_t* fb, const char* topic, const char* reason,
+                                        float difference, const mqtt_frame_info_t* info);
+
 /**
  * @brief Envia dados de monitoramento (heap, psram, uptime).
  * 
@@ -51,6 +116,18 @@ esp_err_t mqtt_send_image_with_info(camera_fb_t* fb, const char* topic, const ch
  */
 esp_err_t mqtt_send_monitoring(uint32_t free_heap, uint32_t free_psram, uint32_t uptime);
 
+/**
+ * @brief Envia dados de monitoramento com os quantis das diferenças.
+ * 
+ * @param free_heap Heap livre.
+ * @param free_psram PSRAM livre.
+ * @param uptime Uptime em segundos.
+ * @param info Quantis das diferenças (pode ser NULL).
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_monitoring_ext(uint32_t free_heap, uint32_t free_psram, uint32_t uptime,
+                                   const mqtt_status_info_t* info);
+
 /**
  * @brief Envia um alerta de detecção de mudança.
  * 
@@ -60,6 +137,27 @@ esp_err_t mqtt_send_monitoring(uint32_t free_heap, uint32_t free_psram, uint32_t
  */
 esp_err_t mqtt_send_alert(float difference_percent, camera_fb_t* frame);
 
+/**
+ * @brief Envia um alerta identificado (o clipe pré-alerta usa o mesmo ID).
+ * 
+ * @param difference_percent Percentual de diferença detectado.
+ * @param frame Frame buffer da imagem que gerou o alerta (pode ser NULL).
+ * @param alert_id Identificador do alerta (0 = omitido).
+ * @param captured_us Instante da captura que gerou o alerta (0 = momento do envio).
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_alert_ext(float difference_percent, camera_fb_t* frame, uint32_t alert_id,
+                              int64_t captured_us);
+
+/**
+ * @brief Publica um frame do clipe pré-alerta.
+ * 
+ * @param fb Frame JPEG.
+ * @param info Posição do frame no clipe.
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_clip_frame(camera_fb_t* fb, const mqtt_clip_info_t* info);
+
 /**
  * @brief Envia dados detalhados de monitoramento de imagem.
  * 
@@ -75,6 +173,104 @@ esp_err_t mqtt_send_monitoring_data(float difference, uint32_t image_size,
                                    uint16_t width, uint16_t height, 
                                    uint8_t format, const char* device_id);
 
+/**
+ * @brief Envia dados detalhados de monitoramento com metadados do frame.
+ * 
+ * @param difference Diferença percentual entre imagens.
+ * @param image_size Tamanho da imagem em bytes.
+ * @param width Largura da imagem.
+ * @param height Altura da imagem.
+ * @param format Formato da imagem.
+ * @param device_id ID do dispositivo.
+ * @param info Metadados do frame (pode ser NULL).
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_monitoring_data_ext(float difference, uint32_t image_size,
+                                       uint16_t width, uint16_t height,
+                                       uint8_t format, const char* device_id,
+                                       const mqtt_frame_info_t* info);
+
+/**
+ * @brief Publica a máscara aprendida de regiões ruidosas (mensagem retida).
+ * 
+ * @param rate_percent Taxa de mudança por bloco (0-100).
+ * @param masked 1 para blocos mascarados.
+ * @param blocks_x Blocos por linha da grade.
+ * @param blocks_y Linhas de blocos da grade.
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_nuisance_mask(const uint8_t* rate_percent, const uint8_t* masked,
+                                  int blocks_x, int blocks_y);
+
+/**
+ * @brief Publica o status de obstrução da lente (mensagem retida).
+ * 
+ * @param obstructed true para "lens_obstructed", false para "lens_clear".
+ * @param occluded_blocks Blocos sem nitidez.
+ * @param evaluated_blocks Blocos avaliados.
+ * @param occluded_percent Percentual de blocos avaliados obstruídos.
+ * @param occluded Mapa de blocos obstruídos (pode ser NULL).
+ * @param blocks_x Blocos por linha da grade.
+ * @param blocks_y Linhas de blocos da grade.
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_lens_status(bool obstructed, int occluded_blocks, int evaluated_blocks,
+                                float occluded_percent, const uint8_t* occluded,
+                                int blocks_x, int blocks_y);
+
+/**
+ * @brief Publica a telemetria de nível da água (payload mínimo).
+ * 
+ * @param level_percent Nível suavizado (% da coluna de medição).
+ * @param confidence Confiança da medição (0.0 a 1.0).
+ * @param rate_per_hour Taxa de variação (%/h).
+ * @param captured_us Instante da captura medida (0 = momento do envio).
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_water_level(float level_percent, float confidence, float rate_per_hour,
+                                int64_t captured_us);
+
+/**
+ * @brief Publica a memória por subsistema e o estado dos heaps.
+ * 
+ * @param report Relatório de mem_account_snapshot().
+ * @param planes Estatísticas do cache de planos (NULL omite).
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_memory_status(const mem_account_report_t* report, const plane_cache_stats_t* planes);
+
+/**
+ * @brief Publica os clusters de cena do banco de referências.
+ * 
+ * @param stats Estado de get_reference_bank_stats().
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_reference_bank(const reference_bank_stats_t* stats);
+
+/**
+ * @brief Publica uma janela de agregados fechada (tópico rollup/<escala>).
+ * 
+ * @param bucket Janela entregue por telemetry_rollup_add().
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_rollup(const rollup_bucket_t* bucket);
+
+/**
+ * @brief Publica profundidade e descartes das filas entre estágios.
+ * 
+ * @param queues Estatísticas de cada fila, na ordem do pipeline.
+ * @param count Número de filas.
+ * @return esp_err_t 
+ */
+esp_err_t mqtt_send_pipeline_status(const pipeline_queue_stats_t* queues, int count);
+
+/**
+ * @brief Direciona as alocações do cJSON para a contabilidade de memória.
+ * 
+ * Deve ser chamada antes do primeiro envio.
+ */
+void mqtt_send_track_json_memory(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,23 @@
+/**
+ * @file noise_gain_table.h
+ * @brief Escala do ruído do sensor em função do ganho analógico
+ *
+ * Gerado por tools/analysis/calibrate_noise_gain.py a partir de frames
+ * arquivados - não editar manualmente. Valores conservadores até a
+ * primeira calibração do dispositivo.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef NOISE_GAIN_TABLE_H
+#define NOISE_GAIN_TABLE_H
+
+#include <stdint.h>
+
+#define NOISE_GAIN_TABLE_SIZE 6   // Uma entrada por oitava de ganho: 1x, 2x, 4x, 8x, 16x, 32x
+
+// Multiplicador (Q8, 256 = 1.0) do piso de ruído e dos limiares por bloco
+static const uint16_t noise_gain_scale_q8[NOISE_GAIN_TABLE_SIZE] = {
+    256, 256, 288, 352, 448, 576
+};
+
+#endif // NOISE_GAIN_TABLE_H
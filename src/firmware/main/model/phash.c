@@ -0,0 +1,149 @@
+/**
+ * @file phash.c
+ * @brief Implementação do hash perceptual por DCT
+ *
+ * Apenas os 8x8 coeficientes de baixa frequência são calculados: a DCT
+ * separável faz 8 coeficientes por linha da miniatura e depois 8 por
+ * coluna, cerca de 10 mil multiplicações por frame.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#include "phash.h"
+#include "config.h"
+#include "esp_log.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "PHASH";
+
+#define PHASH_THUMB_SIZE 32
+#define PHASH_LOW_FREQ   8
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Tabela de cossenos da DCT-II: cos(pi * k * (2n + 1) / 2N)
+static float dct_cos[PHASH_LOW_FREQ][PHASH_THUMB_SIZE];
+static bool dct_ready = false;
+
+// Buffers de trabalho estáticos (~5 KB fora da pilha da tarefa de monitoramento)
+static float thumb[PHASH_THUMB_SIZE][PHASH_THUMB_SIZE];
+static float rows_dct[PHASH_THUMB_SIZE][PHASH_LOW_FREQ];
+
+// Hashes das últimas imagens enviadas (buffer circular)
+static uint64_t recent_hashes[PHASH_RECENT_COUNT];
+static int recent_count = 0;
+static int recent_next = 0;
+
+static void init_dct_table(void) {
+    for (int k = 0; k < PHASH_LOW_FREQ; k++) {
+        for (int n = 0; n < PHASH_THUMB_SIZE; n++) {
+            dct_cos[k][n] = cosf((float)M_PI * k * (2 * n + 1) / (2.0f * PHASH_THUMB_SIZE));
+        }
+    }
+    dct_ready = true;
+}
+
+static int compare_floats(const void* a, const void* b) {
+    float fa = *(const float*)a, fb = *(const float*)b;
+    return (fa > fb) - (fa < fb);
+}
+
+esp_err_t phash_compute(const luma_plane_t* plane, uint64_t* hash) {
+    if (!plane || !plane->pixels || !hash ||
+        plane->width < PHASH_THUMB_SIZE || plane->height < PHASH_THUMB_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!dct_ready) {
+        init_dct_table();
+    }
+
+    // Miniatura 32x32 por média de área (o plano não é quadrado)
+    for (int ty = 0; ty < PHASH_THUMB_SIZE; ty++) {
+        int y0 = ty * plane->height / PHASH_THUMB_SIZE;
+        int y1 = (ty + 1) * plane->height / PHASH_THUMB_SIZE;
+        for (int tx = 0; tx < PHASH_THUMB_SIZE; tx++) {
+            int x0 = tx * plane->width / PHASH_THUMB_SIZE;
+            int x1 = (tx + 1) * plane->width / PHASH_THUMB_SIZE;
+            uint32_t sum = 0;
+            for (int y = y0; y < y1; y++) {
+                const uint8_t *row = plane->pixels + (size_t)y * plane->width;
+                for (int x = x0; x < x1; x++) {
+                    sum += row[x];
+                }
+            }
+            thumb[ty][tx] = (float)sum / (float)((y1 - y0) * (x1 - x0));
+        }
+    }
+
+    // DCT nas linhas: 8 coeficientes horizontais por linha
+    for (int y = 0; y < PHASH_THUMB_SIZE; y++) {
+        for (int u = 0; u < PHASH_LOW_FREQ; u++) {
+            float acc = 0.0f;
+            for (int x = 0; x < PHASH_THUMB_SIZE; x++) {
+                acc += thumb[y][x] * dct_cos[u][x];
+            }
+            rows_dct[y][u] = acc;
+        }
+    }
+
+    // DCT nas colunas: bloco 8x8 de baixa frequência (linha = frequência vertical)
+    float coeffs[PHASH_LOW_FREQ * PHASH_LOW_FREQ];
+    for (int v = 0; v < PHASH_LOW_FREQ; v++) {
+        for (int u = 0; u < PHASH_LOW_FREQ; u++) {
+            float acc = 0.0f;
+            for (int y = 0; y < PHASH_THUMB_SIZE; y++) {
+                acc += rows_dct[y][u] * dct_cos[v][y];
+            }
+            coeffs[v * PHASH_LOW_FREQ + u] = acc;
+        }
+    }
+
+    // Mediana dos 64 coeficientes (mesma regra de imagehash.phash)
+    float sorted[PHASH_LOW_FREQ * PHASH_LOW_FREQ];
+    memcpy(sorted, coeffs, sizeof(sorted));
+    qsort(sorted, PHASH_LOW_FREQ * PHASH_LOW_FREQ, sizeof(float), compare_floats);
+    float median = (sorted[31] + sorted[32]) * 0.5f;
+
+    // Primeiro coeficiente no bit mais significativo
+    uint64_t bits = 0;
+    for (int i = 0; i < PHASH_LOW_FREQ * PHASH_LOW_FREQ; i++) {
+        if (coeffs[i] > median) {
+            bits |= 1ULL << (63 - i);
+        }
+    }
+
+    *hash = bits;
+    return ESP_OK;
+}
+
+int phash_distance(uint64_t a, uint64_t b) {
+    return __builtin_popcountll(a ^ b);
+}
+
+bool phash_recently_sent(uint64_t hash, int max_distance, int* distance) {
+    int best = -1;
+    for (int i = 0; i < recent_count; i++) {
+        int d = phash_distance(hash, recent_hashes[i]);
+        if (best < 0 || d < best) {
+            best = d;
+        }
+    }
+
+    if (distance) {
+        *distance = best;
+    }
+    return best >= 0 && best <= max_distance;
+}
+
+void phash_remember_sent(uint64_t hash) {
+    recent_hashes[recent_next] = hash;
+    recent_next = (recent_next + 1) % PHASH_RECENT_COUNT;
+    if (recent_count < PHASH_RECENT_COUNT) {
+        recent_count++;
+    }
+    ESP_LOGD(TAG, "Hash %016llx registrado (%d recentes)", (unsigned long long)hash, recent_count);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file phash.h
+ * @brief Hash perceptual (pHash DCT) de 64 bits por frame
+ *
+ * Este módulo fornece funções para:
+ * - Miniatura 32x32 a partir do plano de luminância da comparação
+ * - DCT das baixas frequências (8x8) e hash de 64 bits pela mediana
+ * - Distância de Hamming e memória dos hashes enviados recentemente
+ *
+ * A ordem dos bits segue a convenção de imagehash.phash (Python), para
+ * que o servidor possa comparar os hashes diretamente.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef PHASH_H
+#define PHASH_H
+
+#include "esp_err.h"
+#include "compare.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Calcula o pHash de 64 bits de um plano já decodificado
+ *
+ * @param plane Plano de luminância do frame
+ * @param hash Saída: hash perceptual
+ * @return esp_err_t ESP_OK se bem-sucedido
+ */
+esp_err_t phash_compute(const luma_plane_t* plane, uint64_t* hash);
+
+/**
+ * @brief Distância de Hamming entre dois hashes (0 = idênticos, 64 = opostos)
+ *
+ * @param a Primeiro hash
+ * @param b Segundo hash
+ * @return int Número de bits diferentes
+ */
+int phash_distance(uint64_t a, uint64_t b);
+
+/**
+ * @brief Verifica se o hash coincide com algum enviado recentemente
+ *
+ * @param hash Hash do frame atual
+ * @param max_distance Distância máxima para considerar duplicata
+ * @param distance Saída opcional: menor distância encontrada (-1 se não há histórico)
+ * @return true se existe hash recente a até max_distance bits
+ */
+bool phash_recently_sent(uint64_t hash, int max_distance, int* distance);
+
+/**
+ * @brief Registra o hash de um frame enviado
+ *
+ * @param hash Hash do frame enviado
+ */
+void phash_remember_sent(uint64_t hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PHASH_H
@@ -0,0 +1,166 @@
+/**
+ * @file pipeline.c
+ * @brief Implementação das filas entre estágios
+ *
+ * Com DROP_OLDEST o produtor retira o item da frente e tenta de novo. Se o
+ * consumidor esvaziar a fila nesse meio tempo, o envio seguinte apenas
+ * encontra espaço; o item retirado já foi contado e liberado.
+ *
+ * No envio urgente o produtor retira da frente até achar um item não
+ * urgente, descarta-o e devolve os urgentes à frente na ordem original.
+ * Se o consumidor retirar um item nesse meio tempo, esse item sai antes
+ * dos urgentes devolvidos (reordenação de um item, sem perda).
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "pipeline.h"
+#include "mem_account.h"
+#include "esp_log.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "PIPELINE";
+
+esp_err_t pipeline_queue_init(pipeline_queue_t* q, const char* name, int capacity, size_t item_size,
+                              pipeline_drop_policy_t policy, pipeline_drop_fn on_drop,
+                              pipeline_urgent_fn is_urgent) {
+    if (!q || capacity <= 0 || item_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(q, 0, sizeof(pipeline_queue_t));
+    q->evicted = mem_alloc(MEM_TAG_MAIN, (size_t)capacity * item_size, MALLOC_CAP_8BIT);
+    q->queue = xQueueCreate(capacity, item_size);
+    if (!q->queue || !q->evicted) {
+        ESP_LOGE(TAG, "Falha ao criar fila %s (%d itens de %zu bytes)", name, capacity, item_size);
+        if (q->queue) {
+            vQueueDelete(q->queue);
+        }
+        mem_free(q->evicted);
+        memset(q, 0, sizeof(pipeline_queue_t));
+        return ESP_ERR_NO_MEM;
+    }
+
+    q->name = name;
+    q->capacity = capacity;
+    q->item_size = item_size;
+    q->policy = policy;
+    q->on_drop = on_drop;
+    q->is_urgent = is_urgent;
+    ESP_LOGI(TAG, "✅ Fila %s: %d itens, cheia descarta o %s", name, capacity,
+             policy == PIPELINE_DROP_OLDEST ? "mais antigo" : "novo");
+    return ESP_OK;
+}
+
+static void note_depth(pipeline_queue_t* q) {
+    int depth = (int)uxQueueMessagesWaiting(q->queue);
+    int peak = atomic_load(&q->peak_depth);
+    while (depth > peak && !atomic_compare_exchange_weak(&q->peak_depth, &peak, depth)) {
+    }
+}
+
+static void drop_item(pipeline_queue_t* q, void* item) {
+    if (q->on_drop) {
+        q->on_drop(item);
+    }
+    uint32_t dropped = (uint32_t)atomic_fetch_add(&q->dropped, 1) + 1;
+    ESP_LOGW(TAG, "⚠️ Fila %s cheia: item descartado (%" PRIu32 " no total)", q->name, dropped);
+}
+
+// Descarta o item mais antigo; com skip_urgent, o mais antigo não urgente (false se todos forem)
+static bool evict_oldest(pipeline_queue_t* q, bool skip_urgent) {
+    uint8_t* held = (uint8_t*)q->evicted;
+    int count = 0;
+    bool evicted = false;
+
+    while (count < q->capacity && xQueueReceive(q->queue, held + (size_t)count * q->item_size, 0) == pdTRUE) {
+        void* oldest = held + (size_t)count * q->item_size;
+        if (!skip_urgent || !q->is_urgent || !q->is_urgent(oldest)) {
+            drop_item(q, oldest);
+            evicted = true;
+            break;
+        }
+        count++;
+    }
+
+    // Urgentes retirados voltam à frente, do mais novo para o mais antigo (só o produtor enfileira)
+    for (int i = count - 1; i >= 0; i--) {
+        xQueueSendToFront(q->queue, held + (size_t)i * q->item_size, 0);
+    }
+    return evicted || count == 0;
+}
+
+static esp_err_t enqueued(pipeline_queue_t* q) {
+    atomic_fetch_add(&q->pushed, 1);
+    note_depth(q);
+    return ESP_OK;
+}
+
+esp_err_t pipeline_queue_push(pipeline_queue_t* q, void* item) {
+    if (!q || !q->queue || !item) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (xQueueSend(q->queue, item, 0) == pdTRUE) {
+        return enqueued(q);
+    }
+    if (q->policy == PIPELINE_DROP_OLDEST) {
+        evict_oldest(q, false);
+        if (xQueueSend(q->queue, item, 0) == pdTRUE) {
+            return enqueued(q);
+        }
+    }
+
+    // Só o produtor enfileira: com DROP_OLDEST a vaga aberta acima não pode ser tomada
+    drop_item(q, item);
+    return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t pipeline_queue_push_urgent(pipeline_queue_t* q, void* item, TickType_t wait) {
+    if (!q || !q->queue || !item) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (xQueueSend(q->queue, item, 0) == pdTRUE) {
+        return enqueued(q);
+    }
+
+    // Só urgentes na fila: esperar o consumidor; esgotado o prazo, o urgente mais antigo cede a vaga
+    if (!evict_oldest(q, true)) {
+        if (xQueueSend(q->queue, item, wait) == pdTRUE) {
+            return enqueued(q);
+        }
+        ESP_LOGW(TAG, "⚠️ Fila %s só com itens urgentes: descartando o mais antigo", q->name);
+        evict_oldest(q, false);
+    }
+
+    if (xQueueSend(q->queue, item, 0) == pdTRUE) {
+        return enqueued(q);
+    }
+    drop_item(q, item);
+    return ESP_ERR_TIMEOUT;
+}
+
+bool pipeline_queue_pop(pipeline_queue_t* q, void* item, TickType_t wait) {
+    if (!q || !q->queue || !item) {
+        return false;
+    }
+    if (xQueueReceive(q->queue, item, wait) != pdTRUE) {
+        return false;
+    }
+    atomic_fetch_add(&q->popped, 1);
+    return true;
+}
+
+void pipeline_queue_get_stats(pipeline_queue_t* q, pipeline_queue_stats_t* stats) {
+    if (!q || !stats) return;
+
+    stats->name = q->name;
+    stats->depth = q->queue ? (int)uxQueueMessagesWaiting(q->queue) : 0;
+    stats->capacity = q->capacity;
+    stats->peak_depth = atomic_load(&q->peak_depth);
+    stats->pushed = atomic_load(&q->pushed);
+    stats->popped = atomic_load(&q->popped);
+    stats->dropped = atomic_load(&q->dropped);
+}
@@ -0,0 +1,135 @@
+/**
+ * @file pipeline.h
+ * @brief Filas limitadas entre os estágios captura -> análise -> publicação
+ *
+ * Este módulo fornece funções para:
+ * - Filas FreeRTOS de tamanho fixo com política explícita quando cheias
+ *   (descartar o item mais antigo ou o novo)
+ * - Devolução dos recursos do item descartado (handles do pool, buffers do
+ *   driver) por callback, sem vazamento
+ * - Envio urgente que não descarta outros itens urgentes (alertas)
+ * - Contadores por fila: profundidade atual e máxima, entradas, saídas e descartes
+ *
+ * Usa apenas a API de filas do FreeRTOS (roda também no port POSIX do
+ * FreeRTOS, em Linux). Cada fila tem um único produtor e um único consumidor.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief O que fazer quando o estágio seguinte está atrasado (fila cheia)
+ */
+typedef enum {
+    PIPELINE_DROP_OLDEST = 0,   ///< Descartar o item mais antigo da fila (dados mais novos valem mais)
+    PIPELINE_DROP_NEWEST,       ///< Descartar o item novo (fila preserva a ordem já aceita)
+} pipeline_drop_policy_t;
+
+/**
+ * @brief Libera os recursos de um item descartado
+ */
+typedef void (*pipeline_drop_fn)(void* item);
+
+/**
+ * @brief Indica se um item já na fila é urgente (não pode ser descartado por outro urgente)
+ */
+typedef bool (*pipeline_urgent_fn)(const void* item);
+
+/**
+ * @brief Fila entre dois estágios
+ */
+typedef struct {
+    const char* name;
+    QueueHandle_t queue;
+    int capacity;
+    size_t item_size;
+    pipeline_drop_policy_t policy;
+    pipeline_drop_fn on_drop;
+    pipeline_urgent_fn is_urgent;
+    void* evicted;              ///< Itens retirados ao procurar o descarte (lado do produtor, capacity itens)
+    atomic_uint pushed;
+    atomic_uint popped;
+    atomic_uint dropped;
+    atomic_int peak_depth;
+} pipeline_queue_t;
+
+/**
+ * @brief Estatísticas de uma fila
+ */
+typedef struct {
+    const char* name;           ///< Nome do estágio consumidor
+    int depth;                  ///< Itens aguardando
+    int capacity;               ///< Itens que cabem na fila
+    int peak_depth;             ///< Maior profundidade observada
+    uint32_t pushed;            ///< Itens aceitos
+    uint32_t popped;            ///< Itens entregues ao consumidor
+    uint32_t dropped;           ///< Itens descartados pela política
+} pipeline_queue_stats_t;
+
+/**
+ * Cria a fila
+ * @param q Fila a inicializar
+ * @param name Nome do estágio consumidor (logs e relatório)
+ * @param capacity Itens na fila
+ * @param item_size Tamanho de cada item (copiado para a fila)
+ * @param policy Política quando cheia
+ * @param on_drop Liberação do item descartado (NULL = nada a liberar)
+ * @param is_urgent Itens protegidos no envio urgente (NULL = nenhum)
+ * @return ESP_OK se bem-sucedido, ESP_ERR_NO_MEM sem memória
+ */
+esp_err_t pipeline_queue_init(pipeline_queue_t* q, const char* name, int capacity, size_t item_size,
+                              pipeline_drop_policy_t policy, pipeline_drop_fn on_drop,
+                              pipeline_urgent_fn is_urgent);
+
+/**
+ * Enfileira um item sem bloquear, aplicando a política da fila
+ * @param q Fila
+ * @param item Item a copiar (com DROP_NEWEST e fila cheia, on_drop é chamado sobre ele)
+ * @return ESP_OK se enfileirado, ESP_ERR_TIMEOUT se o item novo foi descartado
+ */
+esp_err_t pipeline_queue_push(pipeline_queue_t* q, void* item);
+
+/**
+ * Enfileira um item que não pode ser perdido (ex.: alerta), qualquer que
+ * seja a política: com a fila cheia, descarta o item não urgente mais
+ * antigo. Se todos forem urgentes, espera vaga até wait e, esgotado o
+ * prazo, descarta o urgente mais antigo
+ * @param q Fila
+ * @param item Item a copiar
+ * @param wait Ticks de espera quando só há itens urgentes na fila
+ * @return ESP_OK se enfileirado
+ */
+esp_err_t pipeline_queue_push_urgent(pipeline_queue_t* q, void* item, TickType_t wait);
+
+/**
+ * Retira o próximo item
+ * @param q Fila
+ * @param item Destino (item_size bytes)
+ * @param wait Ticks de espera (portMAX_DELAY = indefinido)
+ * @return true se um item foi retirado
+ */
+bool pipeline_queue_pop(pipeline_queue_t* q, void* item, TickType_t wait);
+
+/**
+ * Obtém as estatísticas da fila
+ */
+void pipeline_queue_get_stats(pipeline_queue_t* q, pipeline_queue_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIPELINE_H
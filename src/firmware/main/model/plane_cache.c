@@ -0,0 +1,164 @@
+/**
+ * @file plane_cache.c
+ * @brief Implementação do cache LRU de planos
+ *
+ * Todos os planos têm o tamanho da escala de comparação, então o orçamento
+ * vira um número fixo de entradas. Ao despejar, a entrada mais antiga é
+ * reutilizada com o mesmo buffer (sem nova alocação em regime). Os
+ * identificadores dos handles nunca se repetem, então planos de frames já
+ * devolvidos ao pool nunca são acertados e saem primeiro pelo LRU.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "plane_cache.h"
+#include "config.h"
+#include "esp_log.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "PLANE_CACHE";
+
+typedef struct {
+    uint32_t frame_id;          // 0 = entrada livre
+    uint32_t last_used;         // Relógio lógico de acesso (LRU)
+    luma_plane_t plane;
+} cache_entry_t;
+
+static cache_entry_t entries[PLANE_CACHE_MAX_ENTRIES];
+static int capacity = 0;
+static uint32_t tick = 0;
+static plane_cache_stats_t counters = {0};
+
+esp_err_t plane_cache_init(void) {
+    size_t plane_bytes = (size_t)COMPARE_PLANE_WIDTH * COMPARE_PLANE_HEIGHT;
+    size_t fit = (size_t)PLANE_CACHE_BUDGET_KB * 1024 / plane_bytes;
+    capacity = fit < PLANE_CACHE_MAX_ENTRIES ? (int)fit : PLANE_CACHE_MAX_ENTRIES;
+
+    // Diferenciação de três frames precisa dos três planos ao mesmo tempo
+    if (capacity < 3) {
+        ESP_LOGE(TAG, "Orçamento de %d KB comporta só %d planos (mínimo 3)", PLANE_CACHE_BUDGET_KB, capacity);
+        capacity = 0;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGI(TAG, "✅ Cache de planos: %d x %" PRIu32 " KB (orçamento %d KB)",
+             capacity, (uint32_t)(plane_bytes / 1024), PLANE_CACHE_BUDGET_KB);
+    return ESP_OK;
+}
+
+static cache_entry_t* find(uint32_t frame_id) {
+    if (frame_id == 0) return NULL;
+    for (int i = 0; i < capacity; i++) {
+        if (entries[i].frame_id == frame_id) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Entrada livre, ou a usada há mais tempo (seu buffer é reaproveitado)
+ */
+static cache_entry_t* claim(uint32_t frame_id) {
+    cache_entry_t *victim = NULL;
+    for (int i = 0; i < capacity; i++) {
+        if (entries[i].frame_id == 0) {
+            victim = &entries[i];
+            break;
+        }
+        if (!victim || entries[i].last_used < victim->last_used) {
+            victim = &entries[i];
+        }
+    }
+    if (victim && victim->frame_id != 0) {
+        counters.evictions++;
+        ESP_LOGD(TAG, "Plano do frame %" PRIu32 " despejado", victim->frame_id);
+    }
+    if (victim) {
+        victim->frame_id = frame_id;
+        victim->last_used = ++tick;
+    }
+    return victim;
+}
+
+static void drop(cache_entry_t* entry) {
+    entry->frame_id = 0;
+    compare_free_luma(&entry->plane);
+}
+
+esp_err_t plane_cache_put(const frame_handle_t* frame, const luma_plane_t* plane) {
+    if (!frame || frame->id == 0 || !plane || !plane->pixels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cache_entry_t *entry = find(frame->id);
+    if (entry) {
+        // Mesmo frame: conteúdo idêntico, só renovar o acesso
+        entry->last_used = ++tick;
+        return ESP_OK;
+    }
+
+    entry = claim(frame->id);
+    if (!entry) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = compare_copy_luma(plane, &entry->plane);
+    if (err != ESP_OK) {
+        drop(entry);
+        return err;
+    }
+    counters.inserts++;
+    return ESP_OK;
+}
+
+luma_plane_t* plane_cache_get(frame_handle_t* frame) {
+    if (!frame || frame->id == 0 || capacity == 0) {
+        return NULL;
+    }
+
+    cache_entry_t *entry = find(frame->id);
+    if (entry) {
+        entry->last_used = ++tick;
+        counters.hits++;
+        return &entry->plane;
+    }
+
+    counters.misses++;
+    entry = claim(frame->id);
+    if (!entry) {
+        return NULL;
+    }
+    if (compare_decode_luma_only(frame_handle_fb(frame), &entry->plane) != ESP_OK) {
+        counters.decode_failures++;
+        drop(entry);
+        return NULL;
+    }
+    return &entry->plane;
+}
+
+bool plane_cache_contains(const frame_handle_t* frame) {
+    return frame && find(frame->id) != NULL;
+}
+
+void plane_cache_get_stats(plane_cache_stats_t* stats) {
+    if (!stats) return;
+
+    *stats = counters;
+    stats->capacity = capacity;
+    stats->budget = (size_t)PLANE_CACHE_BUDGET_KB * 1024;
+    stats->entries = 0;
+    stats->bytes = 0;
+    for (int i = 0; i < capacity; i++) {
+        if (entries[i].frame_id != 0) {
+            stats->entries++;
+            stats->bytes += (size_t)entries[i].plane.width * entries[i].plane.height;
+        }
+    }
+}
+
+void plane_cache_clear(void) {
+    for (int i = 0; i < PLANE_CACHE_MAX_ENTRIES; i++) {
+        drop(&entries[i]);
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file plane_cache.h
+ * @brief Cache LRU de planos de luminância decodificados, por frame
+ *
+ * Este módulo fornece funções para:
+ * - Guardar o plano reduzido de cada frame do pool uma única vez, indexado
+ *   pelo identificador do handle (histórico, banco de referências e demais
+ *   consumidores compartilham a mesma cópia)
+ * - Decodificar sob demanda frames que não estão no cache
+ * - Despejo do plano usado há mais tempo dentro de PLANE_CACHE_BUDGET_KB
+ * - Contadores de acertos, faltas e despejos
+ *
+ * Os ponteiros retornados valem até a próxima inserção ou falta (que pode
+ * reutilizar o buffer do plano mais antigo). Faltas decodificam por
+ * compare_decode_luma_only(): a cor da captura em análise continua
+ * disponível. Usado apenas pelo estágio de análise do pipeline.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef PLANE_CACHE_H
+#define PLANE_CACHE_H
+
+#include "esp_err.h"
+#include "compare.h"
+#include "frame_handle.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Estatísticas do cache
+ */
+typedef struct {
+    int entries;                ///< Planos em cache
+    int capacity;               ///< Planos que cabem no orçamento
+    size_t bytes;               ///< Bytes de pixels em cache
+    size_t budget;              ///< Orçamento em bytes
+    uint32_t hits;              ///< Consultas atendidas sem decodificar
+    uint32_t misses;            ///< Consultas que decodificaram o JPEG
+    uint32_t inserts;           ///< Planos já decodificados inseridos pelo chamador
+    uint32_t evictions;         ///< Planos descartados para abrir espaço
+    uint32_t decode_failures;   ///< Faltas cuja decodificação falhou
+} plane_cache_stats_t;
+
+/**
+ * Define a capacidade a partir do orçamento e do tamanho do plano reduzido
+ * @return ESP_OK se bem-sucedido, ESP_ERR_INVALID_SIZE se o orçamento não comporta 3 planos
+ */
+esp_err_t plane_cache_init(void);
+
+/**
+ * Guarda uma cópia do plano de um frame recém-decodificado
+ * @param frame Handle do frame (a chave é frame->id)
+ * @param plane Plano decodificado do mesmo frame
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t plane_cache_put(const frame_handle_t* frame, const luma_plane_t* plane);
+
+/**
+ * Plano de um frame: do cache ou decodificado agora (e guardado)
+ * @param frame Handle do frame
+ * @return Plano em cache, ou NULL se a decodificação falhar
+ */
+luma_plane_t* plane_cache_get(frame_handle_t* frame);
+
+/**
+ * Indica se o plano do frame está em cache (não conta acerto nem falta)
+ */
+bool plane_cache_contains(const frame_handle_t* frame);
+
+/**
+ * Obtém as estatísticas do cache
+ */
+void plane_cache_get_stats(plane_cache_stats_t* stats);
+
+/**
+ * Libera todos os planos
+ */
+void plane_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLANE_CACHE_H
@@ -0,0 +1,179 @@
+/**
+ * @file robust_stats.c
+ * @brief Implementação dos estimadores P² das diferenças
+ *
+ * O MAD é estimado por um quinto P² sobre |x - mediana|, com a mediana
+ * estimada no momento de cada amostra; depois do aquecimento a mediana
+ * quase não se move e o viés é desprezível frente ao ruído da cena.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "robust_stats.h"
+#include "config.h"
+#include <math.h>
+#include <string.h>
+
+static p2_quantile_t est_median;
+static p2_quantile_t est_p95;
+static p2_quantile_t est_p99;
+static p2_quantile_t est_mad;
+static bool initialized = false;
+
+void p2_quantile_init(p2_quantile_t* est, float p) {
+    memset(est, 0, sizeof(p2_quantile_t));
+    est->p = p;
+    est->dn[0] = 0.0f;
+    est->dn[1] = p / 2.0f;
+    est->dn[2] = p;
+    est->dn[3] = (1.0f + p) / 2.0f;
+    est->dn[4] = 1.0f;
+}
+
+static void sort5(float* v, int n) {
+    for (int i = 1; i < n; i++) {
+        float key = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > key) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = key;
+    }
+}
+
+/**
+ * Previsão parabólica (P²) da nova altura do marcador i
+ */
+static float parabolic(const p2_quantile_t* e, int i, float s) {
+    return e->q[i] + s / (e->n[i + 1] - e->n[i - 1]) *
+           ((e->n[i] - e->n[i - 1] + s) * (e->q[i + 1] - e->q[i]) / (e->n[i + 1] - e->n[i]) +
+            (e->n[i + 1] - e->n[i] - s) * (e->q[i] - e->q[i - 1]) / (e->n[i] - e->n[i - 1]));
+}
+
+void p2_quantile_add(p2_quantile_t* est, float x) {
+    // Primeiras 5 amostras: apenas armazenar; na quinta os marcadores nascem ordenados
+    if (est->count < 5) {
+        est->q[est->count++] = x;
+        if (est->count == 5) {
+            sort5(est->q, 5);
+            for (int i = 0; i < 5; i++) {
+                est->n[i] = (float)i;
+            }
+            est->np[0] = 0.0f;
+            est->np[1] = 2.0f * est->p;
+            est->np[2] = 4.0f * est->p;
+            est->np[3] = 2.0f + 2.0f * est->p;
+            est->np[4] = 4.0f;
+        }
+        return;
+    }
+
+    // Célula da amostra (estendendo os extremos se necessário)
+    int k;
+    if (x < est->q[0]) {
+        est->q[0] = x;
+        k = 0;
+    } else if (x >= est->q[4]) {
+        est->q[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (k < 3 && x >= est->q[k + 1]) {
+            k++;
+        }
+    }
+
+    for (int i = k + 1; i < 5; i++) {
+        est->n[i] += 1.0f;
+    }
+    for (int i = 0; i < 5; i++) {
+        est->np[i] += est->dn[i];
+    }
+
+    // Ajustar os marcadores centrais que se afastaram da posição desejada
+    for (int i = 1; i <= 3; i++) {
+        float d = est->np[i] - est->n[i];
+        if ((d >= 1.0f && est->n[i + 1] - est->n[i] > 1.0f) ||
+            (d <= -1.0f && est->n[i - 1] - est->n[i] < -1.0f)) {
+            float s = d >= 0.0f ? 1.0f : -1.0f;
+            float q = parabolic(est, i, s);
+            if (est->q[i - 1] < q && q < est->q[i + 1]) {
+                est->q[i] = q;
+            } else {
+                // Parábola fora da ordem: interpolação linear com o vizinho
+                int j = i + (int)s;
+                est->q[i] += s * (est->q[j] - est->q[i]) / (est->n[j] - est->n[i]);
+            }
+            est->n[i] += s;
+        }
+    }
+    est->count++;
+}
+
+float p2_quantile_value(const p2_quantile_t* est) {
+    if (est->count == 0) {
+        return 0.0f;
+    }
+    if (est->count >= 5) {
+        return est->q[2];
+    }
+
+    float v[5];
+    memcpy(v, est->q, est->count * sizeof(float));
+    sort5(v, (int)est->count);
+    return v[(int)lroundf(est->p * (est->count - 1))];
+}
+
+void robust_stats_reset(void) {
+    p2_quantile_init(&est_median, 0.50f);
+    p2_quantile_init(&est_p95, 0.95f);
+    p2_quantile_init(&est_p99, 0.99f);
+    p2_quantile_init(&est_mad, 0.50f);
+    initialized = true;
+}
+
+void robust_stats_add(float value) {
+    if (!initialized) {
+        robust_stats_reset();
+    }
+
+    p2_quantile_add(&est_median, value);
+    p2_quantile_add(&est_p95, value);
+    p2_quantile_add(&est_p99, value);
+    p2_quantile_add(&est_mad, fabsf(value - p2_quantile_value(&est_median)));
+}
+
+esp_err_t robust_stats_get(robust_stats_t* stats) {
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!initialized || est_median.count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    stats->count = est_median.count;
+    stats->median = p2_quantile_value(&est_median);
+    stats->p95 = p2_quantile_value(&est_p95);
+    stats->p99 = p2_quantile_value(&est_p99);
+    stats->mad = p2_quantile_value(&est_mad);
+    return ESP_OK;
+}
+
+void robust_stats_assess(float value, robust_assessment_t* assessment) {
+    if (!assessment) return;
+
+    memset(assessment, 0, sizeof(robust_assessment_t));
+    robust_stats_t stats;
+    if (robust_stats_get(&stats) != ESP_OK || stats.count < ROBUST_STATS_WARMUP) {
+        return;
+    }
+
+    // 1.4826 * MAD estima o desvio-padrão sob ruído gaussiano; piso evita cena parada (MAD ~ 0)
+    float scale = fmaxf(1.4826f * stats.mad, ROBUST_MAD_FLOOR);
+    assessment->ready = true;
+    assessment->above_p95 = value > stats.p95;
+    assessment->above_p99 = value > stats.p99;
+    assessment->robust_z = (value - stats.median) / scale;
+    assessment->anomalous = assessment->above_p99 && assessment->robust_z >= ROBUST_ANOMALY_Z;
+}
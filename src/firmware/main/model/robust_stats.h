@@ -0,0 +1,105 @@
+/**
+ * @file robust_stats.h
+ * @brief Quantis das diferenças em memória fixa (estimador P²)
+ *
+ * Mediana, percentis 95/99 e desvio absoluto mediano (MAD) das diferenças
+ * por captura, estimados com o algoritmo P² de Jain & Chlamtac: cinco
+ * marcadores por quantil, atualização O(1) e nenhuma amostra guardada.
+ * A decisão de anomalia compara a captura com a distribuição da própria
+ * câmera, em vez de um limiar fixo para todas as cenas.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#ifndef ROBUST_STATS_H
+#define ROBUST_STATS_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Estimador P² de um quantil (5 marcadores)
+ */
+typedef struct {
+    float p;                    ///< Quantil alvo (0.0 a 1.0)
+    uint32_t count;             ///< Amostras observadas
+    float q[5];                 ///< Alturas dos marcadores
+    float n[5];                 ///< Posições reais dos marcadores
+    float np[5];                ///< Posições desejadas
+    float dn[5];                ///< Incremento das posições desejadas
+} p2_quantile_t;
+
+/**
+ * @brief Quantis atuais das diferenças (%)
+ */
+typedef struct {
+    uint32_t count;             ///< Capturas observadas desde o boot
+    float median;
+    float p95;
+    float p99;
+    float mad;                  ///< Mediana de |diferença - mediana|
+} robust_stats_t;
+
+/**
+ * @brief Posição de uma diferença na distribuição da câmera
+ */
+typedef struct {
+    bool ready;                 ///< Amostras suficientes (ROBUST_STATS_WARMUP)
+    bool above_p95;
+    bool above_p99;
+    float robust_z;             ///< (x - mediana) / (1.4826 * MAD)
+    bool anomalous;             ///< Acima do p99 e com robust_z >= ROBUST_ANOMALY_Z
+} robust_assessment_t;
+
+/**
+ * Inicializa um estimador P²
+ * @param est Estimador
+ * @param p Quantil alvo (0.0 a 1.0)
+ */
+void p2_quantile_init(p2_quantile_t* est, float p);
+
+/**
+ * Adiciona uma amostra ao estimador (O(1))
+ */
+void p2_quantile_add(p2_quantile_t* est, float x);
+
+/**
+ * Estimativa atual do quantil (exata com menos de 5 amostras)
+ */
+float p2_quantile_value(const p2_quantile_t* est);
+
+/**
+ * Descarta as estimativas das diferenças
+ */
+void robust_stats_reset(void);
+
+/**
+ * Adiciona a diferença de uma captura a todos os estimadores
+ * @param value Percentual de diferença
+ */
+void robust_stats_add(float value);
+
+/**
+ * Obtém os quantis atuais
+ * @param stats Estrutura de saída
+ * @return ESP_OK, ou ESP_ERR_INVALID_STATE sem amostras
+ */
+esp_err_t robust_stats_get(robust_stats_t* stats);
+
+/**
+ * Classifica uma diferença contra a distribuição atual (não a adiciona)
+ * @param value Percentual de diferença
+ * @param assessment Estrutura de saída
+ */
+void robust_stats_assess(float value, robust_assessment_t* assessment);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROBUST_STATS_H
@@ -0,0 +1,238 @@
+/**
+ * @file state_store.c
+ * @brief Implementação da persistência do estado no SPIFFS
+ *
+ * Dois arquivos: ref.jpg (JPEG da referência) e state.bin (contadores,
+ * linha de base da lente e o CRC32 do JPEG). O JPEG é gravado antes do
+ * estado; se a energia cair entre os dois, o CRC do estado não confere e
+ * apenas a referência é descartada na próxima inicialização.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "state_store.h"
+#include "config.h"
+#include "compare.h"
+#include "lens_check.h"
+#include "esp_log.h"
+#include "esp_spiffs.h"
+#include "mem_account.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+
+static const char *TAG = "STATE_STORE";
+
+#define STATE_MAGIC     0x31455453  // "STE1"
+#define STATE_VERSION   1
+#define STATE_FILE      STATE_STORE_BASE_PATH "/state.bin"
+#define STATE_TMP_FILE  STATE_STORE_BASE_PATH "/state.tmp"
+#define REF_FILE        STATE_STORE_BASE_PATH "/ref.jpg"
+#define REF_TMP_FILE    STATE_STORE_BASE_PATH "/ref.tmp"
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t blocks;                // Grade da linha de base (COMPARE_MAX_BLOCKS)
+    uint32_t crc;                   // CRC32 de tudo após este campo
+    detector_counters_t counters;
+    lens_baseline_t lens;
+    uint32_t reference_len;         // 0 = sem referência salva
+    uint32_t reference_crc;
+    uint16_t reference_width;
+    uint16_t reference_height;
+} state_blob_t;
+
+static bool mounted = false;
+static state_blob_t blob;           // Estático: ~1.3 KB fora da pilha da tarefa
+static uint32_t saved_state_crc = 0;
+static uint32_t saved_reference_crc = 0;
+static uint32_t saved_reference_len = 0;
+static uint32_t saved_generation = UINT32_MAX;
+static int64_t last_state_us = 0;
+static int64_t last_reference_us = 0;
+static uint32_t write_count = 0;
+
+static uint32_t blob_crc(const state_blob_t* b) {
+    const uint8_t *start = (const uint8_t*)&b->crc + sizeof(b->crc);
+    return esp_rom_crc32_le(0, start, sizeof(state_blob_t) - (size_t)(start - (const uint8_t*)b));
+}
+
+/**
+ * Grava em arquivo temporário e renomeia (SPIFFS não sobrescreve no rename)
+ */
+static esp_err_t write_file(const char* tmp_path, const char* path, const void* data, size_t len) {
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Falha ao abrir %s", tmp_path);
+        return ESP_FAIL;
+    }
+    size_t written = fwrite(data, 1, len, f);
+    fclose(f);
+    if (written != len) {
+        ESP_LOGE(TAG, "Gravação incompleta de %s (%zu/%zu bytes)", tmp_path, written, len);
+        unlink(tmp_path);
+        return ESP_FAIL;
+    }
+
+    unlink(path);
+    if (rename(tmp_path, path) != 0) {
+        ESP_LOGE(TAG, "Falha ao renomear %s", tmp_path);
+        return ESP_FAIL;
+    }
+    write_count++;
+    return ESP_OK;
+}
+
+esp_err_t state_store_init(void) {
+    if (mounted) {
+        return ESP_OK;
+    }
+
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = STATE_STORE_BASE_PATH,
+        .partition_label = "storage",
+        .max_files = 2,
+        .format_if_mount_failed = true,
+    };
+    esp_err_t err = esp_vfs_spiffs_register(&conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao montar SPIFFS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    size_t total = 0, used = 0;
+    esp_spiffs_info("storage", &total, &used);
+    mounted = true;
+    ESP_LOGI(TAG, "✅ SPIFFS de estado montado: %" PRIu32 "/%" PRIu32 " KB usados",
+             (uint32_t)(used / 1024), (uint32_t)(total / 1024));
+    return ESP_OK;
+}
+
+esp_err_t state_store_load(detector_counters_t* counters, frame_handle_t** reference) {
+    if (!counters || !reference) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *reference = NULL;
+    if (!mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    FILE *f = fopen(STATE_FILE, "rb");
+    if (!f) {
+        ESP_LOGI(TAG, "Nenhum estado salvo - iniciando do zero");
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t read = fread(&blob, 1, sizeof(blob), f);
+    fclose(f);
+
+    if (read != sizeof(blob) || blob.magic != STATE_MAGIC || blob.version != STATE_VERSION ||
+        blob.blocks != COMPARE_MAX_BLOCKS || blob.crc != blob_crc(&blob)) {
+        ESP_LOGW(TAG, "⚠️ Estado salvo inválido ou de outra versão - descartado");
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    *counters = blob.counters;
+    counters->boot_count++;
+    lens_check_import(&blob.lens);
+    saved_state_crc = blob.crc;
+
+    // Referência: JPEG lido para um buffer temporário e copiado para o pool
+    if (blob.reference_len > 0 && blob.reference_len <= MAX_IMAGE_SIZE) {
+        uint8_t *jpeg = (uint8_t*)mem_alloc(MEM_TAG_STATE, blob.reference_len, MALLOC_CAP_SPIRAM);
+        f = jpeg ? fopen(REF_FILE, "rb") : NULL;
+        if (f) {
+            read = fread(jpeg, 1, blob.reference_len, f);
+            fclose(f);
+            if (read == blob.reference_len &&
+                esp_rom_crc32_le(0, jpeg, blob.reference_len) == blob.reference_crc) {
+                camera_fb_t fb = {
+                    .buf = jpeg,
+                    .len = blob.reference_len,
+                    .width = blob.reference_width,
+                    .height = blob.reference_height,
+                    .format = PIXFORMAT_JPEG,
+                };
+                *reference = frame_handle_create(&fb);
+                saved_reference_crc = blob.reference_crc;
+                saved_reference_len = blob.reference_len;
+            } else {
+                ESP_LOGW(TAG, "⚠️ JPEG de referência não confere com o estado - descartado");
+            }
+        }
+        mem_free(jpeg);
+    }
+
+    ESP_LOGI(TAG, "♻️ Estado restaurado: boot #%" PRIu32 ", %" PRIu32 " capturas, referência %s",
+             counters->boot_count, counters->capture_count, *reference ? "restaurada" : "ausente");
+    return ESP_OK;
+}
+
+esp_err_t state_store_save(const detector_counters_t* counters, frame_handle_t* reference,
+                           uint32_t reference_generation, bool force) {
+    if (!mounted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!counters) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t now = esp_timer_get_time();
+    bool nothing_saved = saved_reference_len == 0;
+    bool reference_due = reference && reference_generation != saved_generation &&
+                         (force || nothing_saved ||
+                          now - last_reference_us >= (int64_t)STATE_REFERENCE_MIN_S * 1000000);
+    bool state_due = force || reference_due ||
+                     now - last_state_us >= (int64_t)STATE_SAVE_INTERVAL_S * 1000000;
+    if (!state_due) {
+        return ESP_OK;
+    }
+
+    // JPEG primeiro; conteúdo idêntico ao salvo não é regravado
+    if (reference_due) {
+        camera_fb_t *fb = frame_handle_fb(reference);
+        uint32_t crc = esp_rom_crc32_le(0, fb->buf, fb->len);
+        if (crc != saved_reference_crc || fb->len != saved_reference_len) {
+            esp_err_t err = write_file(REF_TMP_FILE, REF_FILE, fb->buf, fb->len);
+            if (err != ESP_OK) {
+                return err;
+            }
+            saved_reference_crc = crc;
+            saved_reference_len = fb->len;
+            ESP_LOGI(TAG, "💾 Referência gravada (%zu bytes)", fb->len);
+        }
+        saved_generation = reference_generation;
+        last_reference_us = now;
+
+        blob.reference_width = (uint16_t)fb->width;
+        blob.reference_height = (uint16_t)fb->height;
+    }
+
+    blob.magic = STATE_MAGIC;
+    blob.version = STATE_VERSION;
+    blob.blocks = COMPARE_MAX_BLOCKS;
+    blob.counters = *counters;
+    lens_check_export(&blob.lens);
+    blob.reference_len = saved_reference_len;
+    blob.reference_crc = saved_reference_crc;
+    blob.crc = blob_crc(&blob);
+    last_state_us = now;
+
+    if (blob.crc == saved_state_crc) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = write_file(STATE_TMP_FILE, STATE_FILE, &blob, sizeof(blob));
+    if (err == ESP_OK) {
+        saved_state_crc = blob.crc;
+        ESP_LOGD(TAG, "💾 Estado gravado (%" PRIu32 " gravações desde o boot)", write_count);
+    }
+    return err;
+}
+
+uint32_t state_store_write_count(void) {
+    return write_count;
+}
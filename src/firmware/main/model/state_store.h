@@ -0,0 +1,74 @@
+/**
+ * @file state_store.h
+ * @brief Persistência da referência e do estado do detector na flash
+ *
+ * A referência ativa (JPEG), os contadores e a linha de base da lente são
+ * gravados na partição SPIFFS "storage". Após uma reinicialização (inclusive
+ * os esp_restart() por falha de WiFi/MQTT) a detecção continua com a
+ * referência salva, sem reenviar "reference_established".
+ *
+ * As gravações são limitadas por intervalo, o JPEG só é regravado quando a
+ * referência muda e arquivos com conteúdo idêntico não são reescritos.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include "esp_err.h"
+#include "frame_handle.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Contadores do modo inteligente preservados entre reinicializações
+ */
+typedef struct {
+    uint32_t capture_count;
+    uint32_t reference_count;
+    uint32_t photos_captured;
+    uint32_t photos_sent;
+    uint32_t bytes_sent;
+    uint32_t boot_count;        ///< Reinicializações com estado restaurado
+} detector_counters_t;
+
+/**
+ * Monta a partição SPIFFS de estado
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t state_store_init(void);
+
+/**
+ * Restaura contadores, linha de base da lente e a referência salva
+ * @param counters Saída: contadores salvos
+ * @param reference Saída: referência copiada para o pool (com uma referência do chamador) ou NULL
+ * @return ESP_OK se havia estado válido, ESP_ERR_NOT_FOUND sem estado salvo
+ */
+esp_err_t state_store_load(detector_counters_t* counters, frame_handle_t** reference);
+
+/**
+ * Grava o estado se o intervalo mínimo passou (ou se force)
+ * @param counters Contadores atuais
+ * @param reference Referência ativa (NULL = manter a salva)
+ * @param reference_generation Muda sempre que a referência ativa é trocada
+ * @param force Ignorar os intervalos mínimos
+ * @return ESP_OK se gravou ou não havia o que gravar
+ */
+esp_err_t state_store_save(const detector_counters_t* counters, frame_handle_t* reference,
+                           uint32_t reference_generation, bool force);
+
+/**
+ * Número de gravações na flash desde o boot (acompanhamento de desgaste)
+ */
+uint32_t state_store_write_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATE_STORE_H
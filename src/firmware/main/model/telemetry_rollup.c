@@ -0,0 +1,98 @@
+/**
+ * @file telemetry_rollup.c
+ * @brief Implementação dos agregados de telemetria
+ *
+ * Na sincronização SNTP o timestamp salta de uptime para época Unix; a
+ * janela aberta é então fechada com first/last reais, e as seguintes já
+ * ficam alinhadas ao relógio de parede (dias em UTC).
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "telemetry_rollup.h"
+#include <string.h>
+
+static const uint32_t durations[ROLLUP_SCALE_COUNT] = { 60, 3600, 86400 };
+
+static rollup_bucket_t open_buckets[ROLLUP_SCALE_COUNT];
+static bool open_valid[ROLLUP_SCALE_COUNT];
+
+static void stat_add(rollup_stat_t* stat, float value) {
+    if (stat->count == 0 || value < stat->min) stat->min = value;
+    if (stat->count == 0 || value > stat->max) stat->max = value;
+    stat->sum += value;
+    stat->count++;
+}
+
+static void bucket_open(rollup_bucket_t* bucket, rollup_scale_t scale, uint64_t timestamp) {
+    memset(bucket, 0, sizeof(rollup_bucket_t));
+    bucket->scale = scale;
+    bucket->start = timestamp - timestamp % durations[scale];
+    bucket->first = timestamp;
+}
+
+void telemetry_rollup_reset(void) {
+    memset(open_buckets, 0, sizeof(open_buckets));
+    memset(open_valid, 0, sizeof(open_valid));
+}
+
+int telemetry_rollup_add(const rollup_sample_t* sample, uint64_t timestamp,
+                         rollup_bucket_t closed[ROLLUP_SCALE_COUNT]) {
+    if (!sample || !closed) {
+        return 0;
+    }
+
+    int closed_count = 0;
+    for (int s = 0; s < ROLLUP_SCALE_COUNT; s++) {
+        rollup_bucket_t *bucket = &open_buckets[s];
+        uint64_t start = timestamp - timestamp % durations[s];
+
+        // Janela terminou (ou o relógio saltou): entregar e abrir a seguinte
+        if (open_valid[s] && start != bucket->start) {
+            closed[closed_count++] = *bucket;
+            open_valid[s] = false;
+        }
+        if (!open_valid[s]) {
+            bucket_open(bucket, (rollup_scale_t)s, timestamp);
+            open_valid[s] = true;
+        }
+
+        bucket->last = timestamp;
+        stat_add(&bucket->metrics[ROLLUP_DIFFERENCE], sample->difference);
+        stat_add(&bucket->metrics[ROLLUP_IMAGE_SIZE], (float)sample->image_size);
+        stat_add(&bucket->metrics[ROLLUP_SENT], sample->sent ? 1.0f : 0.0f);
+        stat_add(&bucket->metrics[ROLLUP_FREE_HEAP], (float)sample->free_heap);
+        if (sample->has_rssi) {
+            stat_add(&bucket->metrics[ROLLUP_RSSI], sample->rssi);
+        }
+    }
+    return closed_count;
+}
+
+float telemetry_rollup_mean(const rollup_stat_t* stat) {
+    return (stat && stat->count > 0) ? (float)(stat->sum / stat->count) : 0.0f;
+}
+
+uint32_t telemetry_rollup_duration(rollup_scale_t scale) {
+    return scale < ROLLUP_SCALE_COUNT ? durations[scale] : 0;
+}
+
+const char* telemetry_rollup_scale_name(rollup_scale_t scale) {
+    switch (scale) {
+        case ROLLUP_MINUTE: return "1m";
+        case ROLLUP_HOUR: return "1h";
+        case ROLLUP_DAY: return "1d";
+        default: return "unknown";
+    }
+}
+
+const char* telemetry_rollup_metric_name(rollup_metric_t metric) {
+    switch (metric) {
+        case ROLLUP_DIFFERENCE: return "difference";
+        case ROLLUP_IMAGE_SIZE: return "image_size";
+        case ROLLUP_SENT: return "sent";
+        case ROLLUP_FREE_HEAP: return "free_heap";
+        case ROLLUP_RSSI: return "rssi";
+        default: return "unknown";
+    }
+}
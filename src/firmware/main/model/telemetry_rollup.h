@@ -0,0 +1,124 @@
+/**
+ * @file telemetry_rollup.h
+ * @brief Agregados de telemetria em 1 minuto, 1 hora e 1 dia
+ *
+ * Este módulo fornece funções para:
+ * - Mínimo, máximo, média e contagem por janela de diferença, tamanho da
+ *   imagem, decisão de envio, heap livre e RSSI
+ * - Janelas alinhadas ao timestamp dos payloads (época Unix após a
+ *   sincronização SNTP), fechadas na primeira captura da janela seguinte
+ *
+ * A memória é fixa (uma janela aberta por escala); nada é percorrido.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef TELEMETRY_ROLLUP_H
+#define TELEMETRY_ROLLUP_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Escalas de agregação
+ */
+typedef enum {
+    ROLLUP_MINUTE = 0,
+    ROLLUP_HOUR,
+    ROLLUP_DAY,
+    ROLLUP_SCALE_COUNT
+} rollup_scale_t;
+
+/**
+ * @brief Grandezas agregadas
+ */
+typedef enum {
+    ROLLUP_DIFFERENCE = 0,      ///< Diferença da captura (%)
+    ROLLUP_IMAGE_SIZE,          ///< Tamanho do JPEG (bytes)
+    ROLLUP_SENT,                ///< Imagem enviada (0/1; média = taxa de envio)
+    ROLLUP_FREE_HEAP,           ///< Heap livre (bytes)
+    ROLLUP_RSSI,                ///< RSSI do AP (dBm; só capturas associadas)
+    ROLLUP_METRIC_COUNT
+} rollup_metric_t;
+
+/**
+ * @brief Estatísticas de uma grandeza na janela
+ */
+typedef struct {
+    float min;
+    float max;
+    double sum;
+    uint32_t count;
+} rollup_stat_t;
+
+/**
+ * @brief Janela de agregação
+ */
+typedef struct {
+    rollup_scale_t scale;
+    uint64_t start;             ///< Início alinhado da janela (mesma base do timestamp)
+    uint64_t first;             ///< Timestamp da primeira captura agregada
+    uint64_t last;              ///< Timestamp da última captura agregada
+    rollup_stat_t metrics[ROLLUP_METRIC_COUNT];
+} rollup_bucket_t;
+
+/**
+ * @brief Amostra de uma captura
+ */
+typedef struct {
+    float difference;
+    uint32_t image_size;
+    bool sent;
+    uint32_t free_heap;
+    bool has_rssi;
+    int8_t rssi;
+} rollup_sample_t;
+
+/**
+ * Descarta as janelas abertas
+ */
+void telemetry_rollup_reset(void);
+
+/**
+ * Agrega uma captura
+ *
+ * Janelas cujo período terminou são copiadas para closed (no máximo uma
+ * por escala) antes de a amostra entrar na janela nova.
+ *
+ * @param sample Amostra da captura
+ * @param timestamp Timestamp da captura (time_sync_timestamp_at() do instante capturado)
+ * @param closed Saída: janelas fechadas (ROLLUP_SCALE_COUNT posições)
+ * @return Número de janelas fechadas
+ */
+int telemetry_rollup_add(const rollup_sample_t* sample, uint64_t timestamp,
+                         rollup_bucket_t closed[ROLLUP_SCALE_COUNT]);
+
+/**
+ * Média de uma grandeza (0 sem amostras)
+ */
+float telemetry_rollup_mean(const rollup_stat_t* stat);
+
+/**
+ * Duração da escala em segundos
+ */
+uint32_t telemetry_rollup_duration(rollup_scale_t scale);
+
+/**
+ * Nome da escala ("1m", "1h", "1d")
+ */
+const char* telemetry_rollup_scale_name(rollup_scale_t scale);
+
+/**
+ * Nome da grandeza ("difference", "image_size", "sent", "free_heap", "rssi")
+ */
+const char* telemetry_rollup_metric_name(rollup_metric_t metric);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_ROLLUP_H
@@ -0,0 +1,110 @@
+/**
+ * @file thumbnail.c
+ * @brief Implementação das miniaturas em tons de cinza
+ *
+ * O codificador do esp32-camera entrega o JPEG em pedaços pelo callback;
+ * gravar direto no slot do chamador evita o buffer de 128 KB que
+ * fmt2jpg() alocaria a cada chamada. Como o codificador ignora escritas
+ * curtas, o estouro é marcado e verificado ao final.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "thumbnail.h"
+#include "config.h"
+#include "esp_log.h"
+#include "img_converters.h"
+#include "mem_account.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "THUMBNAIL";
+
+typedef struct {
+    uint8_t *out;
+    size_t capacity;
+    size_t len;
+    bool overflow;
+} thumb_sink_t;
+
+// Plano reduzido (reutilizado entre chamadas)
+static uint8_t *reduced = NULL;
+static size_t reduced_size = 0;
+
+static size_t sink_write(void *arg, size_t index, const void *data, size_t len) {
+    thumb_sink_t *sink = (thumb_sink_t *)arg;
+    if (!data || len == 0) {
+        return 0;
+    }
+    if (sink->overflow || index + len > sink->capacity) {
+        sink->overflow = true;
+        return 0;
+    }
+    memcpy(sink->out + index, data, len);
+    sink->len = index + len;
+    return len;
+}
+
+esp_err_t thumbnail_encode(const luma_plane_t* plane, int scale_shift, uint8_t quality,
+                           uint8_t* out, size_t capacity, size_t* out_len) {
+    if (!plane || !plane->pixels || !out || !out_len || scale_shift < COMPARE_SCALE_SHIFT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_len = 0;
+
+    int factor = 1 << (scale_shift - COMPARE_SCALE_SHIFT);
+    uint16_t width = plane->width / factor;
+    uint16_t height = plane->height / factor;
+    size_t pixels = (size_t)width * height;
+    if (pixels == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (reduced_size < pixels) {
+        if (reduced) {
+            mem_free(reduced);
+        }
+        reduced = (uint8_t *)mem_alloc(MEM_TAG_COMPARE, pixels, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        reduced_size = reduced ? pixels : 0;
+        if (!reduced) {
+            ESP_LOGE(TAG, "Falha ao alocar plano reduzido %ux%u", width, height);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // Média de cada bloco factor x factor (antialiasing da redução)
+    const int shift = 2 * (scale_shift - COMPARE_SCALE_SHIFT);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t sum = 0;
+            for (int dy = 0; dy < factor; dy++) {
+                const uint8_t *row = plane->pixels + (size_t)(y * factor + dy) * plane->width + x * factor;
+                for (int dx = 0; dx < factor; dx++) {
+                    sum += row[dx];
+                }
+            }
+            reduced[(size_t)y * width + x] = (uint8_t)(sum >> shift);
+        }
+    }
+
+    thumb_sink_t sink = { .out = out, .capacity = capacity };
+    bool encoded = fmt2jpg_cb(reduced, pixels, width, height, PIXFORMAT_GRAYSCALE, quality, sink_write, &sink);
+    if (sink.overflow) {
+        ESP_LOGD(TAG, "Miniatura %ux%u excede %u bytes", width, height, (unsigned)capacity);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!encoded || sink.len == 0) {
+        return ESP_FAIL;
+    }
+
+    *out_len = sink.len;
+    return ESP_OK;
+}
+
+void thumbnail_deinit(void) {
+    if (reduced) {
+        mem_free(reduced);
+        reduced = NULL;
+    }
+    reduced_size = 0;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file thumbnail.h
+ * @brief Miniaturas JPEG em tons de cinza a partir do plano de luminância
+ *
+ * Este módulo fornece funções para:
+ * - Reduzir o plano já decodificado (média de blocos, sem nova decodificação)
+ * - Codificar a miniatura direto no buffer do chamador (sem alocação por captura)
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef THUMBNAIL_H
+#define THUMBNAIL_H
+
+#include "esp_err.h"
+#include "compare.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Reduz o plano e codifica em JPEG de tons de cinza
+ * @param plane Plano de luminância na escala de comparação
+ * @param scale_shift Escala da miniatura em relação ao frame (>= COMPARE_SCALE_SHIFT; 3 = 1/8)
+ * @param quality Qualidade JPEG (1-100)
+ * @param out Destino do JPEG
+ * @param capacity Bytes disponíveis em out
+ * @param out_len Saída: bytes escritos
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE se o JPEG não cabe em capacity, ESP_FAIL na codificação
+ */
+esp_err_t thumbnail_encode(const luma_plane_t* plane, int scale_shift, uint8_t quality,
+                           uint8_t* out, size_t capacity, size_t* out_len);
+
+/**
+ * Libera o buffer da redução
+ */
+void thumbnail_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // THUMBNAIL_H
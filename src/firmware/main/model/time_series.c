@@ -0,0 +1,151 @@
+/**
+ * @file time_series.c
+ * @brief Implementação da série temporal com janela deslizante
+ *
+ * Na regressão, x é a posição da amostra na janela (0 = mais antiga).
+ * Quando a amostra mais antiga sai, todas as posições caem em 1, o que
+ * equivale a subtrair Σy de Σxy; Σx e Σx² dependem só de n. A cada volta
+ * completa da janela as somas são recalculadas para descartar o erro de
+ * arredondamento acumulado (custo amortizado O(1)).
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "time_series.h"
+#include "config.h"
+#include "esp_log.h"
+#include "mem_account.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "TIME_SERIES";
+
+static float* samples = NULL;   // Buffer circular de TIME_SERIES_WINDOW amostras
+static int head = 0;            // Posição da amostra mais antiga
+static int count = 0;
+static int since_resync = 0;
+
+// Welford e somas da regressão (double: a janela tem milhares de amostras)
+static double mean = 0.0;
+static double m2 = 0.0;
+static double sum_y = 0.0;
+static double sum_xy = 0.0;
+
+esp_err_t time_series_init(void) {
+    if (samples) {
+        return ESP_OK;
+    }
+
+    samples = (float*)mem_alloc(MEM_TAG_TIME_SERIES, TIME_SERIES_WINDOW * sizeof(float), MALLOC_CAP_SPIRAM);
+    if (!samples) {
+        ESP_LOGE(TAG, "Falha ao alocar janela de %d amostras", TIME_SERIES_WINDOW);
+        return ESP_ERR_NO_MEM;
+    }
+
+    time_series_reset();
+    ESP_LOGI(TAG, "✅ Série temporal: %d amostras (%.1f h, %d bytes)",
+             TIME_SERIES_WINDOW, TIME_SERIES_WINDOW * (CAPTURE_INTERVAL_MS / 1000.0f) / 3600.0f,
+             (int)(TIME_SERIES_WINDOW * sizeof(float)));
+    return ESP_OK;
+}
+
+/**
+ * Recalcula as somas a partir das amostras da janela
+ */
+static void resync(void) {
+    double s = 0.0, sxy = 0.0;
+    for (int i = 0; i < count; i++) {
+        double y = samples[(head + i) % TIME_SERIES_WINDOW];
+        s += y;
+        sxy += (double)i * y;
+    }
+
+    double new_mean = count > 0 ? s / count : 0.0;
+    double sq = 0.0;
+    for (int i = 0; i < count; i++) {
+        double d = samples[(head + i) % TIME_SERIES_WINDOW] - new_mean;
+        sq += d * d;
+    }
+
+    mean = new_mean;
+    m2 = sq;
+    sum_y = s;
+    sum_xy = sxy;
+    since_resync = 0;
+}
+
+void time_series_add(float value) {
+    if (!samples) return;
+
+    if (count == TIME_SERIES_WINDOW) {
+        // Remover a mais antiga (Welford inverso) e deslocar as posições
+        double old = samples[head];
+        head = (head + 1) % TIME_SERIES_WINDOW;
+        count--;
+
+        if (count == 0) {
+            mean = 0.0;
+            m2 = 0.0;
+        } else {
+            double delta = old - mean;
+            mean -= delta / count;
+            m2 -= delta * (old - mean);
+            if (m2 < 0.0) m2 = 0.0;
+        }
+        sum_y -= old;
+        sum_xy -= sum_y;
+    }
+
+    // Inserir na posição x = count
+    samples[(head + count) % TIME_SERIES_WINDOW] = value;
+    double delta = value - mean;
+    count++;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+    sum_xy += (double)(count - 1) * value;
+    sum_y += value;
+
+    if (++since_resync >= TIME_SERIES_WINDOW) {
+        resync();
+    }
+}
+
+esp_err_t time_series_get_stats(time_series_stats_t* stats) {
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(stats, 0, sizeof(time_series_stats_t));
+    stats->count = count;
+    if (!samples || count < 2) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    double n = count;
+    double variance = m2 / (n - 1.0);
+
+    // Σx = n(n-1)/2 e Σx² = (n-1)n(2n-1)/6 para x = 0..n-1
+    double sum_x = n * (n - 1.0) / 2.0;
+    double sum_xx = (n - 1.0) * n * (2.0 * n - 1.0) / 6.0;
+    double denom = n * sum_xx - sum_x * sum_x;
+    double slope = denom > 0.0 ? (n * sum_xy - sum_x * sum_y) / denom : 0.0;
+    double samples_per_hour = 3600000.0 / CAPTURE_INTERVAL_MS;
+
+    stats->mean = (float)mean;
+    stats->variance = (float)variance;
+    stats->stddev = sqrtf((float)variance);
+    stats->slope_per_hour = (float)(slope * samples_per_hour);
+    stats->stability_index = 1.0f / (1.0f + (float)variance / 10.0f);
+    stats->window_hours = (float)(n / samples_per_hour);
+    return ESP_OK;
+}
+
+void time_series_reset(void) {
+    head = 0;
+    count = 0;
+    since_resync = 0;
+    mean = 0.0;
+    m2 = 0.0;
+    sum_y = 0.0;
+    sum_xy = 0.0;
+}
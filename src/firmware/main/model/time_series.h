@@ -0,0 +1,66 @@
+/**
+ * @file time_series.h
+ * @brief Série temporal das diferenças por captura com estatísticas O(1)
+ *
+ * Guarda apenas o percentual de diferença de cada captura (4 bytes) numa
+ * janela deslizante longa, independente do histórico de JPEGs. Média,
+ * variância (Welford) e somas da regressão linear são atualizadas a cada
+ * amostra que entra e sai da janela, então tendência e estabilidade de
+ * horas custam tempo constante por captura.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Estatísticas da janela atual
+ */
+typedef struct {
+    int count;                  ///< Amostras na janela
+    float mean;                 ///< Diferença média (%)
+    float variance;             ///< Variância amostral
+    float stddev;               ///< Desvio-padrão
+    float slope_per_hour;       ///< Tendência da regressão linear (pontos percentuais por hora)
+    float stability_index;      ///< 1 / (1 + variância/10), mesma escala de perform_temporal_analysis()
+    float window_hours;         ///< Duração coberta pela janela
+} time_series_stats_t;
+
+/**
+ * Aloca a janela de TIME_SERIES_WINDOW amostras na PSRAM
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t time_series_init(void);
+
+/**
+ * Adiciona a diferença de uma captura; a mais antiga sai quando a janela enche
+ * @param value Percentual de diferença da captura
+ */
+void time_series_add(float value);
+
+/**
+ * Obtém as estatísticas da janela sem percorrê-la
+ * @param stats Estrutura de saída
+ * @return ESP_OK, ou ESP_ERR_INVALID_STATE com menos de 2 amostras
+ */
+esp_err_t time_series_get_stats(time_series_stats_t* stats);
+
+/**
+ * Descarta todas as amostras
+ */
+void time_series_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIME_SERIES_H
@@ -0,0 +1,77 @@
+/**
+ * @file time_sync.c
+ * @brief Implementação da sincronização SNTP
+ *
+ * O deslocamento é atualizado no callback de cada sincronização
+ * (CONFIG_LWIP_SNTP_UPDATE_DELAY); entre elas a conversão usa apenas o
+ * esp_timer, imune a ajustes do relógio de parede.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "time_sync.h"
+#include "config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif_sntp.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+#include <inttypes.h>
+
+static const char *TAG = "TIME_SYNC";
+
+// Época (µs) menos esp_timer (µs); 0 = ainda não sincronizado
+static atomic_llong epoch_offset_us = 0;
+
+static void time_sync_notification(struct timeval *tv) {
+    int64_t wall_us = (int64_t)tv->tv_sec * 1000000LL + tv->tv_usec;
+    int64_t previous = atomic_exchange(&epoch_offset_us, wall_us - esp_timer_get_time());
+
+    time_t now = tv->tv_sec;
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &timeinfo);
+    if (previous == 0) {
+        ESP_LOGI(TAG, "🕒 Relógio sincronizado: %s", buf);
+    } else {
+        ESP_LOGD(TAG, "🕒 Ressincronizado: %s (ajuste %" PRId64 " ms)", buf,
+                 (wall_us - esp_timer_get_time() - previous) / 1000);
+    }
+}
+
+esp_err_t time_sync_init(void) {
+    setenv("TZ", TIME_SYNC_TIMEZONE, 1);
+    tzset();
+
+    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(TIME_SYNC_SERVER);
+    config.sync_cb = time_sync_notification;
+    esp_err_t err = esp_netif_sntp_init(&config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao iniciar SNTP: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "✅ SNTP iniciado (%s, TZ %s)", TIME_SYNC_SERVER, TIME_SYNC_TIMEZONE);
+    return ESP_OK;
+}
+
+bool time_sync_is_synced(void) {
+    return atomic_load(&epoch_offset_us) != 0;
+}
+
+int64_t time_sync_to_epoch_ms(int64_t monotonic_us) {
+    int64_t offset = atomic_load(&epoch_offset_us);
+    return offset != 0 ? (monotonic_us + offset) / 1000 : 0;
+}
+
+uint64_t time_sync_timestamp(void) {
+    return time_sync_timestamp_at(esp_timer_get_time());
+}
+
+uint64_t time_sync_timestamp_at(int64_t monotonic_us) {
+    int64_t epoch_ms = time_sync_to_epoch_ms(monotonic_us);
+    return (uint64_t)(epoch_ms != 0 ? epoch_ms / 1000 : monotonic_us / 1000000LL);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file time_sync.h
+ * @brief Sincronização SNTP e conversão do relógio monotônico para época Unix
+ *
+ * A cada sincronização é guardado o deslocamento entre esp_timer_get_time()
+ * e o relógio de parede. Os timestamps dos payloads passam a ser época
+ * Unix (segundos), comparáveis entre reinicializações; antes da primeira
+ * sincronização continuam sendo o uptime em segundos (valores pequenos,
+ * fáceis de distinguir no servidor).
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Inicia o cliente SNTP (chamar após a rede estar configurada)
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t time_sync_init(void);
+
+/**
+ * Indica se o relógio já foi sincronizado neste boot
+ */
+bool time_sync_is_synced(void);
+
+/**
+ * Converte um instante de esp_timer_get_time() para época Unix
+ * @param monotonic_us Instante monotônico (µs desde o boot)
+ * @return Milissegundos desde 1970, ou 0 sem sincronização
+ */
+int64_t time_sync_to_epoch_ms(int64_t monotonic_us);
+
+/**
+ * Timestamp dos payloads: época Unix em segundos se sincronizado, senão uptime
+ */
+uint64_t time_sync_timestamp(void);
+
+/**
+ * Timestamp de um instante passado (ex.: captura publicada depois, pela fila)
+ * @param monotonic_us Instante monotônico (µs desde o boot)
+ * @return Época Unix em segundos se sincronizado, senão uptime no instante
+ */
+uint64_t time_sync_timestamp_at(int64_t monotonic_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIME_SYNC_H
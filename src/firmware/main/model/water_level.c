@@ -0,0 +1,162 @@
+/**
+ * @file water_level.c
+ * @brief Implementação da estimativa do nível da água
+ *
+ * Na coluna de medição, a margem/régua acima da água tem textura e
+ * intensidade diferentes da lâmina d'água abaixo. Os perfis por linha são
+ * ajustados por dois segmentos constantes; a linha de corte com menor erro
+ * é a linha d'água e a fração da variância explicada é a confiança.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#include "water_level.h"
+#include "config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "WATER_LEVEL";
+
+#define WATER_MIN_SEGMENT_ROWS  4       // Linhas mínimas acima/abaixo da linha d'água
+#define WATER_MIN_PROFILE_VAR   1e-3f   // Variância mínima do perfil para ser informativo
+
+// Perfis e somas prefixadas (coluna no plano reduzido)
+#define WATER_MAX_ROWS (COMPARE_PLANE_HEIGHT + 1)
+static float texture_profile[WATER_MAX_ROWS];
+static float intensity_profile[WATER_MAX_ROWS];
+static float prefix_t[WATER_MAX_ROWS], prefix_tt[WATER_MAX_ROWS];
+static float prefix_i[WATER_MAX_ROWS], prefix_ii[WATER_MAX_ROWS];
+
+// Estado da suavização temporal
+static water_level_t state = {0};
+static int64_t last_update_us = 0;
+
+/**
+ * Erro quadrático de um segmento [a, b) ajustado pela média (somas prefixadas)
+ */
+static inline float segment_sse(const float* sum, const float* sum_sq, int a, int b) {
+    float n = (float)(b - a);
+    float s = sum[b] - sum[a];
+    float sse = (sum_sq[b] - sum_sq[a]) - (s * s) / n;
+    return sse > 0.0f ? sse : 0.0f;
+}
+
+esp_err_t water_level_update(const luma_plane_t* plane, water_level_t* level) {
+    if (!plane || !plane->pixels || !level) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Coluna configurada em coordenadas HVGA, convertida para o plano reduzido
+    int x0 = (WATER_COLUMN_X - WATER_COLUMN_WIDTH / 2) >> COMPARE_SCALE_SHIFT;
+    int x1 = (WATER_COLUMN_X + WATER_COLUMN_WIDTH / 2) >> COMPARE_SCALE_SHIFT;
+    int y0 = WATER_COLUMN_TOP >> COMPARE_SCALE_SHIFT;
+    int y1 = WATER_COLUMN_BOTTOM >> COMPARE_SCALE_SHIFT;
+    if (x0 < 0) x0 = 0;
+    if (x1 > plane->width - 1) x1 = plane->width - 1;
+    if (y1 > plane->height - 1) y1 = plane->height - 1;
+
+    const int rows = y1 - y0;
+    const int cols = x1 - x0;
+    if (y0 < 0 || rows < 2 * WATER_MIN_SEGMENT_ROWS || cols < 2 || rows >= WATER_MAX_ROWS) {
+        ESP_LOGE(TAG, "Coluna de medição fora do plano %ux%u", plane->width, plane->height);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Perfis por linha: gradiente médio (textura) e luminância média
+    for (int r = 0; r < rows; r++) {
+        const uint8_t *row = plane->pixels + (size_t)(y0 + r) * plane->width;
+        const uint8_t *below = row + plane->width;
+        uint32_t grad = 0, sum = 0;
+        for (int x = x0; x < x1; x++) {
+            grad += abs(row[x + 1] - row[x]) + abs(below[x] - row[x]);
+            sum += row[x];
+        }
+        texture_profile[r] = (float)grad / cols;
+        intensity_profile[r] = (float)sum / cols;
+    }
+
+    prefix_t[0] = prefix_tt[0] = prefix_i[0] = prefix_ii[0] = 0.0f;
+    for (int r = 0; r < rows; r++) {
+        prefix_t[r + 1] = prefix_t[r] + texture_profile[r];
+        prefix_tt[r + 1] = prefix_tt[r] + texture_profile[r] * texture_profile[r];
+        prefix_i[r + 1] = prefix_i[r] + intensity_profile[r];
+        prefix_ii[r + 1] = prefix_ii[r] + intensity_profile[r] * intensity_profile[r];
+    }
+
+    float total_t = segment_sse(prefix_t, prefix_tt, 0, rows);
+    float total_i = segment_sse(prefix_i, prefix_ii, 0, rows);
+    bool use_t = total_t > WATER_MIN_PROFILE_VAR * rows;
+    bool use_i = total_i > WATER_MIN_PROFILE_VAR * rows;
+    int profiles = (use_t ? 1 : 0) + (use_i ? 1 : 0);
+
+    float raw_confidence = 0.0f;
+    int best_row = -1;
+
+    if (profiles > 0) {
+        // Ajuste de dois segmentos: erro normalizado pela variância de cada perfil
+        float best_cost = 0.0f;
+        for (int k = WATER_MIN_SEGMENT_ROWS; k <= rows - WATER_MIN_SEGMENT_ROWS; k++) {
+            float cost = 0.0f;
+            if (use_t) {
+                cost += (segment_sse(prefix_t, prefix_tt, 0, k) + segment_sse(prefix_t, prefix_tt, k, rows)) / total_t;
+            }
+            if (use_i) {
+                cost += (segment_sse(prefix_i, prefix_ii, 0, k) + segment_sse(prefix_i, prefix_ii, k, rows)) / total_i;
+            }
+            if (best_row < 0 || cost < best_cost) {
+                best_cost = cost;
+                best_row = k;
+            }
+        }
+
+        // Confiança = fração da variância explicada pelo corte
+        raw_confidence = 1.0f - best_cost / profiles;
+
+        // A lâmina d'água deve ser mais lisa que a margem acima dela
+        float above_t = prefix_t[best_row] / best_row;
+        float below_t = (prefix_t[rows] - prefix_t[best_row]) / (rows - best_row);
+        if (below_t > above_t) {
+            raw_confidence *= 0.5f;
+        }
+        if (raw_confidence < 0.0f) raw_confidence = 0.0f;
+    }
+
+    int64_t now = esp_timer_get_time();
+    level->confidence = raw_confidence;
+    level->line_row = best_row >= 0 ? y0 + best_row : -1;
+    level->raw_percent = best_row >= 0 ? (float)(rows - best_row) / rows * 100.0f : 0.0f;
+
+    // Suavização ponderada pela confiança; medições fracas são descartadas
+    if (best_row >= 0 && raw_confidence >= WATER_LEVEL_MIN_CONFIDENCE) {
+        if (!state.valid) {
+            state.level_percent = level->raw_percent;
+            state.rate_per_hour = 0.0f;
+            state.valid = true;
+        } else {
+            float previous = state.level_percent;
+            state.level_percent += (level->raw_percent - previous) * WATER_LEVEL_SMOOTHING * raw_confidence;
+
+            float hours = (float)(now - last_update_us) / 3600e6f;
+            if (hours > 0.0f) {
+                float rate = (state.level_percent - previous) / hours;
+                state.rate_per_hour += (rate - state.rate_per_hour) * WATER_LEVEL_SMOOTHING;
+            }
+        }
+        last_update_us = now;
+    }
+
+    level->level_percent = state.level_percent;
+    level->rate_per_hour = state.rate_per_hour;
+    level->valid = state.valid;
+
+    ESP_LOGD(TAG, "Linha d'água: linha %d, bruto %.1f%%, suavizado %.1f%%, confiança %.2f",
+             level->line_row, level->raw_percent, level->level_percent, level->confidence);
+    return ESP_OK;
+}
+
+void water_level_reset(void) {
+    memset(&state, 0, sizeof(state));
+    last_update_us = 0;
+    ESP_LOGI(TAG, "Estimativa de nível reiniciada");
+}
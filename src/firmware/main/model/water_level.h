@@ -0,0 +1,53 @@
+/**
+ * @file water_level.h
+ * @brief Estimativa do nível da água em uma coluna de medição configurada
+ *
+ * Este módulo fornece funções para:
+ * - Perfis de textura e intensidade por linha na coluna de medição (plano reduzido)
+ * - Localização da linha d'água por ajuste de dois segmentos
+ * - Suavização temporal ponderada pela confiança e taxa de variação
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef WATER_LEVEL_H
+#define WATER_LEVEL_H
+
+#include "esp_err.h"
+#include "compare.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Nível estimado para um frame
+ */
+typedef struct {
+    float level_percent;    ///< Nível suavizado (0% = base da coluna, 100% = topo)
+    float raw_percent;      ///< Nível medido neste frame, sem suavização
+    float confidence;       ///< Confiança da medição (0.0 a 1.0)
+    float rate_per_hour;    ///< Taxa de variação do nível suavizado (%/h)
+    int line_row;           ///< Linha d'água no plano reduzido
+    bool valid;             ///< Já existe estimativa suavizada
+} water_level_t;
+
+/**
+ * @brief Estima a linha d'água no plano já decodificado para a comparação
+ *
+ * @param plane Plano de luminância do frame atual
+ * @param level Saída: nível, confiança e taxa de variação
+ * @return esp_err_t ESP_OK se bem-sucedido, ESP_ERR_INVALID_SIZE se a coluna não cabe no plano
+ */
+esp_err_t water_level_update(const luma_plane_t* plane, water_level_t* level);
+
+/**
+ * @brief Descarta o histórico de suavização
+ */
+void water_level_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WATER_LEVEL_H
@@ -0,0 +1,158 @@
+/**
+ * @file weather.c
+ * @brief Implementação da estimativa de tempo
+ *
+ * Neblina e chuva aproximam todos os pixels da luz atmosférica: o canal
+ * escuro (menor componente RGB do bloco) sobe em relação à luminância, o
+ * contraste cai e os blocos perdem bordas. Céu encoberto mantém a nitidez,
+ * mas reduz saturação e contraste.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "weather.h"
+#include "config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "WEATHER";
+
+static weather_condition_t confirmed = WEATHER_UNKNOWN;
+static weather_condition_t candidate = WEATHER_UNKNOWN;
+static int candidate_streak = 0;
+
+/**
+ * Classe do frame a partir das estatísticas
+ */
+static weather_condition_t classify(const weather_status_t* s, float mean_luma, bool has_color,
+                                    light_period_t light) {
+    if (light == LIGHT_NIGHT || (light == LIGHT_UNKNOWN && mean_luma < WEATHER_NIGHT_LUMA)) {
+        return WEATHER_NIGHT;
+    }
+    if (s->sharp_fraction < WEATHER_FOG_SHARP ||
+        (has_color && s->haze >= WEATHER_FOG_HAZE && s->contrast < WEATHER_FOG_CONTRAST)) {
+        return WEATHER_RAIN_FOG;
+    }
+    if ((has_color && s->saturation < WEATHER_OVERCAST_SATURATION) ||
+        s->contrast < WEATHER_OVERCAST_CONTRAST) {
+        return WEATHER_OVERCAST;
+    }
+    return WEATHER_CLEAR;
+}
+
+esp_err_t weather_update(luma_plane_t* plane, light_period_t light, weather_status_t* status) {
+    if (!plane || !plane->pixels || !status) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t start = esp_timer_get_time();
+    memset(status, 0, sizeof(weather_status_t));
+
+    // Contraste global sobre pixels amostrados
+    uint32_t sum = 0, n = 0;
+    uint64_t sum_sq = 0;
+    for (int y = 0; y < plane->height; y += WEATHER_SAMPLE_STEP) {
+        const uint8_t *row = plane->pixels + (size_t)y * plane->width;
+        for (int x = 0; x < plane->width; x += WEATHER_SAMPLE_STEP) {
+            sum += row[x];
+            sum_sq += (uint32_t)row[x] * row[x];
+            n++;
+        }
+    }
+    float mean = n > 0 ? (float)sum / n : 0.0f;
+    float variance = n > 0 ? (float)sum_sq / n - mean * mean : 0.0f;
+    status->contrast = variance > 0.0f ? sqrtf(variance) : 0.0f;
+
+    // Canal escuro e saturação por bloco (mesmo decode RGB565)
+    static uint8_t dark[COMPARE_MAX_BLOCKS], saturation[COMPARE_MAX_BLOCKS];
+    int blocks = compare_block_color(plane, dark, saturation, COMPARE_MAX_BLOCKS, WEATHER_SAMPLE_STEP);
+    if (blocks > 0) {
+        uint32_t dark_sum = 0, sat_sum = 0;
+        for (int i = 0; i < blocks; i++) {
+            dark_sum += dark[i];
+            sat_sum += saturation[i];
+        }
+        float haze = ((float)dark_sum / blocks) / fmaxf(mean, 1.0f);
+        status->haze = haze > 1.0f ? 1.0f : haze;
+        status->saturation = (float)sat_sum / blocks / 255.0f;
+    }
+
+    // Distribuição de nitidez: fração de blocos nítidos e mediana das bordas
+    if (compare_edge_density(plane) == ESP_OK) {
+        uint16_t histogram[256] = {0};
+        int edge_blocks = (plane->width / COMPARE_BLOCK_SIZE) * (plane->height / COMPARE_BLOCK_SIZE);
+        int sharp = 0;
+        for (int i = 0; i < edge_blocks; i++) {
+            histogram[plane->edge_density[i]]++;
+            if (plane->edge_density[i] >= WEATHER_SHARP_EDGE) {
+                sharp++;
+            }
+        }
+        int seen = 0;
+        for (int v = 0; v < 256; v++) {
+            seen += histogram[v];
+            if (seen * 2 >= edge_blocks) {
+                status->edge_median = (uint8_t)v;
+                break;
+            }
+        }
+        status->sharp_fraction = edge_blocks > 0 ? (float)sharp / edge_blocks : 0.0f;
+    } else {
+        // Sem bordas não há como distinguir neblina de cena lisa
+        status->sharp_fraction = 1.0f;
+    }
+
+    status->raw = classify(status, mean, blocks > 0, light);
+
+    // Primeiro frame define a condição; depois exige capturas consecutivas
+    if (confirmed == WEATHER_UNKNOWN) {
+        confirmed = status->raw;
+        candidate_streak = 0;
+        ESP_LOGI(TAG, "🌦️ Condição inicial: %s", weather_condition_name(confirmed));
+    } else if (status->raw != confirmed) {
+        if (status->raw == candidate) {
+            candidate_streak++;
+        } else {
+            candidate = status->raw;
+            candidate_streak = 1;
+        }
+        if (candidate_streak >= WEATHER_CONFIRM_CAPTURES) {
+            ESP_LOGI(TAG, "🌦️ Condição: %s -> %s (contraste %.1f, véu %.2f, saturação %.2f, nítidos %.0f%%)",
+                     weather_condition_name(confirmed), weather_condition_name(status->raw),
+                     status->contrast, status->haze, status->saturation, status->sharp_fraction * 100.0f);
+            confirmed = status->raw;
+            candidate_streak = 0;
+            status->changed = true;
+        }
+    } else {
+        candidate_streak = 0;
+    }
+
+    status->condition = confirmed;
+    status->compute_us = (uint32_t)(esp_timer_get_time() - start);
+    return ESP_OK;
+}
+
+weather_condition_t weather_current(void) {
+    return confirmed;
+}
+
+float weather_threshold_scale(weather_condition_t condition) {
+    switch (condition) {
+        case WEATHER_RAIN_FOG: return WEATHER_RAIN_FOG_SCALE;
+        case WEATHER_NIGHT: return WEATHER_NIGHT_SCALE;
+        default: return 1.0f;
+    }
+}
+
+const char* weather_condition_name(weather_condition_t condition) {
+    switch (condition) {
+        case WEATHER_CLEAR: return "clear";
+        case WEATHER_OVERCAST: return "overcast";
+        case WEATHER_RAIN_FOG: return "rain_fog";
+        case WEATHER_NIGHT: return "night";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file weather.h
+ * @brief Estimativa de tempo (céu limpo, encoberto, chuva/neblina, noite)
+ *
+ * Este módulo fornece funções para:
+ * - Contraste global, canal escuro (véu de neblina), saturação e
+ *   distribuição de nitidez a partir da decodificação já feita para a
+ *   comparação (plano reduzido e buffer RGB565)
+ * - Classificação com confirmação por capturas consecutivas
+ * - Fator de escala dos limiares de mudança por condição
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef WEATHER_H
+#define WEATHER_H
+
+#include "esp_err.h"
+#include "compare.h"
+#include "light_level.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Condição estimada da cena
+ */
+typedef enum {
+    WEATHER_UNKNOWN = 0,
+    WEATHER_CLEAR,
+    WEATHER_OVERCAST,
+    WEATHER_RAIN_FOG,
+    WEATHER_NIGHT,
+} weather_condition_t;
+
+/**
+ * @brief Estatísticas e classificação de um frame
+ */
+typedef struct {
+    weather_condition_t condition;  ///< Condição confirmada
+    weather_condition_t raw;        ///< Classificação só deste frame
+    float contrast;                 ///< Desvio padrão da luminância (0-128)
+    float haze;                     ///< Canal escuro médio / luminância média (0-1, alto = véu)
+    float saturation;               ///< Saturação média (0-1)
+    float sharp_fraction;           ///< Fração de blocos com densidade de bordas >= WEATHER_SHARP_EDGE
+    uint8_t edge_median;            ///< Mediana da densidade de bordas por bloco (0-255)
+    uint32_t compute_us;            ///< Custo da estimativa
+    bool changed;                   ///< Condição confirmada mudou neste frame
+} weather_status_t;
+
+/**
+ * Estima a condição do frame recém-decodificado
+ *
+ * O plano deve vir de compare_decode_luma() (reaproveita o buffer RGB565
+ * da decodificação). Sem cor disponível, haze e saturação ficam em 0 e
+ * só contraste e nitidez são usados.
+ *
+ * @param plane Plano de luminância reduzido (bordas ficam em cache no plano)
+ * @param light Período de iluminação medido (LIGHT_UNKNOWN = usar luminância)
+ * @param status Saída
+ * @return ESP_OK se bem-sucedido
+ */
+esp_err_t weather_update(luma_plane_t* plane, light_period_t light, weather_status_t* status);
+
+/**
+ * Condição confirmada atual
+ */
+weather_condition_t weather_current(void);
+
+/**
+ * Multiplicador dos limiares de mudança/alerta para a condição
+ */
+float weather_threshold_scale(weather_condition_t condition);
+
+/**
+ * Nome da condição ("clear", "overcast", "rain_fog", "night", "unknown")
+ */
+const char* weather_condition_name(weather_condition_t condition);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEATHER_H
@@ -0,0 +1,137 @@
+/**
+ * @file bench_compare.c
+ * @brief Benchmark no host da comparação em lote (model/compare.c)
+ *
+ * Mede, para cada engine, o custo de compare_luma_batch() com N = 1..
+ * COMPARE_MAX_BATCH referências contra N chamadas separadas com uma
+ * referência cada, e o custo do SSIM relativo ao SAD. Os planos são
+ * sintéticos (textura + ruído), no tamanho do plano de comparação; a
+ * decodificação JPEG não entra na medida (no dispositivo ela é feita uma
+ * vez por captura em qualquer dos casos).
+ *
+ * Os tempos absolutos são do PC; as razões (lote/separado, SSIM/SAD)
+ * indicam a tendência no ESP32, que não tem a vetorização do x86.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "compare.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_REPEAT    1000    // Execuções por medida (vale a mais rápida: menos ruído do PC)
+
+static uint32_t rng_state = 12345;
+
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static void fill_scene(luma_plane_t* plane, int noise, int changed_blocks) {
+    plane->width = COMPARE_PLANE_WIDTH;
+    plane->height = COMPARE_PLANE_HEIGHT;
+    plane->gain_x16 = 16;
+    plane->edges_valid = false;
+    for (int y = 0; y < plane->height; y++) {
+        for (int x = 0; x < plane->width; x++) {
+            int value = 60 + (x * 120) / plane->width + ((x / 8 + y / 8) % 2) * 30;
+            if (noise) {
+                value += (int)(next_random() % (2 * noise + 1)) - noise;
+            }
+            plane->pixels[(size_t)y * plane->width + x] = (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+        }
+    }
+    // Blocos alterados (objeto) para que nem todo bloco seja igual
+    for (int b = 0; b < changed_blocks; b++) {
+        int bx = (int)(next_random() % COMPARE_BLOCKS_X) * COMPARE_BLOCK_SIZE;
+        int by = (int)(next_random() % COMPARE_BLOCKS_Y) * COMPARE_BLOCK_SIZE;
+        for (int y = 0; y < COMPARE_BLOCK_SIZE; y++) {
+            memset(plane->pixels + (size_t)(by + y) * plane->width + bx, 220, COMPARE_BLOCK_SIZE);
+        }
+    }
+}
+
+static int64_t fastest_us(const int64_t* samples, int count) {
+    int64_t best = samples[0];
+    for (int i = 1; i < count; i++) {
+        if (samples[i] < best) best = samples[i];
+    }
+    return best;
+}
+
+// Tempo de uma comparação em lote com n referências (bordas do plano atual recalculadas, como a cada captura)
+static double measure_batch(luma_plane_t* current, luma_plane_t* const refs[], int n) {
+    static int64_t samples[BENCH_REPEAT];
+    float scores[COMPARE_MAX_BATCH];
+    int best;
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        current->edges_valid = false;
+        int64_t t0 = esp_timer_get_time();
+        compare_luma_batch(current, refs, n, scores, &best);
+        samples[i] = esp_timer_get_time() - t0;
+    }
+    return (double)fastest_us(samples, BENCH_REPEAT);
+}
+
+static double measure_separate(luma_plane_t* current, luma_plane_t* const refs[], int n) {
+    static int64_t samples[BENCH_REPEAT];
+    float score;
+    int best;
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        int64_t t0 = esp_timer_get_time();
+        for (int r = 0; r < n; r++) {
+            current->edges_valid = false;
+            compare_luma_batch(current, &refs[r], 1, &score, &best);
+        }
+        samples[i] = esp_timer_get_time() - t0;
+    }
+    return (double)fastest_us(samples, BENCH_REPEAT);
+}
+
+int main(void) {
+    static uint8_t current_pixels[COMPARE_PLANE_WIDTH * COMPARE_PLANE_HEIGHT];
+    static uint8_t ref_pixels[COMPARE_MAX_BATCH][COMPARE_PLANE_WIDTH * COMPARE_PLANE_HEIGHT];
+    static luma_plane_t current;
+    static luma_plane_t refs_storage[COMPARE_MAX_BATCH];
+    luma_plane_t* refs[COMPARE_MAX_BATCH];
+
+    current.pixels = current_pixels;
+    fill_scene(&current, 4, 6);
+    for (int r = 0; r < COMPARE_MAX_BATCH; r++) {
+        refs_storage[r].pixels = ref_pixels[r];
+        fill_scene(&refs_storage[r], 4, r);
+        refs[r] = &refs_storage[r];
+    }
+
+    double batch_us[COMPARE_ENGINE_GRADIENT + 1][COMPARE_MAX_BATCH + 1];
+    printf("Plano %dx%d, blocos %dx%d, melhor de %d execuções\n\n",
+           COMPARE_PLANE_WIDTH, COMPARE_PLANE_HEIGHT, COMPARE_BLOCK_SIZE, COMPARE_BLOCK_SIZE, BENCH_REPEAT);
+    printf("| Engine | N | Lote (us) | Separado (us) | Lote/separado |\n");
+    printf("|--------|---|-----------|---------------|---------------|\n");
+    for (int engine = COMPARE_ENGINE_SAD; engine <= COMPARE_ENGINE_GRADIENT; engine++) {
+        compare_set_engine((compare_engine_t)engine);
+        for (int n = 1; n <= COMPARE_MAX_BATCH; n++) {
+            // Bordas das referências em cache, como no banco
+            for (int r = 0; r < COMPARE_MAX_BATCH; r++) {
+                refs_storage[r].edges_valid = false;
+            }
+            double batch = measure_batch(&current, refs, n);
+            double separate = measure_separate(&current, refs, n);
+            batch_us[engine][n] = batch;
+            printf("| %s | %d | %.0f | %.0f | %.2f |\n", compare_engine_name((compare_engine_t)engine),
+                   n, batch, separate, separate > 0 ? batch / separate : 0.0);
+        }
+    }
+
+    printf("\n| N | SSIM/SAD | Gradiente/SAD |\n");
+    printf("|---|----------|---------------|\n");
+    for (int n = 1; n <= COMPARE_MAX_BATCH; n++) {
+        double sad = batch_us[COMPARE_ENGINE_SAD][n];
+        printf("| %d | %.2f | %.2f |\n", n,
+               sad > 0 ? batch_us[COMPARE_ENGINE_SSIM][n] / sad : 0.0,
+               sad > 0 ? batch_us[COMPARE_ENGINE_GRADIENT][n] / sad : 0.0);
+    }
+    return 0;
+}
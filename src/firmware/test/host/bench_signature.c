@@ -0,0 +1,126 @@
+/**
+ * @file bench_signature.c
+ * @brief Benchmark no host das assinaturas por captura (model/frame_signature.c)
+ *
+ * Mede o custo de frame_signature_compute() sobre o plano de comparação
+ * e de frame_signature_compare_ago() com o anel cheio
+ * (FRAME_SIGNATURE_CAPACITY entradas, uma a cada CAPTURE_INTERVAL_MS),
+ * para distâncias de 15 s a 24 h no passado. Como as medidas ficam na
+ * casa do microssegundo, cada amostra cronometra um lote de chamadas e o
+ * tempo é dividido pelo tamanho do lote.
+ *
+ * Os tempos absolutos são do PC; no ESP32 a consulta paga ainda o acesso
+ * à PSRAM, mas continua sendo uma busca binária e 150 bytes comparados.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "frame_signature.h"
+#include "config.h"
+#include "esp_timer.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_REPEAT    200     // Amostras por medida (vale a mais rápida: menos ruído do PC)
+#define BENCH_BATCH     100     // Chamadas cronometradas juntas em cada amostra
+#define CAPTURE_STEP_S  (CAPTURE_INTERVAL_MS / 1000)
+
+static uint32_t rng_state = 12345;
+
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static void fill_plane(luma_plane_t* plane) {
+    plane->width = COMPARE_PLANE_WIDTH;
+    plane->height = COMPARE_PLANE_HEIGHT;
+    plane->gain_x16 = 16;
+    plane->edges_valid = false;
+    for (int y = 0; y < plane->height; y++) {
+        for (int x = 0; x < plane->width; x++) {
+            int value = 60 + (x * 120) / plane->width + (int)(next_random() % 9) - 4;
+            plane->pixels[(size_t)y * plane->width + x] = (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+        }
+    }
+}
+
+static int64_t fastest_us(const int64_t* samples, int count) {
+    int64_t best = samples[0];
+    for (int i = 1; i < count; i++) {
+        if (samples[i] < best) best = samples[i];
+    }
+    return best;
+}
+
+int main(void) {
+    static uint8_t pixels[COMPARE_PLANE_WIDTH * COMPARE_PLANE_HEIGHT];
+    static int64_t samples[BENCH_REPEAT];
+    static luma_plane_t plane;
+    static frame_signature_t sig;
+    plane.pixels = pixels;
+
+    if (frame_signature_init() != ESP_OK) {
+        fprintf(stderr, "bench_signature: falha ao alocar o anel\n");
+        return 1;
+    }
+
+    fill_plane(&plane);
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        int64_t t0 = esp_timer_get_time();
+        for (int b = 0; b < BENCH_BATCH; b++) {
+            frame_signature_compute(&plane, &sig);
+        }
+        samples[i] = esp_timer_get_time() - t0;
+    }
+    double compute_us = (double)fastest_us(samples, BENCH_REPEAT) / BENCH_BATCH;
+
+    // Anel cheio: 24 h de capturas com a cena variando devagar
+    for (int i = 0; i < FRAME_SIGNATURE_CAPACITY; i++) {
+        for (int b = 0; b < COMPARE_MAX_BLOCKS; b++) {
+            sig.luma[b] = (uint8_t)(60 + (b * 7 + i / 40) % 120);
+        }
+        sig.mean_luma = sig.luma[0];
+        sig.time_s = (uint32_t)(i + 1) * CAPTURE_STEP_S;
+        frame_signature_push(&sig);
+    }
+
+    // Assinatura atual: uma captura depois da última do anel
+    frame_signature_compute(&plane, &sig);
+    sig.time_s = (uint32_t)(FRAME_SIGNATURE_CAPACITY + 1) * CAPTURE_STEP_S;
+
+    static const uint32_t ages_s[] = { CAPTURE_STEP_S, 3600, 6 * 3600, 12 * 3600, 24 * 3600 };
+    const int age_count = (int)(sizeof(ages_s) / sizeof(ages_s[0]));
+
+    printf("Plano %dx%d, %d blocos por assinatura, anel de %d entradas (%u KB), melhor de %d lotes de %d\n\n",
+           COMPARE_PLANE_WIDTH, COMPARE_PLANE_HEIGHT, COMPARE_MAX_BLOCKS, frame_signature_count(),
+           (unsigned)(frame_signature_memory() / 1024), BENCH_REPEAT, BENCH_BATCH);
+    printf("| Operação | Tempo (us) |\n");
+    printf("|----------|------------|\n");
+    printf("| frame_signature_compute | %.2f |\n", compute_us);
+
+    int failures = 0;
+    for (int a = 0; a < age_count; a++) {
+        signature_match_t match;
+        for (int i = 0; i < BENCH_REPEAT; i++) {
+            int64_t t0 = esp_timer_get_time();
+            for (int b = 0; b < BENCH_BATCH; b++) {
+                frame_signature_compare_ago(&sig, ages_s[a], &match);
+            }
+            samples[i] = esp_timer_get_time() - t0;
+        }
+        double query_us = (double)fastest_us(samples, BENCH_REPEAT) / BENCH_BATCH;
+        if (!match.found) {
+            failures++;
+        }
+        printf("| frame_signature_compare_ago (%" PRIu32 " s, idade %" PRIu32 " s) | %.2f |\n",
+               ages_s[a], match.age_s, query_us);
+    }
+
+    if (failures > 0) {
+        fprintf(stderr, "bench_signature: %d consulta(s) sem assinatura no anel\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file bench_weather.c
+ * @brief Benchmark no host da estimativa de tempo (model/weather.c)
+ *
+ * Mede o custo por frame de weather_update() e das duas etapas que ele
+ * reaproveita da comparação: compare_edge_density() (Sobel por bloco) e
+ * compare_block_color() (canal escuro e saturação sobre o buffer RGB565).
+ * O frame sintético é decodificado uma vez por compare_decode_luma(),
+ * como na captura; a decodificação aparece na tabela só como referência.
+ *
+ * Os tempos absolutos são do PC; no ESP32 vale a proporção entre as
+ * etapas e em relação à decodificação.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "weather.h"
+#include "config.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_REPEAT    1000    // Execuções por medida (vale a mais rápida: menos ruído do PC)
+
+static uint32_t rng_state = 12345;
+
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static int clamp_channel(int value, int max) {
+    return value < 0 ? 0 : value > max ? max : value;
+}
+
+// Cena colorida: céu em gradiente, textura quadriculada e ruído (RGB565 big-endian, como o stub do decoder)
+static void fill_frame(uint8_t* frame) {
+    for (int y = 0; y < IMAGE_HEIGHT; y++) {
+        for (int x = 0; x < IMAGE_WIDTH; x++) {
+            int texture = ((x / 8 + y / 8) % 2) * 6;
+            int noise = (int)(next_random() % 5) - 2;
+            int r = clamp_channel(8 + (x * 12) / IMAGE_WIDTH + texture / 2 + noise, 31);
+            int g = clamp_channel(20 + (y * 24) / IMAGE_HEIGHT + texture + noise, 63);
+            int b = clamp_channel(24 - (y * 10) / IMAGE_HEIGHT + texture / 2 + noise, 31);
+            uint16_t pixel = (uint16_t)((r << 11) | (g << 5) | b);
+            uint8_t* out = frame + ((size_t)y * IMAGE_WIDTH + x) * 2;
+            out[0] = (uint8_t)(pixel >> 8);
+            out[1] = (uint8_t)(pixel & 0xFF);
+        }
+    }
+}
+
+static int64_t fastest_us(const int64_t* samples, int count) {
+    int64_t best = samples[0];
+    for (int i = 1; i < count; i++) {
+        if (samples[i] < best) best = samples[i];
+    }
+    return best;
+}
+
+int main(void) {
+    static uint8_t frame[IMAGE_WIDTH * IMAGE_HEIGHT * 2];
+    static int64_t samples[BENCH_REPEAT];
+    static luma_plane_t plane;
+    static uint8_t dark[COMPARE_MAX_BLOCKS], saturation[COMPARE_MAX_BLOCKS];
+
+    fill_frame(frame);
+    camera_fb_t fb = { .buf = frame, .len = sizeof(frame), .width = IMAGE_WIDTH,
+                       .height = IMAGE_HEIGHT, .format = PIXFORMAT_JPEG };
+
+    // Decodificação (referência): o buffer RGB565 fica pronto para as etapas seguintes
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        int64_t t0 = esp_timer_get_time();
+        compare_decode_luma(&fb, &plane);
+        samples[i] = esp_timer_get_time() - t0;
+    }
+    double decode_us = (double)fastest_us(samples, BENCH_REPEAT);
+    plane.gain_x16 = 16;
+
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        plane.edges_valid = false;
+        int64_t t0 = esp_timer_get_time();
+        compare_edge_density(&plane);
+        samples[i] = esp_timer_get_time() - t0;
+    }
+    double edges_us = (double)fastest_us(samples, BENCH_REPEAT);
+
+    int blocks = 0;
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        int64_t t0 = esp_timer_get_time();
+        blocks = compare_block_color(&plane, dark, saturation, COMPARE_MAX_BLOCKS, WEATHER_SAMPLE_STEP);
+        samples[i] = esp_timer_get_time() - t0;
+    }
+    double color_us = (double)fastest_us(samples, BENCH_REPEAT);
+
+    // Frame completo: bordas recalculadas, como a cada captura
+    weather_status_t status;
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        plane.edges_valid = false;
+        int64_t t0 = esp_timer_get_time();
+        weather_update(&plane, LIGHT_DAY, &status);
+        samples[i] = esp_timer_get_time() - t0;
+    }
+    double weather_us = (double)fastest_us(samples, BENCH_REPEAT);
+
+    compare_free_buffers();
+    compare_free_luma(&plane);
+
+    printf("Plano %dx%d, blocos %dx%d, amostragem de cor a cada %d px, melhor de %d execuções\n\n",
+           COMPARE_PLANE_WIDTH, COMPARE_PLANE_HEIGHT, COMPARE_BLOCK_SIZE, COMPARE_BLOCK_SIZE,
+           WEATHER_SAMPLE_STEP, BENCH_REPEAT);
+    printf("| Etapa | Tempo (us) | Relativo à decodificação |\n");
+    printf("|-------|------------|--------------------------|\n");
+    printf("| compare_decode_luma (referência) | %.0f | 1.00 |\n", decode_us);
+    printf("| compare_edge_density | %.0f | %.2f |\n", edges_us, decode_us > 0 ? edges_us / decode_us : 0.0);
+    printf("| compare_block_color (%d blocos) | %.0f | %.2f |\n", blocks, color_us,
+           decode_us > 0 ? color_us / decode_us : 0.0);
+    printf("| weather_update (total, Sobel incluído) | %.0f | %.2f |\n", weather_us,
+           decode_us > 0 ? weather_us / decode_us : 0.0);
+    printf("\nCondição estimada: %s (contraste %.1f, véu %.2f, saturação %.2f, nítidos %.0f%%)\n",
+           weather_condition_name(status.raw), status.contrast, status.haze, status.saturation,
+           status.sharp_fraction * 100.0f);
+    return 0;
+}
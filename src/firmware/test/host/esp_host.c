@@ -0,0 +1,221 @@
+/**
+ * @file esp_host.c
+ * @brief Heap, relógio, NVS e filas do FreeRTOS sobre a libc/pthreads para os testes no host
+ *
+ * As filas copiam os itens como as do FreeRTOS e respeitam o tempo de
+ * espera (1 tick = 1 ms; portMAX_DELAY espera indefinidamente). O NVS
+ * está sempre vazio. Não há decodificador JPEG: o "JPEG" dos testes é o
+ * RGB565 cru do frame inteiro, reduzido pela média na escala pedida.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "config.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "img_converters.h"
+#include "nvs.h"
+#include "freertos/queue.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    unsigned capacity;
+    unsigned item_size;
+    unsigned head;
+    unsigned count;
+    unsigned char *items;
+} host_queue_t;
+
+void *heap_caps_malloc(size_t size, uint32_t caps) { (void)caps; return malloc(size); }
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) { (void)caps; return calloc(n, size); }
+void heap_caps_free(void *ptr) { free(ptr); }
+size_t heap_caps_get_free_size(uint32_t caps) { (void)caps; return 4u << 20; }
+size_t heap_caps_get_total_size(uint32_t caps) { (void)caps; return 4u << 20; }
+size_t heap_caps_get_largest_free_block(uint32_t caps) { (void)caps; return 4u << 20; }
+size_t heap_caps_get_minimum_free_size(uint32_t caps) { (void)caps; return 4u << 20; }
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        default: return "ESP_ERR";
+    }
+}
+
+int64_t esp_timer_get_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+// "JPEG" do host: RGB565 cru (big-endian) em IMAGE_WIDTH x IMAGE_HEIGHT, reduzido pela média como na escala do decodificador
+bool jpg2rgb565(const uint8_t *src, size_t src_len, uint8_t *out, jpg_scale_t scale) {
+    const int factor = 1 << scale;
+    const int width = IMAGE_WIDTH / factor;
+    const int height = IMAGE_HEIGHT / factor;
+    if (!src || src_len != (size_t)IMAGE_WIDTH * IMAGE_HEIGHT * 2) {
+        return false;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int r = 0, g = 0, b = 0;
+            for (int dy = 0; dy < factor; dy++) {
+                for (int dx = 0; dx < factor; dx++) {
+                    const uint8_t *p = src + ((size_t)(y * factor + dy) * IMAGE_WIDTH + x * factor + dx) * 2;
+                    uint16_t pixel = ((uint16_t)p[0] << 8) | p[1];
+                    r += (pixel >> 11) & 0x1F;
+                    g += (pixel >> 5) & 0x3F;
+                    b += pixel & 0x1F;
+                }
+            }
+            const int n = factor * factor;
+            uint16_t pixel = (uint16_t)(((r + n / 2) / n) << 11 | ((g + n / 2) / n) << 5 | ((b + n / 2) / n));
+            out[((size_t)y * width + x) * 2] = (uint8_t)(pixel >> 8);
+            out[((size_t)y * width + x) * 2 + 1] = (uint8_t)pixel;
+        }
+    }
+    return true;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle) {
+    (void)name; (void)mode;
+    *handle = 1;
+    return ESP_OK;
+}
+void nvs_close(nvs_handle_t handle) { (void)handle; }
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out) {
+    (void)handle; (void)key; (void)out;
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length) {
+    (void)handle; (void)key; (void)out; (void)length;
+    return ESP_ERR_NVS_NOT_FOUND;
+}
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    (void)handle; (void)key; (void)value; (void)length;
+    return ESP_OK;
+}
+esp_err_t nvs_commit(nvs_handle_t handle) { (void)handle; return ESP_OK; }
+
+// Espera pela condição até o prazo; false se o prazo expirou
+static int wait_until(host_queue_t *q, TickType_t wait, const struct timespec *deadline) {
+    if (wait == 0) {
+        return 0;
+    }
+    if (wait == portMAX_DELAY) {
+        pthread_cond_wait(&q->changed, &q->lock);
+        return 1;
+    }
+    return pthread_cond_timedwait(&q->changed, &q->lock, deadline) != ETIMEDOUT;
+}
+
+static void deadline_after(TickType_t wait, struct timespec *deadline) {
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += wait / 1000;
+    deadline->tv_nsec += (long)(wait % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    host_queue_t *q = calloc(1, sizeof(host_queue_t));
+    if (!q) {
+        return NULL;
+    }
+    q->items = malloc((size_t)length * item_size);
+    if (!q->items) {
+        free(q);
+        return NULL;
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->changed, NULL);
+    q->capacity = length;
+    q->item_size = item_size;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    host_queue_t *q = queue;
+    if (!q) return;
+    pthread_cond_destroy(&q->changed);
+    pthread_mutex_destroy(&q->lock);
+    free(q->items);
+    free(q);
+}
+
+static BaseType_t queue_insert(QueueHandle_t queue, const void *item, TickType_t wait, int front) {
+    host_queue_t *q = queue;
+    struct timespec deadline;
+    deadline_after(wait, &deadline);
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->capacity) {
+        if (!wait_until(q, wait, &deadline)) {
+            pthread_mutex_unlock(&q->lock);
+            return pdFALSE;
+        }
+    }
+    unsigned slot;
+    if (front) {
+        q->head = (q->head + q->capacity - 1) % q->capacity;
+        slot = q->head;
+    } else {
+        slot = (q->head + q->count) % q->capacity;
+    }
+    memcpy(q->items + (size_t)slot * q->item_size, item, q->item_size);
+    q->count++;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait) {
+    return queue_insert(queue, item, wait, 0);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t wait) {
+    return queue_insert(queue, item, wait, 1);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait) {
+    host_queue_t *q = queue;
+    struct timespec deadline;
+    deadline_after(wait, &deadline);
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0) {
+        if (!wait_until(q, wait, &deadline)) {
+            pthread_mutex_unlock(&q->lock);
+            return pdFALSE;
+        }
+    }
+    memcpy(item, q->items + (size_t)q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+    pthread_cond_broadcast(&q->changed);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    host_queue_t *q = queue;
+    pthread_mutex_lock(&q->lock);
+    unsigned count = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return count;
+}
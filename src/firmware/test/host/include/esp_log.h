@@ -0,0 +1,12 @@
+/**
+ * @file esp_log.h
+ * @brief Logs do ESP-IDF no host (só erros, na saída de erro)
+ */
+#pragma once
+#include <stdio.h>
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) do { if (0) fprintf(stderr, "%s: " fmt "\n", tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGI(tag, fmt, ...) do { if (0) fprintf(stderr, "%s: " fmt "\n", tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { if (0) fprintf(stderr, "%s: " fmt "\n", tag, ##__VA_ARGS__); } while (0)
+#define ESP_LOGV(tag, fmt, ...) do { if (0) fprintf(stderr, "%s: " fmt "\n", tag, ##__VA_ARGS__); } while (0)
@@ -0,0 +1,8 @@
+/**
+ * @file esp_timer.h
+ * @brief Relógio monotônico do ESP-IDF no host (µs)
+ */
+#pragma once
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,17 @@
+/**
+ * @file img_converters.h
+ * @brief Conversores do esp32-camera no host (o "JPEG" é RGB565 cru do frame inteiro)
+ */
+#pragma once
+#include <stdbool.h>
+#include "esp_camera.h"
+
+typedef enum {
+    JPG_SCALE_NONE,
+    JPG_SCALE_2X,
+    JPG_SCALE_4X,
+    JPG_SCALE_8X,
+    JPG_SCALE_MAX = JPG_SCALE_8X
+} jpg_scale_t;
+
+bool jpg2rgb565(const uint8_t *src, size_t src_len, uint8_t *out, jpg_scale_t scale);
@@ -0,0 +1,18 @@
+/**
+ * @file nvs.h
+ * @brief NVS do ESP-IDF no host (partição vazia, gravações descartadas)
+ */
+#pragma once
+#include "esp_err.h"
+
+#define ESP_ERR_NVS_NOT_FOUND   0x1102
+
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+esp_err_t nvs_commit(nvs_handle_t handle);
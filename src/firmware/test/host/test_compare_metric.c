@@ -0,0 +1,335 @@
+/**
+ * @file test_compare_metric.c
+ * @brief Revalidação no host dos limiares de calculate_image_difference()
+ *
+ * Os limiares (bloco > 60, piso 15, mínimo de 3 blocos, filtro de 3%/8%)
+ * foram calibrados na métrica de blocos 32x32 amostrados a cada 6 pixels
+ * na resolução cheia. O teste reproduz essa métrica sobre cenas sintéticas
+ * 480x320 e exige que calculate_image_difference() cruze CHANGE_THRESHOLD
+ * e ALERT_THRESHOLD exatamente nas mesmas cenas (falha em detecção perdida
+ * ou nova). A coluna do plano reduzido (compare_luma_planes, blocos 16x16
+ * densos em 1/2 escala) mostra o que muda com COMPARE_LEGACY_METRIC = false:
+ * - objetos sólidos alinhados à grade: mesmo percentual
+ * - ruído do sensor: nunca acusa mais que a métrica antiga
+ * - traços finos e textura de 1 px: a média 2x2 apaga
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "compare.h"
+#include "esp_camera.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FULL_WIDTH      IMAGE_WIDTH
+#define FULL_HEIGHT     IMAGE_HEIGHT
+#define LEGACY_BLOCK    32      // Bloco da métrica antiga (resolução cheia)
+#define LEGACY_STEP     6       // Amostragem da métrica antiga
+#define NOISE_TRIALS    20      // Sorteios por nível de ruído
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static uint32_t rng_state = 2025;
+
+static uint32_t next_random(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+// Ruído aproximadamente gaussiano (soma de 4 uniformes), amplitude máxima ±amp
+static int noise_sample(int amp) {
+    if (amp <= 0) return 0;
+    int sum = 0;
+    for (int i = 0; i < 4; i++) {
+        sum += (int)(next_random() % (2 * amp + 1)) - amp;
+    }
+    return sum / 2;
+}
+
+static uint8_t clamp_luma(int value) {
+    return (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+static uint8_t full_a[FULL_WIDTH * FULL_HEIGHT];
+static uint8_t full_b[FULL_WIDTH * FULL_HEIGHT];
+static uint8_t frame_a[FULL_WIDTH * FULL_HEIGHT * 2];
+static uint8_t frame_b[FULL_WIDTH * FULL_HEIGHT * 2];
+
+// Cinza em RGB565 (big-endian) e a luminância que a decodificação devolve dele
+static void gray_to_rgb565(int value, uint8_t* out) {
+    uint16_t pixel = (uint16_t)((value >> 3) << 11 | (value >> 2) << 5 | (value >> 3));
+    out[0] = (uint8_t)(pixel >> 8);
+    out[1] = (uint8_t)pixel;
+}
+
+static int rgb565_to_luma(const uint8_t* px) {
+    uint16_t pixel = ((uint16_t)px[0] << 8) | px[1];
+    int r = (pixel >> 11) & 0x1F, g = (pixel >> 5) & 0x3F, b = pixel & 0x1F;
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+    return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+// Frame "JPEG" do host (RGB565 cru); a cena passa a ter a luminância quantizada que o firmware vê
+static void to_frame(uint8_t* luma, uint8_t* frame) {
+    for (size_t i = 0; i < (size_t)FULL_WIDTH * FULL_HEIGHT; i++) {
+        gray_to_rgb565(luma[i], frame + i * 2);
+        luma[i] = (uint8_t)rgb565_to_luma(frame + i * 2);
+    }
+}
+
+// Fundo com gradiente e textura média (quadriculado de 8 px)
+static void fill_background(uint8_t* img, int noise) {
+    for (int y = 0; y < FULL_HEIGHT; y++) {
+        for (int x = 0; x < FULL_WIDTH; x++) {
+            int value = 60 + (x * 100) / FULL_WIDTH + ((x / 8 + y / 8) % 2) * 30;
+            img[y * FULL_WIDTH + x] = clamp_luma(value + noise_sample(noise));
+        }
+    }
+}
+
+static void fill_rect(uint8_t* img, int x0, int y0, int w, int h, int value) {
+    for (int y = y0; y < y0 + h && y < FULL_HEIGHT; y++) {
+        for (int x = x0; x < x0 + w && x < FULL_WIDTH; x++) {
+            img[y * FULL_WIDTH + x] = (uint8_t)value;
+        }
+    }
+}
+
+/**
+ * Métrica anterior, copiada da versão sem planos em cache: blocos de 32 px
+ * na resolução cheia, um pixel a cada 6 em cada eixo (36 amostras)
+ */
+static int legacy_changed_blocks(const uint8_t* a, const uint8_t* b) {
+    int changed = 0;
+    for (int by = 0; by < FULL_HEIGHT / LEGACY_BLOCK; by++) {
+        for (int bx = 0; bx < FULL_WIDTH / LEGACY_BLOCK; bx++) {
+            int sum = 0, count = 0;
+            for (int y = 0; y < LEGACY_BLOCK; y += LEGACY_STEP) {
+                for (int x = 0; x < LEGACY_BLOCK; x += LEGACY_STEP) {
+                    int idx = (by * LEGACY_BLOCK + y) * FULL_WIDTH + bx * LEGACY_BLOCK + x;
+                    sum += abs(a[idx] - b[idx]);
+                    count++;
+                }
+            }
+            int avg = sum / count;
+            if (avg <= 15) avg = 0;
+            if (avg > 60) changed++;
+        }
+    }
+    return changed;
+}
+
+static float legacy_difference(const uint8_t* a, const uint8_t* b) {
+    const int total = (FULL_WIDTH / LEGACY_BLOCK) * (FULL_HEIGHT / LEGACY_BLOCK);
+    int changed = legacy_changed_blocks(a, b);
+    if (changed < 3) return 0.0f;
+    float pct = (float)changed / (float)total * 100.0f;
+    if (pct < 3.0f) return 0.0f;
+    if (pct < 8.0f) pct *= 0.8f;
+    return pct;
+}
+
+// Redução 2x2 pela média, como a decodificação JPEG em 1/2 escala
+static void downscale(const uint8_t* full, luma_plane_t* plane) {
+    for (int y = 0; y < plane->height; y++) {
+        for (int x = 0; x < plane->width; x++) {
+            const uint8_t* p = full + (2 * y) * FULL_WIDTH + 2 * x;
+            plane->pixels[y * plane->width + x] = (uint8_t)((p[0] + p[1] + p[FULL_WIDTH] + p[FULL_WIDTH + 1] + 2) / 4);
+        }
+    }
+    plane->edges_valid = false;
+}
+
+static float current_difference(const uint8_t* a, const uint8_t* b, compare_result_t* result) {
+    static uint8_t pixels_a[COMPARE_PLANE_WIDTH * COMPARE_PLANE_HEIGHT];
+    static uint8_t pixels_b[COMPARE_PLANE_WIDTH * COMPARE_PLANE_HEIGHT];
+    luma_plane_t ref = { .pixels = pixels_a, .width = COMPARE_PLANE_WIDTH, .height = COMPARE_PLANE_HEIGHT, .gain_x16 = 16 };
+    luma_plane_t cur = { .pixels = pixels_b, .width = COMPARE_PLANE_WIDTH, .height = COMPARE_PLANE_HEIGHT, .gain_x16 = 16 };
+    downscale(a, &ref);
+    downscale(b, &cur);
+    CHECK(compare_luma_planes_ex(&ref, &cur, result) == ESP_OK);
+    return result->difference;
+}
+
+// calculate_image_difference() sobre os dois frames (quantiza as cenas)
+static float function_difference(void) {
+    to_frame(full_a, frame_a);
+    to_frame(full_b, frame_b);
+    camera_fb_t fb_a = { .buf = frame_a, .len = sizeof(frame_a), .width = FULL_WIDTH, .height = FULL_HEIGHT, .format = PIXFORMAT_JPEG };
+    camera_fb_t fb_b = { .buf = frame_b, .len = sizeof(frame_b), .width = FULL_WIDTH, .height = FULL_HEIGHT, .format = PIXFORMAT_JPEG };
+    return calculate_image_difference(&fb_a, &fb_b);
+}
+
+// Mesma decisão que a métrica de calibração: sem detecção perdida nem nova
+static void check_crossings(float legacy, float function) {
+    CHECK((legacy >= CHANGE_THRESHOLD) == (function >= CHANGE_THRESHOLD));
+    CHECK((legacy >= ALERT_THRESHOLD) == (function >= ALERT_THRESHOLD));
+}
+
+static void report(const char* scene, float legacy, float function, float plane) {
+    printf("| %s | %.1f | %.1f | %.1f |\n", scene, legacy, function, plane);
+}
+
+// Mesma grade nas duas métricas: 15x10 blocos cobrindo 32x32 pixels da imagem cheia
+static void test_block_grid(void) {
+    CHECK(COMPARE_BLOCK_SIZE << COMPARE_SCALE_SHIFT == LEGACY_BLOCK);
+    CHECK(COMPARE_MAX_BLOCKS == (FULL_WIDTH / LEGACY_BLOCK) * (FULL_HEIGHT / LEGACY_BLOCK));
+}
+
+// Só ruído: a média densa do plano reduzido nunca passa da métrica antiga
+static void test_sensor_noise(void) {
+    static const int levels[] = { 20, 60, 90, 120 };
+    compare_result_t result;
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        float worst_legacy = 0.0f, worst_function = 0.0f, worst_current = 0.0f;
+        int legacy_blocks = 0, current_blocks = 0;
+        for (int t = 0; t < NOISE_TRIALS; t++) {
+            fill_background(full_a, levels[l]);
+            fill_background(full_b, levels[l]);
+            float function = function_difference();
+            float legacy = legacy_difference(full_a, full_b);
+            check_crossings(legacy, function);
+            float current = current_difference(full_a, full_b, &result);
+            legacy_blocks += legacy_changed_blocks(full_a, full_b);
+            current_blocks += result.changed_blocks;
+            if (legacy > worst_legacy) worst_legacy = legacy;
+            if (function > worst_function) worst_function = function;
+            if (current > worst_current) worst_current = current;
+        }
+        char scene[64];
+        snprintf(scene, sizeof(scene), "ruído ±%d (pior de %d)", levels[l], NOISE_TRIALS);
+        report(scene, worst_legacy, worst_function, worst_current);
+        CHECK(current_blocks <= legacy_blocks);
+        CHECK(worst_current <= worst_legacy);
+    }
+}
+
+// Objeto sólido alinhado à grade: o mesmo número de blocos nas duas métricas
+static void test_aligned_objects(void) {
+    static const struct { int bw, bh; } sizes[] = { {2, 2}, {3, 3}, {5, 4}, {8, 6} };
+    compare_result_t result;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        fill_background(full_a, 10);
+        memcpy(full_b, full_a, sizeof(full_b));
+        fill_rect(full_b, 3 * LEGACY_BLOCK, 2 * LEGACY_BLOCK, sizes[s].bw * LEGACY_BLOCK, sizes[s].bh * LEGACY_BLOCK, 240);
+        float function = function_difference();
+        float legacy = legacy_difference(full_a, full_b);
+        check_crossings(legacy, function);
+        float current = current_difference(full_a, full_b, &result);
+        char scene[64];
+        snprintf(scene, sizeof(scene), "objeto %dx%d blocos alinhado", sizes[s].bw, sizes[s].bh);
+        report(scene, legacy, function, current);
+        CHECK(result.changed_blocks == legacy_changed_blocks(full_a, full_b));
+        CHECK(current == legacy);
+    }
+}
+
+// Objeto deslocado meio bloco: a amostragem antiga e a média densa divergem só nas bordas
+static void test_offset_objects(void) {
+    compare_result_t result;
+    for (int size = 2; size <= 8; size += 2) {
+        fill_background(full_a, 10);
+        memcpy(full_b, full_a, sizeof(full_b));
+        fill_rect(full_b, 3 * LEGACY_BLOCK + 16, 2 * LEGACY_BLOCK + 16, size * LEGACY_BLOCK, size * LEGACY_BLOCK, 240);
+        float function = function_difference();
+        int legacy_blocks = legacy_changed_blocks(full_a, full_b);
+        float legacy = legacy_difference(full_a, full_b);
+        check_crossings(legacy, function);
+        float current = current_difference(full_a, full_b, &result);
+        char scene[64];
+        snprintf(scene, sizeof(scene), "objeto %dx%d blocos deslocado 16 px", size, size);
+        report(scene, legacy, function, current);
+        // Só os blocos da borda (metade coberta) podem mudar de lado do limiar
+        CHECK(abs(result.changed_blocks - legacy_blocks) <= 4 * size + 4);
+        CHECK((legacy >= CHANGE_THRESHOLD) == (current >= CHANGE_THRESHOLD) || size <= 2);
+    }
+}
+
+// Traços finos (chuva, fios): a métrica calibrada os acusa; o plano reduzido mede só a área coberta
+static void test_thin_lines(void) {
+    compare_result_t result;
+    for (int phase = 0; phase < LEGACY_STEP; phase += 3) {
+        fill_background(full_a, 10);
+        memcpy(full_b, full_a, sizeof(full_b));
+        for (int x = phase; x < FULL_WIDTH; x += 12) {
+            fill_rect(full_b, x, 0, 2, FULL_HEIGHT, 250);
+        }
+        float function = function_difference();
+        float legacy = legacy_difference(full_a, full_b);
+        check_crossings(legacy, function);
+        float current = current_difference(full_a, full_b, &result);
+        char scene[64];
+        snprintf(scene, sizeof(scene), "traços de 2 px a cada 12 (fase %d)", phase);
+        report(scene, legacy, function, current);
+    }
+}
+
+// Textura fina que muda de fase (folhagem, água): acusada na resolução cheia, some na redução 2x2
+static void test_fine_texture(void) {
+    compare_result_t result;
+    fill_background(full_a, 0);
+    memcpy(full_b, full_a, sizeof(full_b));
+    for (int y = 0; y < FULL_HEIGHT; y++) {
+        for (int x = 0; x < FULL_WIDTH; x++) {
+            int checker = ((x + y) % 2) ? 70 : -70;
+            full_a[y * FULL_WIDTH + x] = clamp_luma(full_a[y * FULL_WIDTH + x] + checker);
+            full_b[y * FULL_WIDTH + x] = clamp_luma(full_b[y * FULL_WIDTH + x] - checker);
+        }
+    }
+    float function = function_difference();
+    float legacy = legacy_difference(full_a, full_b);
+    check_crossings(legacy, function);
+    float current = current_difference(full_a, full_b, &result);
+    report("textura de 1 px invertida", legacy, function, current);
+}
+
+// Mudança global de iluminação: as duas métricas acusam a cena inteira acima de 60 níveis
+static void test_global_light(void) {
+    static const int shifts[] = { 40, 80 };
+    compare_result_t result;
+    for (size_t s = 0; s < sizeof(shifts) / sizeof(shifts[0]); s++) {
+        fill_background(full_a, 10);
+        for (size_t i = 0; i < sizeof(full_b); i++) {
+            full_b[i] = clamp_luma(full_a[i] + shifts[s]);
+        }
+        float function = function_difference();
+        float legacy = legacy_difference(full_a, full_b);
+        check_crossings(legacy, function);
+        float current = current_difference(full_a, full_b, &result);
+        char scene[64];
+        snprintf(scene, sizeof(scene), "iluminação +%d", shifts[s]);
+        report(scene, legacy, function, current);
+        CHECK((legacy >= ALERT_THRESHOLD) == (current >= ALERT_THRESHOLD));
+    }
+}
+
+int main(void) {
+    compare_set_engine(COMPARE_ENGINE_SAD);
+
+    printf("| Cena | Calibração (%%) | calculate_image_difference (%%) | Plano reduzido (%%) |\n");
+    printf("|------|-----------------|--------------------------------|--------------------|\n");
+    test_block_grid();
+    test_sensor_noise();
+    test_aligned_objects();
+    test_offset_objects();
+    test_thin_lines();
+    test_fine_texture();
+    test_global_light();
+
+    if (failures) {
+        fprintf(stderr, "test_compare_metric: %d falha(s)\n", failures);
+        return 1;
+    }
+    printf("test_compare_metric: OK\n");
+    return 0;
+}
@@ -0,0 +1,289 @@
+/**
+ * @file test_pipeline.c
+ * @brief Testes no host das filas entre estágios (model/pipeline.c)
+ *
+ * Verifica as duas políticas de descarte, o envio urgente (que não descarta
+ * outro urgente) e que cada item aceito termina exatamente uma vez: entregue
+ * ao consumidor ou devolvido pelo callback on_drop (sem vazamento nem
+ * liberação dupla de handles).
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "pipeline.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define STRESS_ITEMS 2000
+#define URGENT_FIRST 90     // Ids a partir deste são alertas
+
+typedef struct {
+    int id;
+} test_item_t;
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// Registro das liberações feitas pelo callback on_drop
+static int released_ids[STRESS_ITEMS];
+static int released_count = 0;
+static int release_times[STRESS_ITEMS];
+
+static void reset_released(void) {
+    released_count = 0;
+    memset(release_times, 0, sizeof(release_times));
+}
+
+static void release_item(void *item) {
+    int id = ((test_item_t *)item)->id;
+    if (released_count < STRESS_ITEMS) {
+        released_ids[released_count] = id;
+    }
+    released_count++;
+    if (id >= 0 && id < STRESS_ITEMS) {
+        release_times[id]++;
+    }
+}
+
+static bool item_is_urgent(const void *item) {
+    return ((const test_item_t *)item)->id >= URGENT_FIRST;
+}
+
+static void push_id(pipeline_queue_t *q, int id, esp_err_t expected) {
+    test_item_t item = { .id = id };
+    CHECK(pipeline_queue_push(q, &item) == expected);
+}
+
+static int pop_id(pipeline_queue_t *q) {
+    test_item_t item = { .id = -1 };
+    return pipeline_queue_pop(q, &item, 0) ? item.id : -1;
+}
+
+// Filas de teste estáticas: o módulo não tem deinit (as filas do firmware vivem até o reboot)
+static pipeline_queue_t oldest_queue;
+static pipeline_queue_t newest_queue;
+static pipeline_queue_t urgent_queue;
+static pipeline_queue_t protected_queue;
+static pipeline_queue_t all_urgent_queue;
+static pipeline_queue_t waiting_queue;
+
+static void test_invalid_args(void) {
+    pipeline_queue_t q;
+    CHECK(pipeline_queue_init(&q, "inval", 0, sizeof(test_item_t), PIPELINE_DROP_OLDEST, NULL, NULL) == ESP_ERR_INVALID_ARG);
+    CHECK(pipeline_queue_init(&q, "inval", 2, 0, PIPELINE_DROP_OLDEST, NULL, NULL) == ESP_ERR_INVALID_ARG);
+    CHECK(pipeline_queue_init(NULL, "inval", 2, sizeof(test_item_t), PIPELINE_DROP_OLDEST, NULL, NULL) == ESP_ERR_INVALID_ARG);
+}
+
+// Fila cheia com DROP_OLDEST: o item novo sempre entra, os mais antigos são liberados em ordem
+static void test_drop_oldest(void) {
+    pipeline_queue_t *const q = &oldest_queue;
+    reset_released();
+    CHECK(pipeline_queue_init(q, "analyze", 2, sizeof(test_item_t), PIPELINE_DROP_OLDEST, release_item, NULL) == ESP_OK);
+
+    for (int id = 1; id <= 5; id++) {
+        push_id(q, id, ESP_OK);
+    }
+    CHECK(released_count == 3);
+    CHECK(released_ids[0] == 1 && released_ids[1] == 2 && released_ids[2] == 3);
+    CHECK(pop_id(q) == 4);
+    CHECK(pop_id(q) == 5);
+    CHECK(pop_id(q) == -1);
+
+    pipeline_queue_stats_t stats;
+    pipeline_queue_get_stats(q, &stats);
+    CHECK(stats.pushed == 5);
+    CHECK(stats.popped == 2);
+    CHECK(stats.dropped == 3);
+    CHECK(stats.peak_depth == 2);
+    CHECK(stats.depth == 0);
+    CHECK(stats.capacity == 2);
+}
+
+// Fila cheia com DROP_NEWEST: o item novo é recusado e liberado, a ordem aceita se mantém
+static void test_drop_newest(void) {
+    pipeline_queue_t *const q = &newest_queue;
+    reset_released();
+    CHECK(pipeline_queue_init(q, "publish", 2, sizeof(test_item_t), PIPELINE_DROP_NEWEST, release_item, NULL) == ESP_OK);
+
+    push_id(q, 1, ESP_OK);
+    push_id(q, 2, ESP_OK);
+    push_id(q, 3, ESP_ERR_TIMEOUT);
+    push_id(q, 4, ESP_ERR_TIMEOUT);
+    CHECK(released_count == 2);
+    CHECK(released_ids[0] == 3 && released_ids[1] == 4);
+    CHECK(pop_id(q) == 1);
+    CHECK(pop_id(q) == 2);
+
+    pipeline_queue_stats_t stats;
+    pipeline_queue_get_stats(q, &stats);
+    CHECK(stats.pushed == 2);
+    CHECK(stats.popped == 2);
+    CHECK(stats.dropped == 2);
+}
+
+// Envio urgente numa fila DROP_NEWEST cheia: descarta o mais antigo em vez do alerta
+static void test_push_urgent(void) {
+    pipeline_queue_t *const q = &urgent_queue;
+    reset_released();
+    CHECK(pipeline_queue_init(q, "publish", 2, sizeof(test_item_t), PIPELINE_DROP_NEWEST, release_item, NULL) == ESP_OK);
+
+    push_id(q, 1, ESP_OK);
+    push_id(q, 2, ESP_OK);
+    test_item_t alert = { .id = 99 };
+    CHECK(pipeline_queue_push_urgent(q, &alert, 0) == ESP_OK);
+    CHECK(released_count == 1 && released_ids[0] == 1);
+    CHECK(pop_id(q) == 2);
+    CHECK(pop_id(q) == 99);
+
+    // Com espaço, o envio urgente não descarta nada
+    CHECK(pipeline_queue_push_urgent(q, &alert, 0) == ESP_OK);
+    CHECK(released_count == 1);
+
+    pipeline_queue_stats_t stats;
+    pipeline_queue_get_stats(q, &stats);
+    CHECK(stats.pushed == 4);
+    CHECK(stats.dropped == 1);
+    CHECK(stats.depth == 1);
+}
+
+// Envio urgente com alerta na frente: descarta o primeiro não urgente e mantém a ordem dos alertas
+static void test_urgent_keeps_alerts(void) {
+    pipeline_queue_t *const q = &protected_queue;
+    reset_released();
+    CHECK(pipeline_queue_init(q, "publish", 3, sizeof(test_item_t), PIPELINE_DROP_NEWEST, release_item, item_is_urgent) == ESP_OK);
+
+    push_id(q, 97, ESP_OK);
+    push_id(q, 1, ESP_OK);
+    push_id(q, 98, ESP_OK);
+    test_item_t alert = { .id = 99 };
+    CHECK(pipeline_queue_push_urgent(q, &alert, 0) == ESP_OK);
+    CHECK(released_count == 1 && released_ids[0] == 1);
+    CHECK(pop_id(q) == 97);
+    CHECK(pop_id(q) == 98);
+    CHECK(pop_id(q) == 99);
+    CHECK(pop_id(q) == -1);
+}
+
+// Só alertas na fila: sem consumidor, o prazo esgota e o alerta mais antigo cede a vaga
+static void test_urgent_all_alerts(void) {
+    pipeline_queue_t *const q = &all_urgent_queue;
+    reset_released();
+    CHECK(pipeline_queue_init(q, "publish", 2, sizeof(test_item_t), PIPELINE_DROP_NEWEST, release_item, item_is_urgent) == ESP_OK);
+
+    push_id(q, 97, ESP_OK);
+    push_id(q, 98, ESP_OK);
+    test_item_t alert = { .id = 99 };
+    CHECK(pipeline_queue_push_urgent(q, &alert, pdMS_TO_TICKS(20)) == ESP_OK);
+    CHECK(released_count == 1 && released_ids[0] == 97);
+    CHECK(pop_id(q) == 98);
+    CHECK(pop_id(q) == 99);
+}
+
+// Só alertas na fila: o consumidor libera vaga dentro do prazo e nada é descartado
+static void *delayed_pop(void *arg) {
+    usleep(20000);
+    test_item_t item;
+    pipeline_queue_pop((pipeline_queue_t *)arg, &item, portMAX_DELAY);
+    return NULL;
+}
+
+static void test_urgent_waits_for_consumer(void) {
+    pipeline_queue_t *const q = &waiting_queue;
+    reset_released();
+    CHECK(pipeline_queue_init(q, "publish", 2, sizeof(test_item_t), PIPELINE_DROP_NEWEST, release_item, item_is_urgent) == ESP_OK);
+
+    push_id(q, 97, ESP_OK);
+    push_id(q, 98, ESP_OK);
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, delayed_pop, q);
+    test_item_t alert = { .id = 99 };
+    CHECK(pipeline_queue_push_urgent(q, &alert, pdMS_TO_TICKS(2000)) == ESP_OK);
+    pthread_join(consumer, NULL);
+    CHECK(released_count == 0);
+    CHECK(pop_id(q) == 98);
+    CHECK(pop_id(q) == 99);
+}
+
+// Produtor rápido e consumidor lento: cada item termina exatamente uma vez
+static pipeline_queue_t stress_queue;
+static int consume_times[STRESS_ITEMS];
+
+static void *slow_consumer(void *arg) {
+    (void)arg;
+    test_item_t item;
+    while (pipeline_queue_pop(&stress_queue, &item, portMAX_DELAY)) {
+        if (item.id < 0) {
+            break;
+        }
+        if (item.id < STRESS_ITEMS) {
+            consume_times[item.id]++;
+        }
+        usleep(500);
+    }
+    return NULL;
+}
+
+static void test_stress_accounting(void) {
+    reset_released();
+    memset(consume_times, 0, sizeof(consume_times));
+    CHECK(pipeline_queue_init(&stress_queue, "stress", 3, sizeof(test_item_t), PIPELINE_DROP_OLDEST, release_item, NULL) == ESP_OK);
+
+    pthread_t consumer;
+    pthread_create(&consumer, NULL, slow_consumer, NULL);
+    for (int id = 0; id < STRESS_ITEMS; id++) {
+        push_id(&stress_queue, id, ESP_OK);
+        if (id % 8 == 0) {
+            usleep(200);
+        }
+    }
+    test_item_t stop = { .id = -1 };
+    while (pipeline_queue_push_urgent(&stress_queue, &stop, 0) != ESP_OK) {
+    }
+    pthread_join(consumer, NULL);
+
+    // O marcador de parada pode ter descartado itens ainda na fila
+    int lost = 0;
+    int duplicated = 0;
+    for (int id = 0; id < STRESS_ITEMS; id++) {
+        int times = consume_times[id] + release_times[id];
+        lost += (times == 0);
+        duplicated += (times > 1);
+    }
+    CHECK(lost == 0);
+    CHECK(duplicated == 0);
+
+    pipeline_queue_stats_t stats;
+    pipeline_queue_get_stats(&stress_queue, &stats);
+    CHECK(stats.pushed == stats.popped + stats.dropped);
+    CHECK(stats.dropped == (uint32_t)released_count);
+    CHECK(stats.pushed == STRESS_ITEMS + 1);
+    CHECK(stats.peak_depth <= 3);
+    printf("stress: %u aceitos, %u entregues, %u descartados, pico %d\n",
+           stats.pushed, stats.popped, stats.dropped, stats.peak_depth);
+}
+
+int main(void) {
+    test_invalid_args();
+    test_drop_oldest();
+    test_drop_newest();
+    test_push_urgent();
+    test_urgent_keeps_alerts();
+    test_urgent_all_alerts();
+    test_urgent_waits_for_consumer();
+    test_stress_accounting();
+
+    if (failures) {
+        fprintf(stderr, "test_pipeline: %d falha(s)\n", failures);
+        return 1;
+    }
+    printf("test_pipeline: OK\n");
+    return 0;
+}
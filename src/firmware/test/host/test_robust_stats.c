@@ -0,0 +1,172 @@
+/**
+ * @file test_robust_stats.c
+ * @brief Testes no host dos quantis P² das diferenças (model/robust_stats.c)
+ *
+ * Compara mediana, p95, p99 e MAD estimados com os quantis exatos (amostras
+ * ordenadas) em duas distribuições conhecidas: uniforme e exponencial, esta
+ * com a cauda longa típica das diferenças por captura. Verifica também o
+ * valor exato com menos de 5 amostras e a decisão de anomalia.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "robust_stats.h"
+#include "config.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SAMPLES 20000
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static uint32_t rng_state = 12345;
+
+// Uniforme em [0, 1)
+static float next_uniform(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (float)(rng_state >> 8) / 16777216.0f;
+}
+
+static int compare_float(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// Quantil exato (posição mais próxima) de um vetor já ordenado
+static float exact_quantile(const float* sorted, int n, float p) {
+    return sorted[(int)lroundf(p * (n - 1))];
+}
+
+static float exact_mad(const float* sorted, int n) {
+    static float deviations[SAMPLES];
+    float median = exact_quantile(sorted, n, 0.5f);
+    for (int i = 0; i < n; i++) {
+        deviations[i] = fabsf(sorted[i] - median);
+    }
+    qsort(deviations, n, sizeof(float), compare_float);
+    return exact_quantile(deviations, n, 0.5f);
+}
+
+/**
+ * Alimenta os estimadores e confere cada quantil contra o exato
+ * (tolerância relativa ao próprio quantil, com piso absoluto)
+ */
+static void check_distribution(const char* name, float* values, int n, float tolerance) {
+    robust_stats_reset();
+    for (int i = 0; i < n; i++) {
+        robust_stats_add(values[i]);
+    }
+
+    robust_stats_t stats;
+    CHECK(robust_stats_get(&stats) == ESP_OK);
+    CHECK(stats.count == (uint32_t)n);
+
+    qsort(values, n, sizeof(float), compare_float);
+    const float exact[4] = {
+        exact_quantile(values, n, 0.50f),
+        exact_quantile(values, n, 0.95f),
+        exact_quantile(values, n, 0.99f),
+        exact_mad(values, n),
+    };
+    const float estimated[4] = { stats.median, stats.p95, stats.p99, stats.mad };
+    const char* labels[4] = { "mediana", "p95", "p99", "MAD" };
+
+    for (int q = 0; q < 4; q++) {
+        float error = fabsf(estimated[q] - exact[q]);
+        float allowed = fmaxf(tolerance * exact[q], 0.05f);
+        printf("| %s | %s | %.3f | %.3f | %.2f%% |\n", name, labels[q], exact[q], estimated[q],
+               exact[q] > 0.0f ? error / exact[q] * 100.0f : 0.0f);
+        CHECK(error <= allowed);
+    }
+}
+
+static void test_uniform(void) {
+    static float values[SAMPLES];
+    for (int i = 0; i < SAMPLES; i++) {
+        values[i] = next_uniform() * 100.0f;
+    }
+    check_distribution("uniforme 0-100", values, SAMPLES, 0.02f);
+}
+
+static void test_exponential(void) {
+    static float values[SAMPLES];
+    for (int i = 0; i < SAMPLES; i++) {
+        // Média 2%: maioria das capturas quase parada, cauda de mudanças grandes
+        values[i] = -2.0f * logf(1.0f - next_uniform());
+    }
+    check_distribution("exponencial média 2", values, SAMPLES, 0.05f);
+}
+
+// Menos de 5 amostras: valor exato pela posição mais próxima
+static void test_small_counts(void) {
+    p2_quantile_t est;
+    p2_quantile_init(&est, 0.5f);
+    CHECK(p2_quantile_value(&est) == 0.0f);
+
+    p2_quantile_add(&est, 9.0f);
+    CHECK(p2_quantile_value(&est) == 9.0f);
+    p2_quantile_add(&est, 1.0f);
+    p2_quantile_add(&est, 5.0f);
+    CHECK(p2_quantile_value(&est) == 5.0f);
+
+    p2_quantile_init(&est, 0.99f);
+    p2_quantile_add(&est, 3.0f);
+    p2_quantile_add(&est, 7.0f);
+    p2_quantile_add(&est, 1.0f);
+    p2_quantile_add(&est, 4.0f);
+    CHECK(p2_quantile_value(&est) == 7.0f);
+}
+
+static void test_assessment(void) {
+    robust_assessment_t assessment;
+
+    robust_stats_reset();
+    robust_stats_t stats;
+    CHECK(robust_stats_get(&stats) == ESP_ERR_INVALID_STATE);
+
+    // Antes do aquecimento nada é classificado
+    for (int i = 0; i < ROBUST_STATS_WARMUP - 1; i++) {
+        robust_stats_add(1.0f + next_uniform());
+    }
+    robust_stats_assess(50.0f, &assessment);
+    CHECK(!assessment.ready && !assessment.anomalous);
+
+    for (int i = 0; i < 1000; i++) {
+        robust_stats_add(1.0f + next_uniform());
+    }
+    robust_stats_assess(1.5f, &assessment);
+    CHECK(assessment.ready && !assessment.above_p95 && !assessment.anomalous);
+
+    robust_stats_assess(50.0f, &assessment);
+    CHECK(assessment.ready && assessment.above_p99 && assessment.anomalous);
+    CHECK(assessment.robust_z >= ROBUST_ANOMALY_Z);
+
+    // Acima do p99 mas perto da mediana (piso de MAD): não é anomalia
+    robust_stats_assess(2.05f, &assessment);
+    CHECK(assessment.above_p99 && !assessment.anomalous);
+}
+
+int main(void) {
+    printf("| Distribuição | Quantil | Exato | P² | Erro |\n");
+    printf("|--------------|---------|-------|----|------|\n");
+    test_uniform();
+    test_exponential();
+    test_small_counts();
+    test_assessment();
+
+    if (failures) {
+        fprintf(stderr, "test_robust_stats: %d falha(s)\n", failures);
+        return 1;
+    }
+    printf("test_robust_stats: OK\n");
+    return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file test_telemetry_rollup.c
+ * @brief Testes no host dos agregados de telemetria (model/telemetry_rollup.c)
+ *
+ * Verifica os limites das janelas de 1 minuto, 1 hora e 1 dia (a captura
+ * no limite abre a janela seguinte), o conteúdo das janelas fechadas e o
+ * salto do relógio na sincronização SNTP, quando os timestamps passam do
+ * uptime para a época Unix.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "telemetry_rollup.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SYNC_EPOCH 1704067205ULL    // 2024-01-01 00:00:05 UTC
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static rollup_bucket_t closed[ROLLUP_SCALE_COUNT];
+
+static int add(uint64_t timestamp, float difference, bool sent) {
+    rollup_sample_t sample = {
+        .difference = difference,
+        .image_size = 1000,
+        .sent = sent,
+        .free_heap = 100000,
+        .has_rssi = sent,
+        .rssi = -60,
+    };
+    return telemetry_rollup_add(&sample, timestamp, closed);
+}
+
+static const rollup_bucket_t* find_closed(int count, rollup_scale_t scale) {
+    for (int i = 0; i < count; i++) {
+        if (closed[i].scale == scale) return &closed[i];
+    }
+    return NULL;
+}
+
+static void test_minute_boundary(void) {
+    telemetry_rollup_reset();
+    CHECK(add(0, 2.0f, false) == 0);
+    CHECK(add(15, 4.0f, true) == 0);
+    CHECK(add(59, 9.0f, false) == 0);
+
+    // Captura exatamente no limite: fecha [0, 60) e entra na janela nova
+    int count = add(60, 1.0f, false);
+    CHECK(count == 1);
+    const rollup_bucket_t* minute = find_closed(count, ROLLUP_MINUTE);
+    CHECK(minute != NULL);
+    if (!minute) return;
+    CHECK(minute->start == 0 && minute->first == 0 && minute->last == 59);
+
+    const rollup_stat_t* diff = &minute->metrics[ROLLUP_DIFFERENCE];
+    CHECK(diff->count == 3);
+    CHECK(diff->min == 2.0f && diff->max == 9.0f);
+    CHECK(fabsf(telemetry_rollup_mean(diff) - 5.0f) < 1e-5f);
+    CHECK(fabsf(telemetry_rollup_mean(&minute->metrics[ROLLUP_SENT]) - 1.0f / 3.0f) < 1e-5f);
+    // RSSI só das capturas associadas
+    CHECK(minute->metrics[ROLLUP_RSSI].count == 1);
+
+    // Intervalo sem capturas: nenhuma janela vazia é entregue
+    count = add(185, 3.0f, false);
+    CHECK(count == 1);
+    minute = find_closed(count, ROLLUP_MINUTE);
+    CHECK(minute && minute->start == 60 && minute->metrics[ROLLUP_DIFFERENCE].count == 1);
+}
+
+static void test_hour_and_day_boundaries(void) {
+    telemetry_rollup_reset();
+    uint32_t captures = 0;
+    int hours_closed = 0;
+    for (uint64_t t = 0; t < 86400; t += 15) {
+        int count = add(t, 1.0f, false);
+        captures++;
+        const rollup_bucket_t* hour = find_closed(count, ROLLUP_HOUR);
+        if (hour) {
+            hours_closed++;
+            // Hora fechada junto com o último minuto dela
+            CHECK(count == 2 && find_closed(count, ROLLUP_MINUTE) != NULL);
+            CHECK(t % 3600 == 0 && hour->start == t - 3600);
+            CHECK(hour->first == hour->start && hour->last == t - 15);
+            CHECK(hour->metrics[ROLLUP_DIFFERENCE].count == 240);
+        }
+    }
+    CHECK(hours_closed == 23);
+
+    // Meia-noite: as três escalas fecham juntas
+    int count = add(86400, 1.0f, false);
+    CHECK(count == 3);
+    const rollup_bucket_t* day = find_closed(count, ROLLUP_DAY);
+    CHECK(day && day->start == 0 && day->last == 86385);
+    CHECK(day && day->metrics[ROLLUP_DIFFERENCE].count == captures);
+    CHECK(telemetry_rollup_duration(ROLLUP_DAY) == 86400);
+}
+
+// Sincronização SNTP: uptime (segundos desde o boot) salta para a época Unix
+static void test_clock_jump_at_sync(void) {
+    telemetry_rollup_reset();
+    add(100, 2.0f, true);
+    add(115, 4.0f, false);
+
+    int count = add(SYNC_EPOCH, 6.0f, false);
+    CHECK(count == ROLLUP_SCALE_COUNT);
+    for (int s = 0; s < ROLLUP_SCALE_COUNT; s++) {
+        const rollup_bucket_t* bucket = find_closed(count, (rollup_scale_t)s);
+        CHECK(bucket != NULL);
+        if (!bucket) continue;
+        // Janelas do uptime entregues inteiras, sem a amostra já sincronizada
+        CHECK(bucket->first == 100 && bucket->last == 115);
+        CHECK(bucket->metrics[ROLLUP_DIFFERENCE].count == 2);
+        CHECK(bucket->metrics[ROLLUP_DIFFERENCE].max == 4.0f);
+    }
+
+    // Janelas novas alinhadas à época: o minuto fecha em 00:01:00
+    count = add(SYNC_EPOCH + 55, 1.0f, false);
+    CHECK(count == 1);
+    const rollup_bucket_t* minute = find_closed(count, ROLLUP_MINUTE);
+    CHECK(minute && minute->start == SYNC_EPOCH - 5 && minute->first == SYNC_EPOCH);
+    CHECK(minute && minute->metrics[ROLLUP_DIFFERENCE].count == 1);
+
+    // Relógio ajustado para trás (ressincronização): a janela também fecha
+    CHECK(add(SYNC_EPOCH + 600, 1.0f, false) == 1);
+    count = add(SYNC_EPOCH + 500, 1.0f, false);
+    CHECK(count == 1 && closed[0].scale == ROLLUP_MINUTE && closed[0].start == SYNC_EPOCH + 595);
+}
+
+static void test_invalid_args(void) {
+    rollup_sample_t sample = {0};
+    CHECK(telemetry_rollup_add(NULL, 0, closed) == 0);
+    CHECK(telemetry_rollup_add(&sample, 0, NULL) == 0);
+    CHECK(telemetry_rollup_mean(NULL) == 0.0f);
+    CHECK(strcmp(telemetry_rollup_scale_name(ROLLUP_HOUR), "1h") == 0);
+}
+
+int main(void) {
+    test_minute_boundary();
+    test_hour_and_day_boundaries();
+    test_clock_jump_at_sync();
+    test_invalid_args();
+
+    if (failures) {
+        fprintf(stderr, "test_telemetry_rollup: %d falha(s)\n", failures);
+        return 1;
+    }
+    printf("test_telemetry_rollup: OK\n");
+    return 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file test_time_series.c
+ * @brief Testes no host da série temporal deslizante (model/time_series.c)
+ *
+ * Confere média, variância e tendência incrementais contra o recálculo
+ * completo da janela a cada amostra, durante mais de três voltas do anel:
+ * a saída da amostra mais antiga (Welford inverso e deslocamento de Σxy)
+ * e a ressincronização periódica não podem acumular erro.
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+
+#include "time_series.h"
+#include "config.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TOTAL_SAMPLES (TIME_SERIES_WINDOW * 7 / 2)
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "FALHA %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static uint32_t rng_state = 12345;
+
+static float next_uniform(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (float)(rng_state >> 8) / 16777216.0f;
+}
+
+static bool close_to(double value, double expected, double tolerance) {
+    return fabs(value - expected) <= tolerance * fmax(1.0, fabs(expected));
+}
+
+/**
+ * Estatísticas da janela por força bruta (últimas n amostras de history)
+ */
+static void brute_force(const float* history, int end, int n, double* mean, double* variance,
+                        double* slope_per_hour) {
+    const float* window = history + end - n;
+    double sum = 0.0, sum_xy = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += window[i];
+        sum_xy += (double)i * window[i];
+    }
+    *mean = sum / n;
+
+    double sq = 0.0;
+    for (int i = 0; i < n; i++) {
+        double d = window[i] - *mean;
+        sq += d * d;
+    }
+    *variance = sq / (n - 1);
+
+    double sum_x = (double)n * (n - 1) / 2.0;
+    double sum_xx = (double)(n - 1) * n * (2.0 * n - 1) / 6.0;
+    double slope = (n * sum_xy - sum_x * sum) / (n * sum_xx - sum_x * sum_x);
+    *slope_per_hour = slope * (3600000.0 / CAPTURE_INTERVAL_MS);
+}
+
+static void test_sliding_window(void) {
+    static float history[TOTAL_SAMPLES];
+    int mismatches = 0;
+    double worst_slope = 0.0;
+
+    time_series_reset();
+    for (int i = 0; i < TOTAL_SAMPLES; i++) {
+        // Ruído em torno de uma tendência que muda de sinal a cada volta, e um degrau
+        int lap = i / TIME_SERIES_WINDOW;
+        float trend = (lap % 2 ? -1.0f : 1.0f) * (float)(i % TIME_SERIES_WINDOW) * 0.01f;
+        float step = (i % 500) < 20 ? 40.0f : 0.0f;
+        history[i] = 5.0f + trend + step + next_uniform() * 3.0f;
+        time_series_add(history[i]);
+
+        int n = i + 1 < TIME_SERIES_WINDOW ? i + 1 : TIME_SERIES_WINDOW;
+        time_series_stats_t stats;
+        esp_err_t err = time_series_get_stats(&stats);
+        if (n < 2) {
+            CHECK(err == ESP_ERR_INVALID_STATE);
+            continue;
+        }
+
+        double mean, variance, slope;
+        brute_force(history, i + 1, n, &mean, &variance, &slope);
+        bool ok = err == ESP_OK && stats.count == n &&
+                  close_to(stats.mean, mean, 1e-4) &&
+                  close_to(stats.variance, variance, 1e-3) &&
+                  close_to(stats.slope_per_hour, slope, 1e-3);
+        if (!ok) {
+            if (mismatches++ < 5) {
+                fprintf(stderr, "amostra %d (n=%d): média %.5f/%.5f variância %.5f/%.5f tendência %.5f/%.5f\n",
+                        i, n, stats.mean, mean, stats.variance, variance, stats.slope_per_hour, slope);
+            }
+        }
+        worst_slope = fmax(worst_slope, fabs(stats.slope_per_hour - slope));
+    }
+    CHECK(mismatches == 0);
+    printf("test_time_series: %d amostras, janela %d, maior erro de tendência %.2e %%/h\n",
+           TOTAL_SAMPLES, TIME_SERIES_WINDOW, worst_slope);
+}
+
+// Janela constante: variância zero e tendência nula depois de várias voltas
+static void test_constant_after_wrap(void) {
+    time_series_reset();
+    for (int i = 0; i < TIME_SERIES_WINDOW * 2 + 7; i++) {
+        time_series_add(i < TIME_SERIES_WINDOW ? 90.0f : 3.0f);
+    }
+    time_series_stats_t stats;
+    CHECK(time_series_get_stats(&stats) == ESP_OK);
+    CHECK(stats.count == TIME_SERIES_WINDOW);
+    CHECK(close_to(stats.mean, 3.0, 1e-5));
+    CHECK(fabsf(stats.variance) < 1e-3f);
+    CHECK(fabsf(stats.slope_per_hour) < 1e-3f);
+    CHECK(stats.stability_index > 0.999f);
+}
+
+static void test_reset(void) {
+    time_series_add(1.0f);
+    time_series_reset();
+    time_series_stats_t stats;
+    CHECK(time_series_get_stats(&stats) == ESP_ERR_INVALID_STATE);
+    CHECK(stats.count == 0);
+    CHECK(time_series_get_stats(NULL) == ESP_ERR_INVALID_ARG);
+}
+
+int main(void) {
+    if (time_series_init() != ESP_OK) {
+        fprintf(stderr, "test_time_series: falha ao alocar a janela\n");
+        return 1;
+    }
+    test_sliding_window();
+    test_constant_after_wrap();
+    test_reset();
+
+    if (failures) {
+        fprintf(stderr, "test_time_series: %d falha(s)\n", failures);
+        return 1;
+    }
+    printf("test_time_series: OK\n");
+    return 0;
+}
@@ -28,6 +28,7 @@ MQTT_TOPICS = [
     "esp32cam/status",
     "esp32cam/alert", 
     "esp32cam/image",
+    "esp32cam/rollup/#",
     "monitoring/sniffer/stats",
     "monitoring/data"
 ]
@@ -215,6 +216,28 @@ class ScientificMonitor:
                 )
             ''')
             
+            # Tabela de agregados por janela (uma linha por grandeza da janela)
+            cursor.execute('''
+                CREATE TABLE IF NOT EXISTS rollups (
+                    id INTEGER PRIMARY KEY AUTOINCREMENT,
+                    timestamp DATETIME DEFAULT CURRENT_TIMESTAMP,
+                    test_session_id TEXT,
+                    test_name TEXT,
+                    device_id TEXT,
+                    scale TEXT,
+                    window_start INTEGER,
+                    duration_s INTEGER,
+                    first_capture INTEGER,
+                    last_capture INTEGER,
+                    time_synced INTEGER,
+                    metric TEXT,
+                    min_value REAL,
+                    max_value REAL,
+                    mean_value REAL,
+                    sample_count INTEGER
+                )
+            ''')
+            
             # Tabela de sessões de teste para controle
             cursor.execute('''
                 CREATE TABLE IF NOT EXISTS test_sessions (
@@ -274,7 +297,9 @@ class ScientificMonitor:
         simple_score = sum(1 for hint in version_hints['simple'] if hint in data_str)
         
         # Heurísticas específicas por tópico
-        if topic == "esp32cam/image":
+        if topic.startswith("esp32cam/rollup/"):
+            intelligent_score += 3  # Agregados só existem na versão inteligente
+        elif topic == "esp32cam/image":
             if 'reason' in data:
                 reason = data.get('reason', '').lower()
                 if reason in ['periodic', 'first_capture', 'periodic_sample']:
@@ -379,6 +404,9 @@ class ScientificMonitor:
                 
             elif topic == "esp32cam/image":
                 self.handle_image(cursor, data, timestamp, version_to_use, image_dir)
+                
+            elif topic.startswith("esp32cam/rollup/"):
+                self.handle_rollup(cursor, data, timestamp, version_to_use)
             
             conn.commit()
             conn.close()
@@ -477,6 +505,26 @@ class ScientificMonitor:
         
         print(f"🚨 ALERTA {timestamp} - {device_id}: Diferença {difference:.1f}% ({data.get('size', 0)} bytes) [{version.upper()}] [Sessão: {self.test_session}]")
 
+    def handle_rollup(self, cursor, data, timestamp, version):
+        """Processar agregados por janela (1m, 1h, 1d)"""
+        device_id = data.get('device_id', 'unknown')
+        scale = data.get('scale', 'unknown')
+        metrics = data.get('metrics', {})
+        
+        for metric, values in metrics.items():
+            cursor.execute('''
+                INSERT INTO rollups 
+                (test_session_id, test_name, device_id, scale, window_start, duration_s, first_capture, last_capture,
+                 time_synced, metric, min_value, max_value, mean_value, sample_count)
+                VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+            ''', (self.test_session, self.test_name, device_id, scale, data.get('start', 0), data.get('duration', 0),
+                  data.get('first', 0), data.get('last', 0), 1 if data.get('time_synced') else 0, metric,
+                  values.get('min'), values.get('max'), values.get('mean'), values.get('count', 0)))
+        
+        difference = metrics.get('difference', {})
+        print(f"📦 {timestamp} - Agregado {scale}: {difference.get('count', 0)} capturas, "
+              f"diferença média {difference.get('mean', 0.0):.1f}% [{version.upper()}] [Sessão: {self.test_session}]")
+
     def handle_image(self, cursor, data, timestamp, version, image_dir):
         """Processar imagens recebidas"""
         device_id = data.get('device_id', 'unknown')
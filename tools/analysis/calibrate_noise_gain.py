@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+Calibração Ruído x Ganho - ESP32-CAM
+Gera a tabela noise_gain_table.h usada por compare.c a partir de frames arquivados
+
+Estima o desvio-padrão do ruído de cada frame no plano de luminância em
+1/2 escala (mesmo plano do firmware) com o estimador de Immerkær, usando
+apenas os blocos mais homogêneos para que a textura da cena não seja
+confundida com ruído. Os frames são agrupados por oitava de ganho e a
+razão do ruído de cada oitava em relação à menor vira o multiplicador
+(Q8) do piso de ruído e dos limiares por bloco.
+
+Formato do CSV (caminhos relativos ao CSV; ganho = campo "gain" do payload):
+    image,gain
+    received_images/45_esp32_cam_001_unknown.jpg,1.19
+    received_images/391_esp32_cam_001_unknown.jpg,8.5
+
+@author Gabriel Passos - UNESP 2025
+"""
+
+import argparse
+import csv
+import math
+import os
+import sys
+
+try:
+    import numpy as np
+    from PIL import Image
+except ImportError:
+    print("❌ Dependências ausentes: pip3 install numpy pillow")
+    sys.exit(1)
+
+# Parâmetros espelhados de config.h / noise_gain_table.h
+COMPARE_SCALE_SHIFT = 1
+COMPARE_BLOCK_SIZE = 16
+TABLE_SIZE = 6              # Oitavas de ganho: 1x, 2x, 4x, 8x, 16x, 32x
+HOMOGENEOUS_QUANTILE = 25   # Percentil dos blocos usados na estimativa
+MIN_FRAMES_PER_BIN = 3
+
+DEFAULT_OUTPUT = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              "..", "..", "src", "firmware", "main", "model", "noise_gain_table.h")
+
+HEADER_TEMPLATE = """/**
+ * @file noise_gain_table.h
+ * @brief Escala do ruído do sensor em função do ganho analógico
+ *
+ * Gerado por tools/analysis/calibrate_noise_gain.py a partir de frames
+ * arquivados - não editar manualmente. {origin}
+ *
+ * @author Gabriel Passos - UNESP 2025
+ */
+#ifndef NOISE_GAIN_TABLE_H
+#define NOISE_GAIN_TABLE_H
+
+#include <stdint.h>
+
+#define NOISE_GAIN_TABLE_SIZE {size}   // Uma entrada por oitava de ganho: 1x, 2x, 4x, 8x, 16x, 32x
+
+// Multiplicador (Q8, 256 = 1.0) do piso de ruído e dos limiares por bloco
+static const uint16_t noise_gain_scale_q8[NOISE_GAIN_TABLE_SIZE] = {{
+    {values}
+}};
+
+#endif // NOISE_GAIN_TABLE_H
+"""
+
+
+def load_luma_plane(path):
+    """Carrega JPEG em escala reduzida e converte para luminância (mesmos pesos do firmware)"""
+    img = Image.open(path).convert("RGB")
+    img = img.reduce(1 << COMPARE_SCALE_SHIFT)
+    rgb = np.asarray(img, dtype=np.int32)
+    return (rgb[..., 0] * 77 + rgb[..., 1] * 150 + rgb[..., 2] * 29) >> 8
+
+
+def estimate_noise_sigma(plane):
+    """Estimador de Immerkær restrito aos blocos mais homogêneos"""
+    p = plane.astype(np.float64)
+    # Máscara [[1,-2,1],[-2,4,-2],[1,-2,1]] (anula bordas lineares)
+    conv = (p[:-2, :-2] - 2 * p[:-2, 1:-1] + p[:-2, 2:]
+            - 2 * p[1:-1, :-2] + 4 * p[1:-1, 1:-1] - 2 * p[1:-1, 2:]
+            + p[2:, :-2] - 2 * p[2:, 1:-1] + p[2:, 2:])
+    bs = COMPARE_BLOCK_SIZE
+    h = (conv.shape[0] // bs) * bs
+    w = (conv.shape[1] // bs) * bs
+    blocks = np.abs(conv[:h, :w]).reshape(h // bs, bs, w // bs, bs).mean(axis=(1, 3))
+    homogeneous = blocks[blocks <= np.percentile(blocks, HOMOGENEOUS_QUANTILE)]
+    return math.sqrt(math.pi / 2) * homogeneous.mean() / 6.0
+
+
+def gain_bin(gain):
+    return int(min(TABLE_SIZE - 1, max(0, round(math.log2(max(gain, 1.0))))))
+
+
+def build_table(sigmas_by_bin):
+    """Converte o ruído por oitava em multiplicadores Q8 monotônicos"""
+    measured = {b: float(np.median(v)) for b, v in sigmas_by_bin.items() if len(v) >= MIN_FRAMES_PER_BIN}
+    if not measured:
+        return None, measured
+
+    base_bin = min(measured)
+    ratios = [None] * TABLE_SIZE
+    for b, sigma in measured.items():
+        ratios[b] = sigma / measured[base_bin]
+
+    known = [b for b in range(TABLE_SIZE) if ratios[b] is not None]
+    for b in range(TABLE_SIZE):
+        if ratios[b] is not None:
+            continue
+        lower = [k for k in known if k < b]
+        upper = [k for k in known if k > b]
+        if lower and upper:
+            lo, hi = lower[-1], upper[0]
+            ratios[b] = ratios[lo] + (ratios[hi] - ratios[lo]) * (b - lo) / (hi - lo)
+        elif lower:
+            # Extrapolação conservadora: ruído cresce com sqrt(2) por oitava
+            ratios[b] = ratios[lower[-1]] * math.sqrt(2) ** (b - lower[-1])
+        else:
+            ratios[b] = 1.0
+
+    table = []
+    for ratio in ratios:
+        value = int(round(max(1.0, ratio) * 256))
+        table.append(max(value, table[-1] if table else 256))
+    return [min(v, 65535) for v in table], measured
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Calibra a tabela de ruído x ganho do firmware")
+    parser.add_argument("frames", help="CSV com colunas image,gain")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="Header gerado (padrão: firmware)")
+    parser.add_argument("--dry-run", action="store_true", help="Apenas mostrar a tabela")
+    args = parser.parse_args()
+
+    with open(args.frames, newline="") as f:
+        rows = list(csv.DictReader(f))
+    if not rows:
+        print("❌ Nenhum frame encontrado")
+        return 1
+
+    base_dir = os.path.dirname(os.path.abspath(args.frames))
+    sigmas_by_bin = {}
+    for row in rows:
+        gain = float(row["gain"])
+        sigma = estimate_noise_sigma(load_luma_plane(os.path.join(base_dir, row["image"])))
+        sigmas_by_bin.setdefault(gain_bin(gain), []).append(sigma)
+
+    table, measured = build_table(sigmas_by_bin)
+    if table is None:
+        print(f"❌ Nenhuma oitava de ganho com pelo menos {MIN_FRAMES_PER_BIN} frames")
+        return 1
+
+    print(f"📊 {len(rows)} frames calibrados")
+    for b in range(TABLE_SIZE):
+        count = len(sigmas_by_bin.get(b, []))
+        sigma = f"σ={measured[b]:.2f}" if b in measured else "interpolado"
+        print(f"🎚️ Ganho {1 << b:>2}x: {count:>4} frames, {sigma:<12} escala {table[b] / 256:.2f} ({table[b]})")
+
+    if args.dry_run:
+        return 0
+
+    origin = f"Calibrado com {len(rows)} frames."
+    with open(args.output, "w") as f:
+        f.write(HEADER_TEMPLATE.format(origin=origin, size=TABLE_SIZE,
+                                       values=", ".join(str(v) for v in table)))
+    print(f"💾 Tabela salva em {os.path.relpath(args.output)}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
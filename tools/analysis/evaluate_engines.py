@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+Avaliação dos Engines de Comparação - ESP32-CAM
+Concordância dos engines SAD, SSIM e gradiente com eventos rotulados manualmente
+
+Reimplementa em NumPy os engines de `compare.c` (plano de luminância em
+1/2 escala, blocos 16x16, mesmos limiares e filtros de ruído) e mede a
+concordância da decisão "mudança significativa" com os rótulos humanos.
+
+Formato do CSV de rótulos (caminhos relativos ao CSV):
+    reference,current,label
+    received_images/45_esp32_cam_001_unknown.jpg,received_images/60_esp32_cam_001_unknown.jpg,0
+
+@author Gabriel Passos - UNESP 2025
+"""
+
+import argparse
+import csv
+import json
+import os
+import sys
+
+try:
+    import numpy as np
+    from PIL import Image
+except ImportError:
+    print("❌ Dependências ausentes: pip3 install numpy pillow")
+    sys.exit(1)
+
+# Parâmetros espelhados de config.h / compare.c
+COMPARE_SCALE_SHIFT = 1
+COMPARE_BLOCK_SIZE = 16
+BLOCK_DIFF_THRESHOLD = 60
+NOISE_FLOOR = 15
+MIN_SIGNIFICANT_BLOCKS = 3
+SSIM_BLOCK_THRESHOLD = 64
+EDGE_MAGNITUDE_THRESHOLD = 96
+EDGE_DENSITY_THRESHOLD = 40
+CHANGE_THRESHOLD = 8.0
+
+
+def load_luma_plane(path):
+    """Carrega JPEG em escala reduzida e converte para luminância (mesmos pesos do firmware)"""
+    img = Image.open(path).convert("RGB")
+    scale = 1 << COMPARE_SCALE_SHIFT
+    img = img.reduce(scale)
+    rgb = np.asarray(img, dtype=np.int32)
+    return (rgb[..., 0] * 77 + rgb[..., 1] * 150 + rgb[..., 2] * 29) >> 8
+
+
+def blocks(plane):
+    """Reorganiza o plano em (blocos_y, blocos_x, N) pixels"""
+    bs = COMPARE_BLOCK_SIZE
+    h = (plane.shape[0] // bs) * bs
+    w = (plane.shape[1] // bs) * bs
+    p = plane[:h, :w].reshape(h // bs, bs, w // bs, bs).swapaxes(1, 2)
+    return p.reshape(h // bs, w // bs, bs * bs).astype(np.int64)
+
+
+def sad_scores(ref, cur):
+    avg = np.abs(blocks(cur) - blocks(ref)).sum(axis=2) // (COMPARE_BLOCK_SIZE ** 2)
+    avg[avg <= NOISE_FLOOR] = 0
+    return np.minimum(avg, 255), BLOCK_DIFF_THRESHOLD
+
+
+def ssim_scores(ref, cur):
+    x, y = blocks(ref), blocks(cur)
+    n = x.shape[2]
+    sx, sy = x.sum(axis=2), y.sum(axis=2)
+    sxx, syy, sxy = (x * x).sum(axis=2), (y * y).sum(axis=2), (x * y).sum(axis=2)
+    c1 = (65025 * n * n) // 10000
+    c2 = (585225 * n * n) // 10000
+    lum = ((2 * sx * sy + c1) * 65536) // (sx * sx + sy * sy + c1)
+    struct = ((2 * (n * sxy - sx * sy) + c2) * 65536) // ((n * sxx - sx * sx) + (n * syy - sy * sy) + c2)
+    ssim = (lum * struct) // 65536
+    dissim = ((65536 - ssim) * 255) // 131072
+    return np.clip(dissim, 0, 255), SSIM_BLOCK_THRESHOLD
+
+
+def edge_density(plane):
+    """Densidade de bordas Sobel por bloco (0-255), bordas verticais replicadas como no firmware"""
+    p = np.pad(plane.astype(np.int64), ((1, 1), (0, 0)), mode="edge")
+    a, r, b = p[:-2], p[1:-1], p[2:]
+    gx = (a[:, 2:] + 2 * r[:, 2:] + b[:, 2:]) - (a[:, :-2] + 2 * r[:, :-2] + b[:, :-2])
+    gy = (b[:, :-2] + 2 * b[:, 1:-1] + b[:, 2:]) - (a[:, :-2] + 2 * a[:, 1:-1] + a[:, 2:])
+    edges = np.zeros(plane.shape, dtype=np.int64)
+    edges[:, 1:-1] = (np.abs(gx) + np.abs(gy)) > EDGE_MAGNITUDE_THRESHOLD
+    return (blocks(edges).sum(axis=2) * 255) // (COMPARE_BLOCK_SIZE ** 2)
+
+
+def gradient_scores(ref, cur):
+    return np.abs(edge_density(cur) - edge_density(ref)), EDGE_DENSITY_THRESHOLD
+
+
+def change_percentage(scores, threshold):
+    """Mesmos filtros de finalize_change_percentage()"""
+    changed = int((scores > threshold).sum())
+    total = scores.size
+    if changed < MIN_SIGNIFICANT_BLOCKS or total == 0:
+        return 0.0
+    pct = changed / total * 100.0
+    if pct < 3.0:
+        return 0.0
+    if pct < 8.0:
+        pct *= 0.8
+    return pct
+
+
+ENGINES = {
+    "sad": sad_scores,
+    "ssim": ssim_scores,
+    "gradient": gradient_scores,
+}
+
+
+def evaluate(rows, base_dir, threshold):
+    results = {name: {"tp": 0, "fp": 0, "tn": 0, "fn": 0} for name in ENGINES}
+    for row in rows:
+        ref = load_luma_plane(os.path.join(base_dir, row["reference"]))
+        cur = load_luma_plane(os.path.join(base_dir, row["current"]))
+        label = int(row["label"]) != 0
+        for name, engine in ENGINES.items():
+            detected = change_percentage(*engine(ref, cur)) >= threshold
+            key = ("tp" if label else "fp") if detected else ("fn" if label else "tn")
+            results[name][key] += 1
+    return results
+
+
+def summarize(counts):
+    tp, fp, tn, fn = counts["tp"], counts["fp"], counts["tn"], counts["fn"]
+    total = tp + fp + tn + fn
+    agreement = (tp + tn) / total if total else 0.0
+    precision = tp / (tp + fp) if tp + fp else 0.0
+    recall = tp / (tp + fn) if tp + fn else 0.0
+    # Kappa de Cohen: concordância corrigida pelo acaso
+    expected = ((tp + fp) * (tp + fn) + (tn + fn) * (tn + fp)) / (total * total) if total else 0.0
+    kappa = (agreement - expected) / (1 - expected) if expected < 1 else 0.0
+    return {**counts, "agreement": agreement, "precision": precision, "recall": recall, "kappa": kappa}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Concordância dos engines de comparação com eventos rotulados")
+    parser.add_argument("labels", help="CSV com colunas reference,current,label")
+    parser.add_argument("--threshold", type=float, default=CHANGE_THRESHOLD,
+                        help="Percentual mínimo para considerar mudança (padrão: CHANGE_THRESHOLD)")
+    parser.add_argument("--json", help="Salvar relatório em JSON")
+    args = parser.parse_args()
+
+    with open(args.labels, newline="") as f:
+        rows = list(csv.DictReader(f))
+    if not rows:
+        print("❌ Nenhum par rotulado encontrado")
+        return 1
+
+    print(f"📊 Avaliando {len(rows)} pares rotulados (threshold {args.threshold:.1f}%)")
+    results = evaluate(rows, os.path.dirname(os.path.abspath(args.labels)), args.threshold)
+
+    report = {}
+    for name, counts in results.items():
+        summary = summarize(counts)
+        report[name] = summary
+        print(f"🔍 [{name}] concordância {summary['agreement'] * 100:.1f}% | "
+              f"precisão {summary['precision'] * 100:.1f}% | recall {summary['recall'] * 100:.1f}% | "
+              f"kappa {summary['kappa']:.3f} (TP={counts['tp']} FP={counts['fp']} "
+              f"TN={counts['tn']} FN={counts['fn']})")
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2)
+        print(f"💾 Relatório salvo em {args.json}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
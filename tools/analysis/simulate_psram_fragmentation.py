@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""
+Simulação de Fragmentação da PSRAM - ESP32-CAM
+Maior bloco livre da PSRAM ao longo de um soak com o histórico clonado x slab
+
+Reproduz no host a sequência de alocações grandes (> 16 KB, que o
+ESP-IDF coloca na PSRAM) de um ciclo de monitoramento: clones do
+histórico, buffer base64, cópia do cJSON e payload do envio MQTT. O
+alocador é first-fit com coalescência por endereço, uma aproximação do
+heap do ESP-IDF; o valor absoluto difere do dispositivo, mas a
+tendência do maior bloco livre entre as duas estratégias é comparável.
+
+Tamanhos dos JPEGs: distribuição normal (padrão) ou amostrados de um
+diretório de imagens recebidas (--images).
+
+@author Gabriel Passos - UNESP 2025
+"""
+
+import argparse
+import glob
+import json
+import os
+import random
+import sys
+
+# Parâmetros espelhados de config.h
+CAPTURE_INTERVAL_MS = 15000
+HISTORY_BUFFER_SIZE = 3
+MAX_IMAGE_SIZE = 71680
+PSRAM_SIZE = 4 * 1024 * 1024
+CAMERA_FB_COUNT = 2
+CAMERA_FB_SIZE = 480 * 320 * 2 // 5   # Buffers JPEG do driver alocados no boot
+LUMA_PLANE_SIZE = 240 * 160           # Planos reduzidos (referência + histórico)
+FB_HEADER_SIZE = 64                   # camera_fb_t clonado
+
+
+class FirstFitHeap:
+    """Alocador first-fit com lista livre ordenada por endereço"""
+
+    def __init__(self, size):
+        self.free = [(0, size)]
+        self.used = {}
+
+    def malloc(self, size):
+        size = (size + 3) & ~3
+        for i, (addr, length) in enumerate(self.free):
+            if length >= size:
+                if length == size:
+                    del self.free[i]
+                else:
+                    self.free[i] = (addr + size, length - size)
+                self.used[addr] = size
+                return addr
+        return None
+
+    def release(self, addr):
+        size = self.used.pop(addr)
+        self.free.append((addr, size))
+        self.free.sort()
+        merged = []
+        for a, length in self.free:
+            if merged and merged[-1][0] + merged[-1][1] == a:
+                merged[-1] = (merged[-1][0], merged[-1][1] + length)
+            else:
+                merged.append((a, length))
+        self.free = merged
+
+    def largest_free(self):
+        return max((length for _, length in self.free), default=0)
+
+    def total_free(self):
+        return sum(length for _, length in self.free)
+
+
+def jpeg_sizes(args, rng):
+    if args.images:
+        sizes = [os.path.getsize(p) for p in glob.glob(os.path.join(args.images, "*.jpg"))]
+        if not sizes:
+            print(f"❌ Nenhum JPEG em {args.images}")
+            sys.exit(1)
+        while True:
+            yield rng.choice(sizes)
+    while True:
+        yield max(8 * 1024, int(rng.gauss(args.mean_kb, args.std_kb) * 1024))
+
+
+def mqtt_send(heap, jpeg_len):
+    """Picos transitórios de mqtt_send_image_with_info_ext()"""
+    b64 = 4 * ((jpeg_len + 2) // 3) + 1
+    blocks = [heap.malloc(b64), heap.malloc(b64), heap.malloc(b64 + 512)]
+    ok = all(b is not None for b in blocks)
+    for b in blocks:
+        if b is not None:
+            heap.release(b)
+    return ok
+
+
+def simulate(strategy, args):
+    rng = random.Random(args.seed)
+    heap = FirstFitHeap(PSRAM_SIZE)
+
+    # Alocações permanentes do boot
+    for _ in range(CAMERA_FB_COUNT):
+        heap.malloc(CAMERA_FB_SIZE)
+    for _ in range(HISTORY_BUFFER_SIZE + 1):
+        heap.malloc(LUMA_PLANE_SIZE)
+    if strategy == "slab":
+        heap.malloc(HISTORY_BUFFER_SIZE * MAX_IMAGE_SIZE)
+
+    history = [None] * HISTORY_BUFFER_SIZE
+    captures = int(args.hours * 3600 * 1000 / CAPTURE_INTERVAL_MS)
+    sizes = jpeg_sizes(args, rng)
+    lowest = heap.largest_free()
+    failures = oversize = 0
+    samples = []
+
+    for n in range(captures):
+        jpeg_len = next(sizes)
+        slot = n % HISTORY_BUFFER_SIZE
+
+        if strategy == "clone":
+            if history[slot]:
+                for addr in history[slot]:
+                    heap.release(addr)
+            header = heap.malloc(FB_HEADER_SIZE)
+            buf = heap.malloc(jpeg_len)
+            history[slot] = [a for a in (header, buf) if a is not None]
+            failures += header is None or buf is None
+        elif jpeg_len > MAX_IMAGE_SIZE:
+            oversize += 1
+
+        if rng.random() < args.send_ratio:
+            failures += not mqtt_send(heap, jpeg_len)
+
+        lowest = min(lowest, heap.largest_free())
+        if n % max(1, captures // args.samples) == 0:
+            samples.append({"hour": round(n * CAPTURE_INTERVAL_MS / 3.6e6, 2),
+                            "largest_free_kb": heap.largest_free() // 1024})
+
+    return {
+        "captures": captures,
+        "final_largest_free_kb": heap.largest_free() // 1024,
+        "lowest_largest_free_kb": lowest // 1024,
+        "final_total_free_kb": heap.total_free() // 1024,
+        "fragments": len(heap.free),
+        "allocation_failures": failures,
+        "oversize_frames": oversize,
+        "samples": samples,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simula a fragmentação da PSRAM no soak do histórico")
+    parser.add_argument("--hours", type=float, default=24.0, help="Duração simulada (padrão: 24h)")
+    parser.add_argument("--images", help="Diretório com JPEGs recebidos para amostrar tamanhos")
+    parser.add_argument("--mean-kb", type=float, default=38.0, help="Tamanho médio do JPEG em KB")
+    parser.add_argument("--std-kb", type=float, default=12.0, help="Desvio-padrão do JPEG em KB")
+    parser.add_argument("--send-ratio", type=float, default=0.15, help="Fração das capturas enviadas")
+    parser.add_argument("--samples", type=int, default=24, help="Amostras na série temporal")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--json", help="Salvar relatório em JSON")
+    args = parser.parse_args()
+
+    report = {}
+    print(f"📊 Soak simulado de {args.hours:.0f}h ({CAPTURE_INTERVAL_MS / 1000:.0f}s por captura)")
+    for strategy in ("clone", "slab"):
+        result = simulate(strategy, args)
+        report[strategy] = result
+        print(f"🧩 [{strategy}] maior bloco livre: final {result['final_largest_free_kb']} KB, "
+              f"mínimo {result['lowest_largest_free_kb']} KB | livre total {result['final_total_free_kb']} KB "
+              f"em {result['fragments']} fragmentos | falhas {result['allocation_failures']} | "
+              f"frames grandes demais {result['oversize_frames']}")
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2)
+        print(f"💾 Relatório salvo em {args.json}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())